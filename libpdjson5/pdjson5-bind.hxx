@@ -0,0 +1,530 @@
+#ifndef LIBPDJSON5_PDJSON5_BIND_HXX
+#define LIBPDJSON5_PDJSON5_BIND_HXX
+
+// Compile-time binding of JSON objects to C++ structs.
+//
+// The mapping between member names and struct fields is declared once with
+// the PDJSON5_FIELDS() macro (which uses the field names as member names)
+// or by specializing pdjson5::fields directly (which allows arbitrary
+// member names), for example:
+//
+// struct address
+// {
+//   std::string city;
+//   std::optional<std::uint32_t> zip;
+// };
+//
+// struct person
+// {
+//   std::string name;
+//   std::vector<address> addresses;
+// };
+//
+// PDJSON5_FIELDS (address, city, zip)
+//
+// template <>
+// struct pdjson5::fields<person>
+// {
+//   static constexpr auto value = std::make_tuple (
+//     pdjson5::field ("name", &person::name),
+//     pdjson5::field ("addr", &person::addresses));
+// };
+//
+// The values are then read directly into the struct in a single pass over
+// the parsing events without building an intermediate representation:
+//
+// pdjson5::parser p (text);
+// person x (pdjson5::read<person> (p));
+//
+// For each bound struct a perfect hash of its member names is found at
+// compile time and the member name is mapped to the field with a single
+// hash calculation and comparison. Unknown members are skipped (with
+// pdjson_skip()) and missing members leave the corresponding fields
+// unchanged.
+//
+// Besides bound structs, booleans, arithmetic types, std::string,
+// std::optional (with null as nullopt), and std::vector are supported.
+// Support for other types can be added by specializing pdjson5::reader.
+//
+#include <array>
+#include <tuple>
+#include <string>
+#include <vector>
+#include <cstddef>   // size_t
+#include <cstdint>
+#include <utility>   // index_sequence
+#include <optional>
+#include <stdexcept> // runtime_error, invalid_argument, out_of_range
+#include <string_view>
+#include <type_traits>
+
+#include <libpdjson5/pdjson5.hxx>
+
+namespace pdjson5
+{
+  // Thrown if the value does not match the type being read. The location
+  // is that of the offending value.
+  //
+  class bind_error: public std::runtime_error
+  {
+  public:
+    std::uint64_t line;
+    std::uint64_t column;
+
+    bind_error (const parser& p, const std::string& m)
+        : std::runtime_error (m), line (p.line ()), column (p.column ()) {}
+  };
+
+  // Field binding: member name and pointer to data member.
+  //
+  template <typename C, typename M>
+  struct field_binding
+  {
+    std::string_view name;
+    M C::* member;
+  };
+
+  template <typename C, typename M>
+  constexpr field_binding<C, M>
+  field (std::string_view name, M C::* member)
+  {
+    return field_binding<C, M> {name, member};
+  }
+
+  // Struct binding: specialization should contain the static constexpr
+  // value member that is a std::tuple of field bindings.
+  //
+  template <typename T>
+  struct fields;
+
+  // Value reader: specialization should contain the static read() function
+  // that reads the value that starts with the specified (already consumed)
+  // event.
+  //
+  template <typename T, typename = void>
+  struct reader;
+
+  // Read the next value.
+  //
+  template <typename T>
+  void
+  read (parser& p, T& v)
+  {
+    event e (p.next ());
+    reader<T>::read (p, e, v);
+  }
+
+  template <typename T>
+  T
+  read (parser& p)
+  {
+    T v {};
+    read (p, v);
+    return v;
+  }
+
+  namespace detail
+  {
+    inline const char*
+    describe (event e)
+    {
+      switch (e)
+      {
+      case event::done:       return "end of text";
+      case event::object:     return "object";
+      case event::object_end: return "end of object";
+      case event::array:      return "array";
+      case event::array_end:  return "end of array";
+      case event::name:       return "member name";
+      case event::string:     return "string";
+      case event::number:     return "number";
+      case event::true_:      return "true";
+      case event::false_:     return "false";
+      case event::null:       return "null";
+      }
+
+      return "";
+    }
+
+    [[noreturn]] inline void
+    mismatch (const parser& p, const char* expected, event e)
+    {
+      throw bind_error (p,
+                        std::string ("expected ") + expected + " instead of " +
+                        describe (e));
+    }
+
+    // Seeded FNV-1a.
+    //
+    constexpr std::uint32_t
+    hash (std::uint32_t seed, std::string_view s)
+    {
+      std::uint32_t h (2166136261U ^ (seed * 0x9E3779B9U));
+
+      for (char c: s)
+        h = (h ^ static_cast<unsigned char> (c)) * 16777619U;
+
+      return h ^ (h >> 15);
+    }
+
+    constexpr std::size_t
+    ceil2 (std::size_t n)
+    {
+      std::size_t r (1);
+      while (r < n)
+        r *= 2;
+      return r;
+    }
+
+    // Perfect hash table of N names: slots contain the name index plus one
+    // or zero if empty. The hash table size is between 2 and 8 times the
+    // number of names and is chosen together with the seed such that there
+    // are no collisions.
+    //
+    template <std::size_t N>
+    struct name_table
+    {
+      static constexpr std::size_t capacity = ceil2 (N) * 8;
+
+      std::array<std::string_view, N> names {};
+      std::array<std::uint16_t, capacity> slots {};
+      std::uint32_t seed = 0;
+      std::size_t mask = 0;
+
+      static constexpr std::size_t npos = static_cast<std::size_t> (-1);
+
+      constexpr std::size_t
+      find (std::string_view n) const
+      {
+        if constexpr (N == 0)
+          return npos;
+        else
+        {
+          std::size_t i (slots[hash (seed, n) & mask]);
+          return i != 0 && names[i - 1] == n ? i - 1 : npos;
+        }
+      }
+    };
+
+    template <std::size_t N>
+    constexpr name_table<N>
+    make_name_table (const std::array<std::string_view, N>& names)
+    {
+      static_assert (N < 0xFFFF, "too many fields");
+
+      name_table<N> r;
+      r.names = names;
+
+      for (std::size_t i (0); i != N; ++i)
+      {
+        for (std::size_t j (0); j != i; ++j)
+        {
+          if (names[i] == names[j])
+            throw std::invalid_argument ("duplicate member name");
+        }
+      }
+
+      if constexpr (N != 0)
+      {
+        for (std::size_t size (ceil2 (N) * 2); size <= r.capacity; size *= 2)
+        {
+          for (std::uint32_t seed (0); seed != 256; ++seed)
+          {
+            r.slots = {};
+
+            std::size_t i (0);
+            for (; i != N; ++i)
+            {
+              std::uint16_t& s (r.slots[hash (seed, names[i]) & (size - 1)]);
+
+              if (s != 0)
+                break;
+
+              s = static_cast<std::uint16_t> (i + 1);
+            }
+
+            if (i == N)
+            {
+              r.seed = seed;
+              r.mask = size - 1;
+              return r;
+            }
+          }
+        }
+
+        throw std::invalid_argument ("unable to find perfect hash");
+      }
+
+      return r;
+    }
+
+    template <typename T>
+    struct binding
+    {
+      using tuple = std::remove_const_t<decltype (fields<T>::value)>;
+
+      static constexpr std::size_t size = std::tuple_size_v<tuple>;
+
+      template <std::size_t... I>
+      static constexpr std::array<std::string_view, size>
+      names (std::index_sequence<I...>)
+      {
+        return {{std::get<I> (fields<T>::value).name...}};
+      }
+
+      static constexpr name_table<size> table =
+        make_name_table (names (std::make_index_sequence<size> ()));
+
+      using read_function = void (*) (parser&, event, T&);
+
+      template <std::size_t I>
+      static void
+      read_field (parser& p, event e, T& v)
+      {
+        constexpr auto f (std::get<I> (fields<T>::value));
+        using M = std::remove_reference_t<decltype (v.*f.member)>;
+        reader<M>::read (p, e, v.*f.member);
+      }
+
+      template <std::size_t... I>
+      static constexpr std::array<read_function, size>
+      readers (std::index_sequence<I...>)
+      {
+        return {{&read_field<I>...}};
+      }
+
+      static constexpr std::array<read_function, size> read_functions =
+        readers (std::make_index_sequence<size> ());
+    };
+
+    template <typename T, typename = void>
+    struct has_fields: std::false_type {};
+
+    template <typename T>
+    struct has_fields<T, std::void_t<decltype (fields<T>::value)>>
+      : std::true_type {};
+  }
+
+  // Return the index of the field bound to the member name in the
+  // fields<T>::value tuple or -1 if there is none.
+  //
+  template <typename T>
+  constexpr std::size_t
+  field_index (std::string_view name)
+  {
+    return detail::binding<T>::table.find (name);
+  }
+
+  template <typename T>
+  struct reader<T, std::enable_if_t<detail::has_fields<T>::value>>
+  {
+    static void
+    read (parser& p, event e, T& v)
+    {
+      using binding = detail::binding<T>;
+
+      if (e != event::object)
+        detail::mismatch (p, "object", e);
+
+      // Note that unread values (of unknown members) are skipped by the
+      // members() iterator.
+      //
+      for (std::string_view n: p.members ())
+      {
+        std::size_t i (binding::table.find (n));
+
+        if (i != binding::table.npos)
+          binding::read_functions[i] (p, p.next (), v);
+      }
+    }
+  };
+
+  template <>
+  struct reader<bool>
+  {
+    static void
+    read (parser& p, event e, bool& v)
+    {
+      if (e != event::true_ && e != event::false_)
+        detail::mismatch (p, "boolean", e);
+
+      v = e == event::true_;
+    }
+  };
+
+  template <typename T>
+  struct reader<T, std::enable_if_t<std::is_arithmetic_v<T> &&
+                                    !std::is_same_v<T, bool>>>
+  {
+    static void
+    read (parser& p, event e, T& v)
+    {
+      if (e != event::number)
+        detail::mismatch (p, "number", e);
+
+      try
+      {
+        v = p.number<T> ();
+      }
+      catch (const std::invalid_argument& x)
+      {
+        throw bind_error (p, x.what ());
+      }
+      catch (const std::out_of_range& x)
+      {
+        throw bind_error (p, x.what ());
+      }
+    }
+  };
+
+  template <>
+  struct reader<std::string>
+  {
+    static void
+    read (parser& p, event e, std::string& v)
+    {
+      if (e != event::string)
+        detail::mismatch (p, "string", e);
+
+      v = p.value ();
+    }
+  };
+
+  template <typename T>
+  struct reader<std::optional<T>>
+  {
+    static void
+    read (parser& p, event e, std::optional<T>& v)
+    {
+      if (e == event::null)
+        v = std::nullopt;
+      else
+        reader<T>::read (p, e, v.emplace ());
+    }
+  };
+
+  template <typename T, typename A>
+  struct reader<std::vector<T, A>>
+  {
+    static void
+    read (parser& p, event e, std::vector<T, A>& v)
+    {
+      if (e != event::array)
+        detail::mismatch (p, "array", e);
+
+      v.clear ();
+
+      for (event e: p.elements ())
+        reader<T>::read (p, e, v.emplace_back ());
+    }
+  };
+}
+
+// Bind the struct fields to members with the same names, for example:
+//
+// PDJSON5_FIELDS (person, name, age)
+//
+// Note that this macro should be used in the global namespace and the
+// number of fields is limited to 32 (specialize pdjson5::fields directly
+// for more).
+//
+#define PDJSON5_FIELDS(T, ...)                                            \
+  template <>                                                             \
+  struct pdjson5::fields<T>                                               \
+  {                                                                       \
+    static constexpr auto value = std::make_tuple (                      \
+      PDJSON5_FOR_EACH_ (PDJSON5_FIELD_, T, __VA_ARGS__));                \
+  };
+
+#define PDJSON5_FIELD_(T, m) ::pdjson5::field (#m, &T::m)
+
+// Apply F(T, x) to each argument separating the results with commas. Note
+// that the PDJSON5_EXPAND_() indirection is required by the MSVC traditional
+// preprocessor.
+//
+#define PDJSON5_EXPAND_(x) x
+
+#define PDJSON5_FOR_EACH_(F, T, ...)                                      \
+  PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_N_ (__VA_ARGS__,                      \
+    PDJSON5_FOR_EACH_32, PDJSON5_FOR_EACH_31, PDJSON5_FOR_EACH_30,        \
+    PDJSON5_FOR_EACH_29, PDJSON5_FOR_EACH_28, PDJSON5_FOR_EACH_27,        \
+    PDJSON5_FOR_EACH_26, PDJSON5_FOR_EACH_25, PDJSON5_FOR_EACH_24,        \
+    PDJSON5_FOR_EACH_23, PDJSON5_FOR_EACH_22, PDJSON5_FOR_EACH_21,        \
+    PDJSON5_FOR_EACH_20, PDJSON5_FOR_EACH_19, PDJSON5_FOR_EACH_18,        \
+    PDJSON5_FOR_EACH_17, PDJSON5_FOR_EACH_16, PDJSON5_FOR_EACH_15,        \
+    PDJSON5_FOR_EACH_14, PDJSON5_FOR_EACH_13, PDJSON5_FOR_EACH_12,        \
+    PDJSON5_FOR_EACH_11, PDJSON5_FOR_EACH_10, PDJSON5_FOR_EACH_9,         \
+    PDJSON5_FOR_EACH_8, PDJSON5_FOR_EACH_7, PDJSON5_FOR_EACH_6,           \
+    PDJSON5_FOR_EACH_5, PDJSON5_FOR_EACH_4, PDJSON5_FOR_EACH_3,           \
+    PDJSON5_FOR_EACH_2, PDJSON5_FOR_EACH_1) (F, T, __VA_ARGS__))
+
+#define PDJSON5_FOR_EACH_N_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, \
+                            _12, _13, _14, _15, _16, _17, _18, _19, _20,  \
+                            _21, _22, _23, _24, _25, _26, _27, _28, _29,  \
+                            _30, _31, _32, N, ...) N
+
+#define PDJSON5_FOR_EACH_1(F, T, x) F (T, x)
+#define PDJSON5_FOR_EACH_2(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_1 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_3(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_2 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_4(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_3 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_5(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_4 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_6(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_5 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_7(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_6 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_8(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_7 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_9(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_8 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_10(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_9 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_11(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_10 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_12(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_11 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_13(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_12 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_14(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_13 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_15(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_14 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_16(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_15 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_17(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_16 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_18(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_17 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_19(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_18 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_20(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_19 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_21(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_20 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_22(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_21 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_23(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_22 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_24(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_23 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_25(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_24 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_26(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_25 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_27(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_26 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_28(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_27 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_29(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_28 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_30(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_29 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_31(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_30 (F, T, __VA_ARGS__))
+#define PDJSON5_FOR_EACH_32(F, T, x, ...) \
+  F (T, x), PDJSON5_EXPAND_ (PDJSON5_FOR_EACH_31 (F, T, __VA_ARGS__))
+
+#endif // LIBPDJSON5_PDJSON5_BIND_HXX
@@ -0,0 +1,458 @@
+#include <libpdjson5/pdjson5-index.h>
+
+#include <string.h> // str*(), mem*()
+
+#include <libpdjson5/pdjson5-internal.h>
+
+typedef struct pdjson_index_entry entry;
+
+#define NO_ENTRY UINT64_MAX
+
+// Sidecar file header.
+//
+static const char magic[8] = {'P', 'D', 'J', 'S', 'O', 'N', 'I', 'X'};
+#define VERSION 1
+
+struct header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t depth;
+  uint64_t entries_size;
+  uint64_t children_size;
+  uint64_t names_size;
+};
+
+// Copy the member name (including the trailing `\0`) to the end of the names
+// pool without adding it. Return false if out of memory.
+//
+static bool
+stage_name (pdjson_index *x, const char *v, size_t n)
+{
+  if (!index_grow (x,
+                   (void **)&x->names,
+                   &x->names_capacity,
+                   x->names_size,
+                   n,
+                   1))
+    return false;
+
+  memcpy (x->names + x->names_size, v, n);
+  return true;
+}
+
+// Group the children entries by their parent.
+//
+static bool
+link_children (pdjson_index *x)
+{
+  size_t n = x->entries_size;
+
+  if (n < 2)
+    return true;
+
+  if (!index_grow (x,
+                   (void **)&x->children,
+                   &x->children_capacity,
+                   0,
+                   n - 1,
+                   sizeof (uint64_t)))
+    return false;
+
+  x->children_size = n - 1;
+
+  // Count the children and assign the offsets.
+  //
+  for (size_t i = 1; i != n; ++i)
+    x->entries[x->entries[i].parent].children_count++;
+
+  uint64_t o = 0;
+  for (size_t i = 0; i != n; ++i)
+  {
+    entry *e = x->entries + i;
+    e->children = o;
+    o += e->children_count;
+    e->children_count = 0;
+  }
+
+  // Fill the children in the document order.
+  //
+  for (size_t i = 1; i != n; ++i)
+  {
+    entry *p = x->entries + x->entries[i].parent;
+    x->children[p->children + p->children_count++] = i;
+  }
+
+  return true;
+}
+
+bool
+pdjson_index_build (pdjson_index *x, pdjson_stream *json, size_t depth)
+{
+  memset (x, 0, sizeof (*x));
+
+  x->alloc = json->alloc;
+  x->alloc_data = json->alloc_data;
+  x->depth = depth;
+
+  size_t d = 0;           // Number of open containers.
+  uint64_t c = NO_ENTRY;  // Innermost indexed open container.
+  size_t name_size = 0;   // Staged name size of the current member.
+
+  for (;;)
+  {
+    enum pdjson_type t = pdjson_next (json);
+
+    switch (t)
+    {
+    case PDJSON_ERROR:
+      return false;
+    case PDJSON_DONE:
+      return link_children (x);
+    case PDJSON_NAME:
+      {
+        // Stage the name if the member value can be indexed. It is only
+        // added to the names pool if the value turns out to be a container
+        // (see below).
+        //
+        if (d <= depth)
+        {
+          const char *v = pdjson_get_name (json, &name_size);
+
+          if (!stage_name (x, v, name_size))
+            return false;
+        }
+
+        continue;
+      }
+    case PDJSON_OBJECT_END:
+    case PDJSON_ARRAY_END:
+      {
+        if (--d <= depth)
+          c = x->entries[c].parent;
+
+        continue;
+      }
+    default:
+      break;
+    }
+
+    // A value. If the parent is indexed, then it is the innermost indexed
+    // container.
+    //
+    uint64_t key = 0;
+    bool named = false;
+    if (d != 0 && d - 1 <= depth)
+    {
+      entry *p = x->entries + c;
+      named = p->type == PDJSON_OBJECT;
+      key = named ? x->names_size : p->count;
+      p->count++;
+    }
+
+    if (t == PDJSON_OBJECT || t == PDJSON_ARRAY)
+    {
+      if (d <= depth)
+      {
+        if (!index_grow (x,
+                         (void **)&x->entries,
+                         &x->entries_capacity,
+                         x->entries_size,
+                         1,
+                         sizeof (entry)))
+          return false;
+
+        entry *e = x->entries + x->entries_size;
+
+        e->position = pdjson_get_position (json) - 1;
+        e->line = pdjson_get_line (json);
+        e->column = pdjson_get_column (json);
+        e->count = 0;
+        e->key = key;
+        e->parent = c;
+        e->children = 0;
+        e->children_count = 0;
+        e->type = (uint32_t)t;
+        e->depth = (uint32_t)d;
+
+        if (named)
+          x->names_size += name_size;
+
+        c = x->entries_size++;
+      }
+
+      d++;
+    }
+  }
+}
+
+bool
+pdjson_index_write (pdjson_index *x, FILE *f)
+{
+  struct header h;
+  memcpy (h.magic, magic, sizeof (magic));
+  h.version = VERSION;
+  h.depth = (uint32_t)x->depth;
+  h.entries_size = x->entries_size;
+  h.children_size = x->children_size;
+  h.names_size = x->names_size;
+
+  if (!array_write (&h, sizeof (h), 1, f)                              ||
+      !array_write (x->entries, sizeof (entry), x->entries_size, f)       ||
+      !array_write (x->children, sizeof (uint64_t), x->children_size, f) ||
+      !array_write (x->names, 1, x->names_size, f)                        ||
+      fflush (f) != 0)
+  {
+    index_error (x, "%s", "unable to write index");
+    return false;
+  }
+
+  return true;
+}
+
+// Verify that the entries loaded from the file are consistent so that the
+// lookup functions don't have to.
+//
+static bool
+verify (const pdjson_index *x)
+{
+  if (x->names_size != 0 && x->names[x->names_size - 1] != '\0')
+    return false;
+
+  for (size_t i = 0; i != x->entries_size; ++i)
+  {
+    const entry *e = x->entries + i;
+
+    if ((e->type != PDJSON_OBJECT && e->type != PDJSON_ARRAY) ||
+        (i == 0 ? e->parent != NO_ENTRY : e->parent >= i)    ||
+        e->children > x->children_size                       ||
+        e->children_count > x->children_size - e->children)
+      return false;
+
+    if (i != 0 &&
+        x->entries[e->parent].type == PDJSON_OBJECT &&
+        e->key >= x->names_size)
+      return false;
+  }
+
+  for (size_t i = 0; i != x->children_size; ++i)
+  {
+    if (x->children[i] == 0 || x->children[i] >= x->entries_size)
+      return false;
+  }
+
+  return true;
+}
+
+bool
+pdjson_index_read (pdjson_index *x,
+                   FILE *f,
+                   const pdjson_allocator *alloc,
+                   void *data)
+{
+  memset (x, 0, sizeof (*x));
+
+  if (alloc != NULL)
+  {
+    x->alloc = *alloc;
+    x->alloc_data = data;
+  }
+
+  struct header h;
+  if (!index_header_read (x, &h, magic, VERSION, f))
+    return false;
+
+  if (h.entries_size > SIZE_MAX / sizeof (entry)     ||
+      h.children_size > SIZE_MAX / sizeof (uint64_t) ||
+      (uint64_t)(size_t)h.names_size != h.names_size)
+  {
+    index_error (x, "%s", "index is too large");
+    return false;
+  }
+
+  x->depth = h.depth;
+
+  size_t es = (size_t)h.entries_size * sizeof (entry);
+  size_t cs = (size_t)h.children_size * sizeof (uint64_t);
+  size_t ns = (size_t)h.names_size;
+
+  if ((es != 0 &&
+       (x->entries = (entry *)index_allocate (x, es)) == NULL)     ||
+      (cs != 0 &&
+       (x->children = (uint64_t *)index_allocate (x, cs)) == NULL) ||
+      (ns != 0 &&
+       (x->names = (char *)index_allocate (x, ns)) == NULL))
+  {
+    index_error (x, "%s", "out of memory");
+    return false;
+  }
+
+  x->entries_size = x->entries_capacity = (size_t)h.entries_size;
+  x->children_size = x->children_capacity = (size_t)h.children_size;
+  x->names_size = x->names_capacity = (size_t)h.names_size;
+
+  if (!array_read (x->entries, sizeof (entry), x->entries_size, f)       ||
+      !array_read (x->children, sizeof (uint64_t), x->children_size, f) ||
+      !array_read (x->names, 1, x->names_size, f))
+  {
+    index_error (x, "%s", "unable to read index");
+    return false;
+  }
+
+  if (!verify (x))
+  {
+    index_error (x, "%s", "invalid index");
+    return false;
+  }
+
+  return true;
+}
+
+const char *
+pdjson_index_get_error (const pdjson_index *x)
+{
+  return x->error_message[0] != '\0' ? x->error_message : NULL;
+}
+
+void
+pdjson_index_free (pdjson_index *x)
+{
+  index_release (x, x->entries, x->entries_capacity, sizeof (entry));
+  index_release (x, x->children, x->children_capacity, sizeof (uint64_t));
+  index_release (x, x->names, x->names_capacity, 1);
+
+  x->entries = NULL;
+  x->children = NULL;
+  x->names = NULL;
+}
+
+const char *
+pdjson_index_get_name (const pdjson_index *x, const entry *e)
+{
+  return (e->parent != NO_ENTRY &&
+          x->entries[e->parent].type == PDJSON_OBJECT
+          ? x->names + e->key
+          : NULL);
+}
+
+// Find the indexed element of the array given the reference token or return
+// NULL if there is no such element.
+//
+static const entry *
+find_element (const pdjson_index *x, const entry *a, const char *t, size_t n)
+{
+  // Array index without leading zeros.
+  //
+  if (n == 0 || (t[0] == '0' && n != 1))
+    return NULL;
+
+  uint64_t k = 0;
+  for (size_t i = 0; i != n; ++i)
+  {
+    if (t[i] < '0' || t[i] > '9' || k > (UINT64_MAX - 9) / 10)
+      return NULL;
+
+    k = k * 10 + (uint64_t)(t[i] - '0');
+  }
+
+  // The children are in the element order.
+  //
+  const uint64_t *cs = x->children + a->children;
+  size_t b = 0, e = (size_t)a->children_count;
+  while (b != e)
+  {
+    size_t m = b + (e - b) / 2;
+    const entry *c = x->entries + cs[m];
+
+    if (c->key == k)
+      return c;
+
+    if (c->key < k)
+      b = m + 1;
+    else
+      e = m;
+  }
+
+  return NULL;
+}
+
+// Compare the member name to the reference token with the `~0` and `~1`
+// escape sequences.
+//
+static bool
+match_name (const char *v, const char *t, size_t n)
+{
+  for (size_t i = 0; i != n; ++i, ++v)
+  {
+    char c = t[i];
+
+    if (c == '~')
+      c = t[++i] == '0' ? '~' : '/';
+
+    if (*v != c)
+      return false;
+  }
+
+  return *v == '\0';
+}
+
+static const entry *
+find_member (const pdjson_index *x, const entry *o, const char *t, size_t n)
+{
+  const uint64_t *cs = x->children + o->children;
+  for (size_t i = 0; i != o->children_count; ++i)
+  {
+    const entry *c = x->entries + cs[i];
+
+    if (match_name (x->names + c->key, t, n))
+      return c;
+  }
+
+  return NULL;
+}
+
+const entry *
+pdjson_index_find (const pdjson_index *x, const char *p, const char **rest)
+{
+  if (x->entries_size == 0 || (*p != '\0' && *p != '/'))
+    return NULL;
+
+  for (const char *q = p; *q != '\0'; ++q)
+  {
+    if (*q == '~' && q[1] != '0' && q[1] != '1')
+      return NULL;
+  }
+
+  const entry *e = x->entries;
+  while (*p == '/')
+  {
+    const char *t = p + 1;
+    size_t n = strcspn (t, "/");
+
+    const entry *c = e->type == PDJSON_ARRAY
+      ? find_element (x, e, t, n)
+      : find_member (x, e, t, n);
+
+    if (c == NULL)
+      break;
+
+    e = c;
+    p = t + n;
+  }
+
+  *rest = p;
+  return e;
+}
+
+void
+pdjson_index_open_buffer (pdjson_stream *json,
+                          const void *buffer,
+                          size_t size,
+                          const entry *e)
+{
+  size_t p = e->position < size ? (size_t)e->position : size;
+
+  pdjson_open_buffer (json, (const char *)buffer + p, size - p);
+  pdjson_set_streaming (json, true);
+  pdjson_set_location (json, p, e->line, e->column);
+}
@@ -0,0 +1,143 @@
+#ifndef LIBPDJSON5_PDJSON5_INDEX_H
+#define LIBPDJSON5_PDJSON5_INDEX_H
+
+#include <libpdjson5/pdjson5.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+// Subtree index for random access into large documents.
+//
+// The index is built by scanning the document once and records the
+// location (position, line, and column) and the number of elements or
+// members of every array and object down to the specified depth (with the
+// top-level value being at depth 0). The index can then be saved into a
+// sidecar file and later used to start parsing at one of the indexed
+// containers, for example, the one identified by a JSON pointer such as
+// /items/1500000, without parsing the document from the beginning.
+//
+typedef struct pdjson_index pdjson_index;
+
+struct pdjson_index_entry
+{
+  uint64_t position; // Position of the opening bracket or brace.
+  uint64_t line;
+  uint64_t column;
+  uint64_t count;    // Number of elements or members.
+
+  // Element index in the parent array or member name offset in the parent
+  // object (see pdjson_index_get_name()). Zero for the top-level value.
+  //
+  uint64_t key;
+
+  uint64_t parent;         // Parent entry or UINT64_MAX for the top-level.
+  uint64_t children;       // First indexed child offset in the children.
+  uint64_t children_count; // Number of indexed children.
+
+  uint32_t type;  // PDJSON_OBJECT or PDJSON_ARRAY.
+  uint32_t depth;
+};
+
+// Build the index from the next value in the stream recording containers
+// down to the specified depth. The index memory is allocated with the
+// stream's allocator. Return false on error, in which case the error is
+// either described by pdjson_index_get_error() or, if it returns NULL, it
+// is a parsing error as described by pdjson_get_error(). In case of an
+// error the index should still be freed.
+//
+// Note that the entries are in the document order with the top-level value,
+// if it is a container, being the first entry.
+//
+LIBPDJSON5_SYMEXPORT bool
+pdjson_index_build (pdjson_index *index, pdjson_stream *json, size_t depth);
+
+// Save the index into or load the index from a sidecar file. Note that the
+// index is saved in the native byte order and can only be loaded on the
+// same architecture. The allocator used to load the index can be NULL.
+// Return false on error, in which case the error is described by
+// pdjson_index_get_error() and, for pdjson_index_read(), the index should
+// still be freed.
+//
+LIBPDJSON5_SYMEXPORT bool
+pdjson_index_write (pdjson_index *index, FILE *file);
+
+LIBPDJSON5_SYMEXPORT bool
+pdjson_index_read (pdjson_index *index,
+                   FILE *file,
+                   const pdjson_allocator *allocator,
+                   void *user_data);
+
+LIBPDJSON5_SYMEXPORT const char *
+pdjson_index_get_error (const pdjson_index *index);
+
+LIBPDJSON5_SYMEXPORT void
+pdjson_index_free (pdjson_index *index);
+
+// Return the member name of the entry in an object or NULL if the parent is
+// not an object.
+//
+LIBPDJSON5_SYMEXPORT const char *
+pdjson_index_get_name (const pdjson_index *index,
+                       const struct pdjson_index_entry *entry);
+
+// Find the deepest indexed container on the path identified by the JSON
+// pointer (RFC 6901) and set rest to the remainder of the pointer that is
+// relative to the returned container (empty string if the pointer
+// identifies the container itself). Return NULL if the top-level value is
+// not a container or if the pointer is invalid.
+//
+// Note that the remainder may identify a value that does not exist.
+//
+LIBPDJSON5_SYMEXPORT const struct pdjson_index_entry *
+pdjson_index_find (const pdjson_index *index,
+                   const char *pointer,
+                   const char **rest);
+
+// Open the parser in the streaming mode for the indexed container in the
+// buffer containing the entire document with the parser reporting the same
+// locations as would parsing the entire document. The container is parsed
+// as a single value with the first PDJSON_DONE event indicating its end.
+// Note that the language, if other than JSON, should be set after calling
+// this function.
+//
+LIBPDJSON5_SYMEXPORT void
+pdjson_index_open_buffer (pdjson_stream *json,
+                          const void *buffer,
+                          size_t size,
+                          const struct pdjson_index_entry *entry);
+
+// Private.
+//
+struct pdjson_index
+{
+  struct pdjson_index_entry *entries;
+  size_t entries_size;
+  size_t entries_capacity;
+
+  // Indexed children entries grouped by their parent.
+  //
+  uint64_t *children;
+  size_t children_size;
+  size_t children_capacity;
+
+  // Member names referenced by the entries.
+  //
+  char *names;
+  size_t names_size;
+  size_t names_capacity;
+
+  size_t depth;
+
+  struct pdjson_allocator alloc;
+  void *alloc_data;
+
+  char error_message[128];
+};
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // LIBPDJSON5_PDJSON5_INDEX_H
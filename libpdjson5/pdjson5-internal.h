@@ -0,0 +1,165 @@
+#ifndef LIBPDJSON5_PDJSON5_INTERNAL_H
+#define LIBPDJSON5_PDJSON5_INTERNAL_H
+
+// Utilities shared by the library implementation files. Note that this
+// header is internal and is not installed.
+//
+
+#ifndef LIBPDJSON5_PDJSON5_H
+#  include "pdjson5.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h> // malloc()/realloc()/free()
+#include <string.h> // mem*()
+
+// FNV-1a hash of n bytes continuing from h. Start with FNV1A_BASIS.
+//
+#define FNV1A_BASIS 14695981039346656037ULL
+
+static inline uint64_t
+fnv1a (uint64_t h, const void *v, size_t n)
+{
+  const unsigned char *p = (const unsigned char *)v;
+  for (size_t i = 0; i != n; ++i)
+    h = (h ^ p[i]) * 1099511628211ULL;
+  return h;
+}
+
+// Allocate/reallocate/free memory using the allocator if one is specified
+// (alloc->malloc is not NULL) and the standard functions otherwise.
+//
+static inline void *
+array_allocate (const pdjson_allocator *alloc, void *data, size_t n)
+{
+  return alloc->malloc == NULL
+    ? malloc (n)
+    : alloc->malloc (n, data); // THROW
+}
+
+// Make sure there is space for n more elements in the array growing it if
+// necessary. Return false if out of memory.
+//
+static inline bool
+array_grow (const pdjson_allocator *alloc,
+            void *data,
+            void **array,
+            size_t *capacity,
+            size_t size,
+            size_t n,
+            size_t element)
+{
+  if (*capacity - size >= n)
+    return true;
+
+  size_t c = *capacity == 0 ? 64 : *capacity;
+  while (c - size < n)
+  {
+    if (c > SIZE_MAX / element / 2)
+      return false;
+
+    c *= 2;
+  }
+
+  void *a = alloc->malloc == NULL
+    ? realloc (*array, c * element)
+    : alloc->realloc (*array, c * element, data); // THROW
+
+  if (a == NULL)
+    return false;
+
+  *array = a;
+  *capacity = c;
+  return true;
+}
+
+static inline void
+array_release (const pdjson_allocator *alloc,
+               void *data,
+               void *array,
+               size_t capacity,
+               size_t element)
+{
+  if (array == NULL)
+    return;
+
+  if (alloc->malloc == NULL)
+    free (array);
+  else
+    alloc->free (array, capacity * element, data);
+}
+
+// Write/read the array of n elements (which can be NULL if n is 0).
+//
+static inline bool
+array_write (const void *a, size_t element, size_t n, FILE *f)
+{
+  return n == 0 || fwrite (a, element, n, f) == n;
+}
+
+static inline bool
+array_read (void *a, size_t element, size_t n, FILE *f)
+{
+  return n == 0 || fread (a, element, n, f) == n;
+}
+
+// Read the sidecar index file header of the specified size that starts
+// with the 8-byte magic followed by the 32-bit version and verify that they
+// match. Return false and set the error message if that's not the case.
+//
+static inline bool
+header_read (void *h,
+             size_t size,
+             const char *magic,
+             uint32_t version,
+             FILE *f,
+             char *error,
+             size_t error_size)
+{
+  uint32_t v;
+  if (fread (h, size, 1, f) != 1 || memcmp (h, magic, 8) != 0)
+  {
+    snprintf (error, error_size, "%s", "invalid index header");
+    return false;
+  }
+
+  memcpy (&v, (const char *)h + 8, sizeof (v));
+
+  if (v != version)
+  {
+    snprintf (error, error_size,
+              "unsupported index version %u",
+              (unsigned int)v);
+    return false;
+  }
+
+  return true;
+}
+
+// The index (pdjson_index, pdjson_record_index, etc) versions of the above
+// functions that use the index allocator and, in case of an error, set the
+// index error message. The index is expected to have the alloc, alloc_data,
+// and error_message members.
+//
+#define index_error(x, format, ...)                                       \
+  snprintf ((x)->error_message, sizeof ((x)->error_message),              \
+            format,                                                       \
+            __VA_ARGS__)
+
+#define index_allocate(x, n)                                              \
+  array_allocate (&(x)->alloc, (x)->alloc_data, (n))
+
+#define index_grow(x, array, capacity, size, n, element)                  \
+  (array_grow (&(x)->alloc, (x)->alloc_data,                              \
+               (array), (capacity), (size), (n), (element)) ||            \
+   (index_error ((x), "%s", "out of memory"), false))
+
+#define index_release(x, array, capacity, element)                        \
+  array_release (&(x)->alloc, (x)->alloc_data,                            \
+                 (array), (capacity), (element))
+
+#define index_header_read(x, h, magic, version, f)                        \
+  header_read ((h), sizeof (*(h)), (magic), (version), (f),               \
+               (x)->error_message, sizeof ((x)->error_message))
+
+#endif // LIBPDJSON5_PDJSON5_INTERNAL_H
@@ -0,0 +1,349 @@
+#include <libpdjson5/pdjson5-record-index.h>
+
+#include <string.h> // mem*()
+
+#include <libpdjson5/pdjson5-internal.h>
+
+typedef struct pdjson_record_block block;
+
+// Number of hash functions (bits set per name or value) in the filters.
+//
+#define HASHES 4
+
+// Sidecar file header.
+//
+static const char magic[8] = {'P', 'D', 'J', 'S', 'O', 'N', 'R', 'X'};
+#define VERSION 1
+
+struct header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t blocks_size;
+  uint64_t block_records;
+  uint64_t filter_size;
+  uint64_t value_size;
+};
+
+// Hash the name or value together with its kind (so that, for example, the
+// member name "a" and the string value "a" are different).
+//
+static uint64_t
+hash (enum pdjson_type type, const char *v, size_t n)
+{
+  char k;
+  switch (type)
+  {
+  case PDJSON_NAME:   k = 'k'; break;
+  case PDJSON_STRING: k = 's'; break;
+  case PDJSON_NUMBER: k = 'n'; break;
+  case PDJSON_TRUE:   k = 't'; n = 0; break;
+  case PDJSON_FALSE:  k = 'f'; n = 0; break;
+  default:            k = 'z'; n = 0; break;
+  }
+
+  return fnv1a (fnv1a (FNV1A_BASIS, &k, 1), v, n);
+}
+
+// Return the bit positions in the filter for the hash using double hashing
+// with the second hash derived from the first by mixing.
+//
+static void
+bits (uint64_t h, size_t filter_size, uint64_t *r)
+{
+  uint64_t m = (uint64_t)filter_size * 8;
+
+  uint64_t h2 = h ^ (h >> 33);
+  h2 *= 0xFF51AFD7ED558CCDULL;
+  h2 ^= h2 >> 33;
+  h2 |= 1;
+
+  for (size_t i = 0; i != HASHES; ++i)
+    r[i] = (h + i * h2) % m;
+}
+
+static void
+add (const pdjson_record_index *x,
+     unsigned char *f,
+     enum pdjson_type type,
+     const char *v,
+     size_t n)
+{
+  uint64_t bs[HASHES];
+  bits (hash (type, v, n), x->filter_size, bs);
+
+  for (size_t i = 0; i != HASHES; ++i)
+    f[bs[i] / 8] |= (unsigned char)(1U << (bs[i] % 8));
+}
+
+bool
+pdjson_record_index_build (pdjson_record_index *x,
+                           pdjson_stream *json,
+                           size_t block_records,
+                           size_t filter_size,
+                           size_t value_size)
+{
+  memset (x, 0, sizeof (*x));
+
+  x->alloc = json->alloc;
+  x->alloc_data = json->alloc_data;
+  x->block_records = block_records;
+  x->filter_size = filter_size;
+  x->value_size = value_size;
+
+  if (block_records == 0 || filter_size == 0)
+  {
+    index_error (x, "%s", "zero block records or filter size");
+    return false;
+  }
+
+  for (uint64_t record = 0;; ++record)
+  {
+    struct pdjson_checkpoint cp;
+    if (!pdjson_checkpoint (json, &cp))
+    {
+      index_error (x,
+                   "%s",
+                   "stream is not between values in streaming mode");
+      return false;
+    }
+
+    enum pdjson_type t = pdjson_next (json);
+
+    if (t == PDJSON_ERROR)
+      return false;
+
+    if (t == PDJSON_DONE)
+      return true;
+
+    // Start a new block if necessary.
+    //
+    if (record % block_records == 0)
+    {
+      if (!index_grow (x,
+                       (void **)&x->blocks,
+                       &x->blocks_capacity,
+                       x->blocks_size,
+                       1,
+                       sizeof (block)) ||
+          !index_grow (x,
+                       (void **)&x->filters,
+                       &x->filters_capacity,
+                       x->blocks_size * filter_size,
+                       filter_size,
+                       1))
+        return false;
+
+      block *b = x->blocks + x->blocks_size;
+      b->start = cp;
+      b->record = record;
+      b->count = 0;
+
+      memset (x->filters + x->blocks_size * filter_size, 0, filter_size);
+      x->blocks_size++;
+    }
+
+    x->blocks[x->blocks_size - 1].count++;
+
+    unsigned char *f = x->filters + (x->blocks_size - 1) * filter_size;
+    do
+    {
+      size_t n;
+      const char *v;
+
+      switch (t)
+      {
+      case PDJSON_NAME:
+        {
+          v = pdjson_get_name (json, &n);
+          add (x, f, t, v, n - 1);
+          break;
+        }
+      case PDJSON_STRING:
+      case PDJSON_NUMBER:
+        {
+          v = pdjson_get_value (json, &n);
+          if (n - 1 <= value_size)
+            add (x, f, t, v, n - 1);
+          break;
+        }
+      case PDJSON_TRUE:
+      case PDJSON_FALSE:
+      case PDJSON_NULL:
+        {
+          if (value_size != 0)
+            add (x, f, t, NULL, 0);
+          break;
+        }
+      default:
+        break;
+      }
+    }
+    while ((t = pdjson_next (json)) != PDJSON_DONE && t != PDJSON_ERROR);
+
+    if (t == PDJSON_ERROR)
+      return false;
+
+    pdjson_reset (json);
+  }
+}
+
+bool
+pdjson_record_index_write (pdjson_record_index *x, FILE *f)
+{
+  struct header h;
+  memcpy (h.magic, magic, sizeof (magic));
+  h.version = VERSION;
+  h.reserved = 0;
+  h.blocks_size = x->blocks_size;
+  h.block_records = x->block_records;
+  h.filter_size = x->filter_size;
+  h.value_size = x->value_size;
+
+  if (!array_write (&h, sizeof (h), 1, f)                            ||
+      !array_write (x->blocks, sizeof (block), x->blocks_size, f)   ||
+      !array_write (x->filters, x->filter_size, x->blocks_size, f) ||
+      fflush (f) != 0)
+  {
+    index_error (x, "%s", "unable to write index");
+    return false;
+  }
+
+  return true;
+}
+
+bool
+pdjson_record_index_read (pdjson_record_index *x,
+                          FILE *f,
+                          const pdjson_allocator *alloc,
+                          void *data)
+{
+  memset (x, 0, sizeof (*x));
+
+  if (alloc != NULL)
+  {
+    x->alloc = *alloc;
+    x->alloc_data = data;
+  }
+
+  struct header h;
+  if (!index_header_read (x, &h, magic, VERSION, f))
+    return false;
+
+  if (h.block_records == 0                             ||
+      h.filter_size == 0                               ||
+      (uint64_t)(size_t)h.filter_size != h.filter_size ||
+      (uint64_t)(size_t)h.value_size != h.value_size   ||
+      h.blocks_size > SIZE_MAX / sizeof (block)        ||
+      h.blocks_size > SIZE_MAX / h.filter_size)
+  {
+    index_error (x, "%s", "invalid index header");
+    return false;
+  }
+
+  x->block_records = (size_t)h.block_records;
+  x->filter_size = (size_t)h.filter_size;
+  x->value_size = (size_t)h.value_size;
+
+  size_t n = (size_t)h.blocks_size;
+  if (n != 0 &&
+      ((x->blocks = (block *)index_allocate (x, n * sizeof (block))) == NULL ||
+       (x->filters = (unsigned char *)
+        index_allocate (x, n * x->filter_size)) == NULL))
+  {
+    index_error (x, "%s", "out of memory");
+    return false;
+  }
+
+  x->blocks_size = x->blocks_capacity = n;
+  x->filters_capacity = n * x->filter_size;
+
+  if (!array_read (x->blocks, sizeof (block), n, f) ||
+      !array_read (x->filters, x->filter_size, n, f))
+  {
+    index_error (x, "%s", "unable to read index");
+    return false;
+  }
+
+  return true;
+}
+
+const char *
+pdjson_record_index_get_error (const pdjson_record_index *x)
+{
+  return x->error_message[0] != '\0' ? x->error_message : NULL;
+}
+
+void
+pdjson_record_index_free (pdjson_record_index *x)
+{
+  index_release (x, x->blocks, x->blocks_capacity, sizeof (block));
+  index_release (x, x->filters, x->filters_capacity, 1);
+
+  x->blocks = NULL;
+  x->filters = NULL;
+}
+
+// Return true if the value is not in the filters because of its type or
+// size (and so cannot be excluded).
+//
+static bool
+unindexed (const pdjson_record_index *x, enum pdjson_type type, size_t n)
+{
+  return type != PDJSON_NAME &&
+    (x->value_size == 0 ||
+     ((type == PDJSON_STRING || type == PDJSON_NUMBER) && n > x->value_size));
+}
+
+static bool
+test (const pdjson_record_index *x, size_t b, const uint64_t *bs)
+{
+  const unsigned char *f = x->filters + b * x->filter_size;
+  for (size_t i = 0; i != HASHES; ++i)
+  {
+    if (!(f[bs[i] / 8] & (1U << (bs[i] % 8))))
+      return false;
+  }
+
+  return true;
+}
+
+bool
+pdjson_record_index_may_contain (const pdjson_record_index *x,
+                                 size_t b,
+                                 enum pdjson_type type,
+                                 const char *v,
+                                 size_t n)
+{
+  if (unindexed (x, type, n))
+    return true;
+
+  uint64_t bs[HASHES];
+  bits (hash (type, v, n), x->filter_size, bs);
+  return test (x, b, bs);
+}
+
+size_t
+pdjson_record_index_find (const pdjson_record_index *x,
+                          size_t b,
+                          enum pdjson_type type,
+                          const char *v,
+                          size_t n)
+{
+  if (b >= x->blocks_size)
+    return x->blocks_size;
+
+  if (unindexed (x, type, n))
+    return b;
+
+  // Note that the bit positions are the same for all the blocks.
+  //
+  uint64_t bs[HASHES];
+  bits (hash (type, v, n), x->filter_size, bs);
+
+  while (b != x->blocks_size && !test (x, b, bs))
+    ++b;
+
+  return b;
+}
@@ -0,0 +1,123 @@
+#ifndef LIBPDJSON5_PDJSON5_RECORD_INDEX_H
+#define LIBPDJSON5_PDJSON5_RECORD_INDEX_H
+
+#include <libpdjson5/pdjson5.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+// Record index for skipping blocks of values in the streaming mode.
+//
+// The index is built by scanning a sequence of top-level values (records,
+// for example, newline-delimited JSON) once and splitting them into blocks
+// of the specified number of records. For each block the index records the
+// parser checkpoint of its first record (see pdjson_checkpoint()) and a
+// Bloom filter of the member names (at any depth) and, optionally, short
+// scalar values in its records. The index can then be saved into a sidecar
+// file and used to only parse the blocks that may contain the name or value
+// being searched for (resuming the parser at each such block with
+// pdjson_resume()).
+//
+typedef struct pdjson_record_index pdjson_record_index;
+
+struct pdjson_record_block
+{
+  struct pdjson_checkpoint start; // First record.
+  uint64_t record;                // First record number (0-based).
+  uint64_t count;                 // Number of records.
+};
+
+// Build the index from the remaining values in the stream, which should be
+// in the streaming mode. Each block contains up to the specified number of
+// records and its filter is the specified number of bytes. If value_size is
+// not zero, then also add string, number, and literal values that are no
+// longer than this size to the filters. The index memory is allocated with
+// the stream's allocator. Return false on error, in which case the error is
+// either described by pdjson_record_index_get_error() or, if it returns
+// NULL, it is a parsing error as described by pdjson_get_error(). In case
+// of an error the index should still be freed.
+//
+LIBPDJSON5_SYMEXPORT bool
+pdjson_record_index_build (pdjson_record_index *index,
+                           pdjson_stream *json,
+                           size_t block_records,
+                           size_t filter_size,
+                           size_t value_size);
+
+// Save the index into or load the index from a sidecar file. Note that the
+// index is saved in the native byte order and can only be loaded on the
+// same architecture. The allocator used to load the index can be NULL.
+// Return false on error, in which case the error is described by
+// pdjson_record_index_get_error() and, for pdjson_record_index_read(), the
+// index should still be freed.
+//
+LIBPDJSON5_SYMEXPORT bool
+pdjson_record_index_write (pdjson_record_index *index, FILE *file);
+
+LIBPDJSON5_SYMEXPORT bool
+pdjson_record_index_read (pdjson_record_index *index,
+                          FILE *file,
+                          const pdjson_allocator *allocator,
+                          void *user_data);
+
+LIBPDJSON5_SYMEXPORT const char *
+pdjson_record_index_get_error (const pdjson_record_index *index);
+
+LIBPDJSON5_SYMEXPORT void
+pdjson_record_index_free (pdjson_record_index *index);
+
+// Return false if the block definitely does not contain the member name
+// (type is PDJSON_NAME) or the value (type is PDJSON_STRING, PDJSON_NUMBER,
+// PDJSON_TRUE, PDJSON_FALSE, or PDJSON_NULL) and true if it may. The size
+// does not include the trailing `\0`. Note that numbers are matched in
+// their textual representation (so 1 and 1.0 are different values) and
+// that true is always returned for values if the index does not contain
+// them or the value is longer than the index value size.
+//
+LIBPDJSON5_SYMEXPORT bool
+pdjson_record_index_may_contain (const pdjson_record_index *index,
+                                 size_t block,
+                                 enum pdjson_type type,
+                                 const char *value,
+                                 size_t size);
+
+// Return the first block starting from the specified one that may contain
+// the name or value (see above) or the number of blocks if there is none.
+//
+LIBPDJSON5_SYMEXPORT size_t
+pdjson_record_index_find (const pdjson_record_index *index,
+                          size_t block,
+                          enum pdjson_type type,
+                          const char *value,
+                          size_t size);
+
+// Private.
+//
+struct pdjson_record_index
+{
+  struct pdjson_record_block *blocks;
+  size_t blocks_size;
+  size_t blocks_capacity;
+
+  // Block filters, filter_size bytes each.
+  //
+  unsigned char *filters;
+  size_t filters_capacity;
+
+  size_t block_records;
+  size_t filter_size;
+  size_t value_size;
+
+  struct pdjson_allocator alloc;
+  void *alloc_data;
+
+  char error_message[128];
+};
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // LIBPDJSON5_PDJSON5_RECORD_INDEX_H
@@ -0,0 +1,1363 @@
+#include <libpdjson5/pdjson5-schema.h>
+
+#include <math.h>     // isfinite()
+#include <locale.h>   // localeconv()
+#include <stdlib.h>   // strtod()
+#include <string.h>   // str*(), mem*()
+#include <inttypes.h> // PR*
+
+#include <libpdjson5/pdjson5-internal.h>
+
+// Predefined nodes for the true and false schemas.
+//
+#define NODE_ANY  0
+#define NODE_NONE 1
+
+#define NODE_ERROR      ((size_t)-1) // Compilation error.
+#define NODE_UNDECLARED ((size_t)-1) // Required but undeclared property.
+
+// Value types.
+//
+#define TYPE_NULL    0x01U
+#define TYPE_BOOLEAN 0x02U
+#define TYPE_OBJECT  0x04U
+#define TYPE_ARRAY   0x08U
+#define TYPE_NUMBER  0x10U
+#define TYPE_INTEGER 0x20U
+#define TYPE_STRING  0x40U
+#define TYPE_ALL     0x7FU
+
+static const char *type_names[] = {
+  "null", "boolean", "object", "array", "number", "integer", "string"};
+
+// Node flags.
+//
+#define FLAG_MINIMUM           0x01U
+#define FLAG_MAXIMUM           0x02U
+#define FLAG_EXCLUSIVE_MINIMUM 0x04U
+#define FLAG_EXCLUSIVE_MAXIMUM 0x08U
+#define FLAG_ENUM              0x10U
+
+enum format
+{
+  FORMAT_NONE,
+  FORMAT_DATE,
+  FORMAT_TIME,
+  FORMAT_DATE_TIME,
+  FORMAT_IPV4,
+  FORMAT_UUID,
+  FORMAT_EMAIL
+};
+
+static const char *format_names[] = {
+  NULL, "date", "time", "date-time", "ipv4", "uuid", "email"};
+
+struct property
+{
+  size_t name;      // Offset in strings.
+  size_t name_size; // Excluding the trailing `\0`.
+  size_t node;      // Value node or NODE_UNDECLARED.
+  size_t required;  // Required member bit or (size_t)-1.
+};
+
+struct value
+{
+  enum pdjson_type type;
+  size_t string;      // Offset in strings for PDJSON_STRING.
+  size_t string_size; // Excluding the trailing `\0`.
+  double number;      // Value for PDJSON_NUMBER.
+};
+
+struct pdjson_schema_node
+{
+  unsigned int types;
+  unsigned int flags;
+  enum format format;
+
+  double minimum;
+  double maximum;
+  double exclusive_minimum;
+  double exclusive_maximum;
+
+  uint64_t min_length;
+  uint64_t max_length;
+  uint64_t min_items;
+  uint64_t max_items;
+  uint64_t min_properties;
+  uint64_t max_properties;
+
+  size_t items;      // Array items node.
+  size_t additional; // Additional properties node.
+
+  // Sorted by name.
+  //
+  struct property *properties;
+  size_t properties_size;
+  size_t properties_capacity;
+  size_t required_size; // Number of required properties.
+
+  struct value *values;
+  size_t values_size;
+  size_t values_capacity;
+};
+
+struct pdjson_validator_frame
+{
+  size_t node;
+  enum pdjson_type type; // PDJSON_OBJECT or PDJSON_ARRAY.
+  uint64_t count; // Number of items or members so far.
+  size_t seen;    // Required members bitmap offset in seen.
+};
+
+typedef struct pdjson_schema_node node;
+typedef struct pdjson_validator_frame frame;
+
+#define schema_error(schema, format, ...)                                 \
+  snprintf (schema->error_message, sizeof (schema->error_message),        \
+            format,                                                       \
+            __VA_ARGS__)
+
+#define validator_error(validator, format, ...)                           \
+  snprintf (validator->error_message, sizeof (validator->error_message),  \
+            format,                                                       \
+            __VA_ARGS__)
+
+// Allocator-aware array helpers (see pdjson5-internal.h).
+//
+#define schema_grow(s, array, capacity, size, n, element)                 \
+  array_grow (&(s)->alloc, (s)->alloc_data,                               \
+              (array), (capacity), (size), (n), (element))
+
+#define schema_release(s, array, capacity, element)                       \
+  array_release (&(s)->alloc, (s)->alloc_data,                            \
+                 (array), (capacity), (element))
+
+// Convert the number value to double. Return false if the conversion fails
+// or if out of memory.
+//
+// Note that strtod() expects the decimal point of the current locale which
+// may not be '.' (for example, ',' in de_DE). In this case we convert a copy
+// of the value with the decimal point replaced.
+//
+static bool
+parse_number (const pdjson_schema *s, const char *v, double *r)
+{
+  const char *d = strchr (v, '.');
+  const char *p = localeconv ()->decimal_point;
+
+  if (d == NULL || (p[0] == '.' && p[1] == '\0'))
+  {
+    char *e;
+    *r = strtod (v, &e);
+    return *e == '\0';
+  }
+
+  size_t pn = strlen (p);
+  size_t dn = (size_t)(d - v);
+  size_t n = dn + pn + strlen (d + 1) + 1;
+
+  char buf[64];
+  char *b = buf;
+
+  if (n > sizeof (buf))
+  {
+    b = (char *)array_allocate (&s->alloc, s->alloc_data, n); // THROW
+
+    if (b == NULL)
+      return false;
+  }
+
+  memcpy (b, v, dn);
+  memcpy (b + dn, p, pn);
+  memcpy (b + dn + pn, d + 1, n - dn - pn);
+
+  char *e;
+  *r = strtod (b, &e);
+  bool ok = *e == '\0';
+
+  if (b != buf)
+    schema_release (s, b, n, 1);
+
+  return ok;
+}
+
+static bool
+is_integer (double v)
+{
+  // Note that all the doubles that are 2^53 or greater in magnitude are
+  // integers.
+  //
+  return isfinite (v) &&
+    (v >= 9007199254740992.0 || v <= -9007199254740992.0 ||
+     v == (double)(int64_t)v);
+}
+
+// Schema compilation.
+//
+
+// Add the string (including the trailing `\0`) to the string pool and
+// return its offset or (size_t)-1 if out of memory.
+//
+static size_t
+add_string (pdjson_schema *s, const char *v, size_t n)
+{
+  if (!schema_grow (s,
+                    (void **)&s->strings,
+                    &s->strings_capacity,
+                    s->strings_size,
+                    n,
+                    1))
+    return (size_t)-1;
+
+  size_t r = s->strings_size;
+  memcpy (s->strings + r, v, n);
+  s->strings_size += n;
+  return r;
+}
+
+static size_t
+add_node (pdjson_schema *s)
+{
+  if (!schema_grow (s,
+                    (void **)&s->nodes,
+                    &s->nodes_capacity,
+                    s->nodes_size,
+                    1,
+                    sizeof (node)))
+  {
+    schema_error (s, "%s", "out of memory");
+    return NODE_ERROR;
+  }
+
+  node *n = s->nodes + s->nodes_size;
+  memset (n, 0, sizeof (node));
+
+  n->types = TYPE_ALL;
+  n->max_length = UINT64_MAX;
+  n->max_items = UINT64_MAX;
+  n->max_properties = UINT64_MAX;
+  n->items = NODE_ANY;
+  n->additional = NODE_ANY;
+
+  return s->nodes_size++;
+}
+
+// Find the property in the sorted properties array returning its index or,
+// if not found, the index at which it should be inserted.
+//
+static size_t
+find_property (const pdjson_schema *s,
+               const node *n,
+               const char *name,
+               size_t size,
+               bool *found)
+{
+  size_t b = 0, e = n->properties_size;
+  while (b != e)
+  {
+    size_t m = b + (e - b) / 2;
+    const struct property *p = n->properties + m;
+
+    size_t k = p->name_size < size ? p->name_size : size;
+    int r = memcmp (s->strings + p->name, name, k);
+    if (r == 0)
+      r = p->name_size < size ? -1 : p->name_size > size ? 1 : 0;
+
+    if (r == 0)
+    {
+      *found = true;
+      return m;
+    }
+
+    if (r < 0)
+      b = m + 1;
+    else
+      e = m;
+  }
+
+  *found = false;
+  return b;
+}
+
+// Add the property name to the node returning its index in the properties
+// array or (size_t)-1 if out of memory. If the property is new, initialize
+// it as undeclared and not required.
+//
+static size_t
+add_property (pdjson_schema *s, size_t ni, const char *name, size_t size)
+{
+  bool found;
+  size_t i = find_property (s, s->nodes + ni, name, size, &found);
+
+  if (found)
+    return i;
+
+  size_t o = add_string (s, name, size + 1);
+  node *n = s->nodes + ni;
+
+  if (o == (size_t)-1 ||
+      !schema_grow (s,
+                    (void **)&n->properties,
+                    &n->properties_capacity,
+                    n->properties_size,
+                    1,
+                    sizeof (struct property)))
+  {
+    schema_error (s, "%s", "out of memory");
+    return (size_t)-1;
+  }
+
+  struct property *p = n->properties + i;
+  memmove (p + 1, p, (n->properties_size - i) * sizeof (struct property));
+  n->properties_size++;
+
+  p->name = o;
+  p->name_size = size;
+  p->node = NODE_UNDECLARED;
+  p->required = (size_t)-1;
+  return i;
+}
+
+static bool
+add_value (pdjson_schema *s, size_t ni, pdjson_stream *json, enum pdjson_type t)
+{
+  struct value v = {t, 0, 0, 0.0};
+
+  switch (t)
+  {
+  case PDJSON_STRING:
+    {
+      size_t n;
+      const char *str = pdjson_get_value (json, &n);
+      if ((v.string = add_string (s, str, n)) == (size_t)-1)
+      {
+        schema_error (s, "%s", "out of memory");
+        return false;
+      }
+      v.string_size = n - 1;
+      break;
+    }
+  case PDJSON_NUMBER:
+    {
+      if (!parse_number (s, pdjson_get_value (json, NULL), &v.number))
+      {
+        schema_error (s, "%s", "unable to convert enum number");
+        return false;
+      }
+      break;
+    }
+  case PDJSON_TRUE:
+  case PDJSON_FALSE:
+  case PDJSON_NULL:
+    break;
+  case PDJSON_ERROR:
+    return false;
+  default:
+    schema_error (s, "%s", "only scalar enum/const values are supported");
+    return false;
+  }
+
+  node *n = s->nodes + ni;
+  if (!schema_grow (s,
+                    (void **)&n->values,
+                    &n->values_capacity,
+                    n->values_size,
+                    1,
+                    sizeof (struct value)))
+  {
+    schema_error (s, "%s", "out of memory");
+    return false;
+  }
+
+  n->values[n->values_size++] = v;
+  return true;
+}
+
+// Read the keyword number value.
+//
+static bool
+read_number (pdjson_schema *s, pdjson_stream *json, const char *k, double *r)
+{
+  enum pdjson_type t = pdjson_next (json);
+
+  if (t == PDJSON_ERROR)
+    return false;
+
+  if (t != PDJSON_NUMBER ||
+      !parse_number (s, pdjson_get_value (json, NULL), r) ||
+      !isfinite (*r))
+  {
+    schema_error (s, "%s value must be a number", k);
+    return false;
+  }
+
+  return true;
+}
+
+// Read the keyword non-negative integer value.
+//
+static bool
+read_count (pdjson_schema *s, pdjson_stream *json, const char *k, uint64_t *r)
+{
+  double v;
+  if (!read_number (s, json, k, &v))
+    return false;
+
+  if (v < 0 || v >= 18446744073709551616.0 || !is_integer (v))
+  {
+    schema_error (s, "%s value must be a non-negative integer", k);
+    return false;
+  }
+
+  *r = (uint64_t)v;
+  return true;
+}
+
+static unsigned int
+parse_type (const char *v)
+{
+  for (size_t i = 0; i != sizeof (type_names) / sizeof (type_names[0]); ++i)
+  {
+    if (strcmp (v, type_names[i]) == 0)
+      return 1U << i;
+  }
+
+  return 0;
+}
+
+static bool
+read_type (pdjson_schema *s, pdjson_stream *json, unsigned int *r)
+{
+  enum pdjson_type t = pdjson_next (json);
+
+  bool array = (t == PDJSON_ARRAY);
+  if (array)
+    t = pdjson_next (json);
+
+  for (*r = 0;; t = pdjson_next (json))
+  {
+    if (t == PDJSON_ERROR)
+      return false;
+
+    if (array && t == PDJSON_ARRAY_END)
+      break;
+
+    unsigned int v;
+    if (t != PDJSON_STRING ||
+        (v = parse_type (pdjson_get_value (json, NULL))) == 0)
+    {
+      schema_error (s, "%s", "type value must be type name or array thereof");
+      return false;
+    }
+
+    *r |= v;
+
+    if (!array)
+      break;
+  }
+
+  if (*r == 0)
+  {
+    schema_error (s, "%s", "type array must not be empty");
+    return false;
+  }
+
+  return true;
+}
+
+static const char *unsupported_keywords[] = {
+  "$ref", "$dynamicRef", "allOf", "anyOf", "oneOf", "not", "if", "then",
+  "else", "pattern", "patternProperties", "propertyNames", "dependencies",
+  "dependentRequired", "dependentSchemas", "contains", "minContains",
+  "maxContains", "uniqueItems", "multipleOf", "additionalItems",
+  "prefixItems", "unevaluatedItems", "unevaluatedProperties"};
+
+static size_t
+compile_node (pdjson_schema *s, pdjson_stream *json, enum pdjson_type t)
+{
+  switch (t)
+  {
+  case PDJSON_TRUE:  return NODE_ANY;
+  case PDJSON_FALSE: return NODE_NONE;
+  case PDJSON_OBJECT: break;
+  case PDJSON_ERROR: return NODE_ERROR;
+  default:
+    schema_error (s, "%s", "schema must be object or boolean");
+    return NODE_ERROR;
+  }
+
+  size_t ni = add_node (s);
+  if (ni == NODE_ERROR)
+    return NODE_ERROR;
+
+  // Note that s->nodes may be reallocated while compiling the subschemas so
+  // we have to refer to the node by index.
+  //
+#define N (s->nodes + ni)
+
+  while ((t = pdjson_next (json)) != PDJSON_OBJECT_END)
+  {
+    if (t == PDJSON_ERROR)
+      return NODE_ERROR;
+
+    const char *k = pdjson_get_name (json, NULL);
+
+    if (strcmp (k, "type") == 0)
+    {
+      if (!read_type (s, json, &N->types))
+        return NODE_ERROR;
+    }
+    else if (strcmp (k, "enum") == 0 || strcmp (k, "const") == 0)
+    {
+      N->flags |= FLAG_ENUM;
+
+      if (k[0] == 'c')
+      {
+        if (!add_value (s, ni, json, pdjson_next (json)))
+          return NODE_ERROR;
+      }
+      else
+      {
+        if ((t = pdjson_next (json)) != PDJSON_ARRAY)
+        {
+          if (t != PDJSON_ERROR)
+            schema_error (s, "%s", "enum value must be array");
+          return NODE_ERROR;
+        }
+
+        while ((t = pdjson_next (json)) != PDJSON_ARRAY_END)
+        {
+          if (!add_value (s, ni, json, t))
+            return NODE_ERROR;
+        }
+      }
+    }
+    else if (strcmp (k, "minimum") == 0)
+    {
+      N->flags |= FLAG_MINIMUM;
+      if (!read_number (s, json, "minimum", &N->minimum))
+        return NODE_ERROR;
+    }
+    else if (strcmp (k, "maximum") == 0)
+    {
+      N->flags |= FLAG_MAXIMUM;
+      if (!read_number (s, json, "maximum", &N->maximum))
+        return NODE_ERROR;
+    }
+    else if (strcmp (k, "exclusiveMinimum") == 0)
+    {
+      N->flags |= FLAG_EXCLUSIVE_MINIMUM;
+      if (!read_number (s, json, "exclusiveMinimum", &N->exclusive_minimum))
+        return NODE_ERROR;
+    }
+    else if (strcmp (k, "exclusiveMaximum") == 0)
+    {
+      N->flags |= FLAG_EXCLUSIVE_MAXIMUM;
+      if (!read_number (s, json, "exclusiveMaximum", &N->exclusive_maximum))
+        return NODE_ERROR;
+    }
+    else if (strcmp (k, "minLength") == 0)
+    {
+      if (!read_count (s, json, "minLength", &N->min_length))
+        return NODE_ERROR;
+    }
+    else if (strcmp (k, "maxLength") == 0)
+    {
+      if (!read_count (s, json, "maxLength", &N->max_length))
+        return NODE_ERROR;
+    }
+    else if (strcmp (k, "minItems") == 0)
+    {
+      if (!read_count (s, json, "minItems", &N->min_items))
+        return NODE_ERROR;
+    }
+    else if (strcmp (k, "maxItems") == 0)
+    {
+      if (!read_count (s, json, "maxItems", &N->max_items))
+        return NODE_ERROR;
+    }
+    else if (strcmp (k, "minProperties") == 0)
+    {
+      if (!read_count (s, json, "minProperties", &N->min_properties))
+        return NODE_ERROR;
+    }
+    else if (strcmp (k, "maxProperties") == 0)
+    {
+      if (!read_count (s, json, "maxProperties", &N->max_properties))
+        return NODE_ERROR;
+    }
+    else if (strcmp (k, "format") == 0)
+    {
+      if ((t = pdjson_next (json)) != PDJSON_STRING)
+      {
+        if (t != PDJSON_ERROR)
+          schema_error (s, "%s", "format value must be string");
+        return NODE_ERROR;
+      }
+
+      // Ignore unknown formats.
+      //
+      const char *v = pdjson_get_value (json, NULL);
+      for (size_t i = 1;
+           i != sizeof (format_names) / sizeof (format_names[0]);
+           ++i)
+      {
+        if (strcmp (v, format_names[i]) == 0)
+        {
+          N->format = (enum format)i;
+          break;
+        }
+      }
+    }
+    else if (strcmp (k, "properties") == 0)
+    {
+      if ((t = pdjson_next (json)) != PDJSON_OBJECT)
+      {
+        if (t != PDJSON_ERROR)
+          schema_error (s, "%s", "properties value must be object");
+        return NODE_ERROR;
+      }
+
+      while ((t = pdjson_next (json)) != PDJSON_OBJECT_END)
+      {
+        if (t == PDJSON_ERROR)
+          return NODE_ERROR;
+
+        size_t n;
+        const char *name = pdjson_get_name (json, &n);
+
+        size_t pi = add_property (s, ni, name, n - 1);
+        if (pi == (size_t)-1)
+          return NODE_ERROR;
+
+        if (N->properties[pi].node != NODE_UNDECLARED)
+        {
+          schema_error (s, "duplicate property '%s'", name);
+          return NODE_ERROR;
+        }
+
+        size_t vi = compile_node (s, json, pdjson_next (json));
+        if (vi == NODE_ERROR)
+          return NODE_ERROR;
+
+        N->properties[pi].node = vi;
+      }
+    }
+    else if (strcmp (k, "required") == 0)
+    {
+      if ((t = pdjson_next (json)) != PDJSON_ARRAY)
+      {
+        if (t != PDJSON_ERROR)
+          schema_error (s, "%s", "required value must be array");
+        return NODE_ERROR;
+      }
+
+      while ((t = pdjson_next (json)) != PDJSON_ARRAY_END)
+      {
+        if (t != PDJSON_STRING)
+        {
+          if (t != PDJSON_ERROR)
+            schema_error (s, "%s", "required array element must be string");
+          return NODE_ERROR;
+        }
+
+        size_t n;
+        const char *name = pdjson_get_value (json, &n);
+
+        size_t pi = add_property (s, ni, name, n - 1);
+        if (pi == (size_t)-1)
+          return NODE_ERROR;
+
+        N->properties[pi].required = 0; // Assigned below.
+      }
+    }
+    else if (strcmp (k, "additionalProperties") == 0 ||
+             strcmp (k, "items") == 0)
+    {
+      bool items = (k[0] == 'i'); // Note: k is invalidated by next().
+      t = pdjson_next (json);
+
+      if (t == PDJSON_ARRAY)
+      {
+        schema_error (s, "%s", "items array is not supported");
+        return NODE_ERROR;
+      }
+
+      size_t vi = compile_node (s, json, t);
+      if (vi == NODE_ERROR)
+        return NODE_ERROR;
+
+      *(items ? &N->items : &N->additional) = vi;
+    }
+    else
+    {
+      for (size_t i = 0;
+           i != sizeof (unsupported_keywords) / sizeof (unsupported_keywords[0]);
+           ++i)
+      {
+        if (strcmp (k, unsupported_keywords[i]) == 0)
+        {
+          schema_error (s, "unsupported keyword '%s'", k);
+          return NODE_ERROR;
+        }
+      }
+
+      if (pdjson_skip (json) == PDJSON_ERROR)
+        return NODE_ERROR;
+    }
+  }
+
+  // Assign the required member bits.
+  //
+  for (size_t i = 0; i != N->properties_size; ++i)
+  {
+    struct property *p = N->properties + i;
+    if (p->required != (size_t)-1)
+      p->required = N->required_size++;
+  }
+
+#undef N
+
+  return ni;
+}
+
+bool
+pdjson_schema_compile (pdjson_schema *s, pdjson_stream *json)
+{
+  memset (s, 0, sizeof (*s));
+
+  s->alloc = json->alloc;
+  s->alloc_data = json->alloc_data;
+
+  // The true and false schema nodes.
+  //
+  if (add_node (s) == NODE_ERROR || add_node (s) == NODE_ERROR)
+    return false;
+
+  s->nodes[NODE_NONE].types = 0;
+
+  s->root = compile_node (s, json, pdjson_next (json));
+  return s->root != NODE_ERROR;
+}
+
+const char *
+pdjson_schema_get_error (const pdjson_schema *s)
+{
+  return s->error_message[0] != '\0' ? s->error_message : NULL;
+}
+
+void
+pdjson_schema_free (pdjson_schema *s)
+{
+  for (size_t i = 0; i != s->nodes_size; ++i)
+  {
+    node *n = s->nodes + i;
+    schema_release (s,
+                    n->properties,
+                    n->properties_capacity,
+                    sizeof (*n->properties));
+    schema_release (s, n->values, n->values_capacity, sizeof (*n->values));
+  }
+
+  schema_release (s, s->nodes, s->nodes_capacity, sizeof (node));
+  schema_release (s, s->strings, s->strings_capacity, 1);
+
+  s->nodes = NULL;
+  s->strings = NULL;
+}
+
+// Validation.
+//
+
+static size_t
+digits (const char *v, size_t n, unsigned int *r)
+{
+  size_t i = 0;
+  for (*r = 0; i != n && v[i] >= '0' && v[i] <= '9'; ++i)
+    *r = *r * 10 + (unsigned int)(v[i] - '0');
+  return i;
+}
+
+// Match exactly n digits.
+//
+static bool
+digits_n (const char *v, size_t n, unsigned int *r)
+{
+  return digits (v, n, r) == n;
+}
+
+// YYYY-MM-DD (RFC 3339 full-date).
+//
+static bool
+is_date (const char *v, size_t n)
+{
+  unsigned int y, m, d;
+  if (n != 10 || v[4] != '-' || v[7] != '-' ||
+      !digits_n (v, 4, &y) || !digits_n (v + 5, 2, &m) ||
+      !digits_n (v + 8, 2, &d))
+    return false;
+
+  static const unsigned int days[] = {
+    31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+  if (m < 1 || m > 12 || d < 1 || d > days[m - 1])
+    return false;
+
+  return !(m == 2 && d == 29 && (y % 4 != 0 || (y % 100 == 0 && y % 400 != 0)));
+}
+
+// HH:MM:SS[.frac](Z|+HH:MM|-HH:MM) (RFC 3339 full-time).
+//
+static bool
+is_time (const char *v, size_t n)
+{
+  unsigned int h, m, s;
+  if (n < 9 || v[2] != ':' || v[5] != ':' ||
+      !digits_n (v, 2, &h) || !digits_n (v + 3, 2, &m) ||
+      !digits_n (v + 6, 2, &s) || h > 23 || m > 59 || s > 60)
+    return false;
+
+  size_t i = 8;
+  if (v[i] == '.')
+  {
+    size_t k = digits (v + i + 1, n - i - 1, &s);
+    if (k == 0)
+      return false;
+    i += k + 1;
+  }
+
+  if (i == n)
+    return false;
+
+  if (v[i] == 'Z' || v[i] == 'z')
+    return i + 1 == n;
+
+  v += i;
+  return (n - i == 6 && (v[0] == '+' || v[0] == '-') && v[3] == ':' &&
+          digits_n (v + 1, 2, &h) && digits_n (v + 4, 2, &m) &&
+          h <= 23 && m <= 59);
+}
+
+static bool
+is_ipv4 (const char *v, size_t n)
+{
+  size_t i = 0;
+  for (size_t g = 0; g != 4; ++g)
+  {
+    if (g != 0 && (i == n || v[i++] != '.'))
+      return false;
+
+    unsigned int o;
+    size_t k = digits (v + i, n - i, &o);
+    if (k == 0 || k > 3 || o > 255 || (k > 1 && v[i] == '0'))
+      return false;
+    i += k;
+  }
+
+  return i == n;
+}
+
+static bool
+is_uuid (const char *v, size_t n)
+{
+  if (n != 36)
+    return false;
+
+  for (size_t i = 0; i != n; ++i)
+  {
+    char c = v[i];
+    if (i == 8 || i == 13 || i == 18 || i == 23)
+    {
+      if (c != '-')
+        return false;
+    }
+    else if (!((c >= '0' && c <= '9') ||
+               (c >= 'a' && c <= 'f') ||
+               (c >= 'A' && c <= 'F')))
+      return false;
+  }
+
+  return true;
+}
+
+// Only a basic check: non-empty local part and domain separated by the
+// last `@` with no whitespace or control characters.
+//
+static bool
+is_email (const char *v, size_t n)
+{
+  size_t a = n;
+  for (size_t i = 0; i != n; ++i)
+  {
+    unsigned char c = (unsigned char)v[i];
+    if (c <= 0x20 || c == 0x7F)
+      return false;
+    if (c == '@')
+      a = i;
+  }
+
+  return a != 0 && a != n && a + 1 != n;
+}
+
+static bool
+check_format (enum format f, const char *v, size_t n)
+{
+  switch (f)
+  {
+  case FORMAT_NONE:  return true;
+  case FORMAT_DATE:  return is_date (v, n);
+  case FORMAT_TIME:  return is_time (v, n);
+  case FORMAT_DATE_TIME:
+    return (n > 11 && (v[10] == 'T' || v[10] == 't') &&
+            is_date (v, 10) && is_time (v + 11, n - 11));
+  case FORMAT_IPV4:  return is_ipv4 (v, n);
+  case FORMAT_UUID:  return is_uuid (v, n);
+  case FORMAT_EMAIL: return is_email (v, n);
+  }
+
+  return false;
+}
+
+// Return the length of a UTF-8 string in codepoints.
+//
+static uint64_t
+utf8_length (const char *v, size_t n)
+{
+  uint64_t r = 0;
+  for (size_t i = 0; i != n; ++i)
+  {
+    if (((unsigned char)v[i] & 0xC0) != 0x80)
+      r++;
+  }
+  return r;
+}
+
+// Write the list of the type names as `a, b, or c`.
+//
+static void
+print_types (char *b, size_t n, unsigned int types)
+{
+  size_t c = 0, t = 0;
+  for (unsigned int m = types; m != 0; m &= m - 1)
+    t++;
+
+  b[0] = '\0';
+  for (size_t i = 0, l = 0; i != sizeof (type_names) / sizeof (type_names[0]); ++i)
+  {
+    if ((types & (1U << i)) == 0)
+      continue;
+
+    c++;
+    int r = snprintf (b + l, n - l, "%s%s%s",
+                      c == 1 ? "" : t == 2 ? " " : ", ",
+                      c != 1 && c == t ? "or " : "",
+                      type_names[i]);
+
+    if (r < 0 || (l += (size_t)r) >= n)
+      break;
+  }
+}
+
+static bool
+check_value (pdjson_validator *v,
+             pdjson_stream *json,
+             size_t ni,
+             enum pdjson_type t)
+{
+  if (ni == NODE_ANY)
+    return true;
+
+  const pdjson_schema *s = v->schema;
+  const node *n = s->nodes + ni;
+
+  if (ni == NODE_NONE)
+  {
+    validator_error (v, "%s", "value is not allowed");
+    return false;
+  }
+
+  size_t size = 0;
+  const char *value = NULL;
+  double number = 0.0;
+  unsigned int type;
+
+  switch (t)
+  {
+  case PDJSON_NULL:   type = TYPE_NULL;    break;
+  case PDJSON_TRUE:
+  case PDJSON_FALSE:  type = TYPE_BOOLEAN; break;
+  case PDJSON_OBJECT: type = TYPE_OBJECT;  break;
+  case PDJSON_ARRAY:  type = TYPE_ARRAY;   break;
+  case PDJSON_STRING:
+    {
+      type = TYPE_STRING;
+      value = pdjson_get_value (json, &size);
+      size--;
+      break;
+    }
+  case PDJSON_NUMBER:
+    {
+      value = pdjson_get_value (json, &size);
+      size--;
+
+      if (!parse_number (v->schema, value, &number))
+      {
+        validator_error (v, "unable to convert number '%s'", value);
+        return false;
+      }
+
+      type = TYPE_NUMBER;
+      if ((n->types & TYPE_NUMBER) == 0 && is_integer (number))
+        type = TYPE_INTEGER;
+      break;
+    }
+  default:
+    return true;
+  }
+
+  if ((n->types & type) == 0)
+  {
+    char b[64];
+    print_types (b, sizeof (b), n->types);
+
+    // Note that we always call a number a number, integer or not.
+    //
+    if (type == TYPE_INTEGER)
+      type = TYPE_NUMBER;
+
+    size_t i = 0;
+    for (type >>= 1; type != 0; type >>= 1)
+      i++;
+
+    validator_error (v, "expected %s instead of %s", b, type_names[i]);
+    return false;
+  }
+
+  if (n->flags & FLAG_ENUM)
+  {
+    size_t i = 0;
+    for (; i != n->values_size; ++i)
+    {
+      const struct value *e = n->values + i;
+
+      if (e->type == t &&
+          (t == PDJSON_STRING
+           ? (e->string_size == size &&
+              memcmp (s->strings + e->string, value, size) == 0)
+           : t == PDJSON_NUMBER
+           ? e->number == number
+           : true))
+        break;
+    }
+
+    if (i == n->values_size)
+    {
+      validator_error (v, "%s", "value is not one of the enumerated values");
+      return false;
+    }
+  }
+
+  if (t == PDJSON_NUMBER)
+  {
+    if ((n->flags & FLAG_MINIMUM) && !(number >= n->minimum))
+    {
+      validator_error (v, "value %s is less than minimum %g",
+                       value, n->minimum);
+      return false;
+    }
+
+    if ((n->flags & FLAG_MAXIMUM) && !(number <= n->maximum))
+    {
+      validator_error (v, "value %s is greater than maximum %g",
+                       value, n->maximum);
+      return false;
+    }
+
+    if ((n->flags & FLAG_EXCLUSIVE_MINIMUM) &&
+        !(number > n->exclusive_minimum))
+    {
+      validator_error (v, "value %s is not greater than %g",
+                       value, n->exclusive_minimum);
+      return false;
+    }
+
+    if ((n->flags & FLAG_EXCLUSIVE_MAXIMUM) &&
+        !(number < n->exclusive_maximum))
+    {
+      validator_error (v, "value %s is not less than %g",
+                       value, n->exclusive_maximum);
+      return false;
+    }
+  }
+  else if (t == PDJSON_STRING)
+  {
+    if (n->min_length != 0 || n->max_length != UINT64_MAX)
+    {
+      uint64_t l = utf8_length (value, size);
+
+      if (l < n->min_length)
+      {
+        validator_error (v,
+                         "string is shorter than %" PRIu64 " characters",
+                         n->min_length);
+        return false;
+      }
+
+      if (l > n->max_length)
+      {
+        validator_error (v,
+                         "string is longer than %" PRIu64 " characters",
+                         n->max_length);
+        return false;
+      }
+    }
+
+    if (!check_format (n->format, value, size))
+    {
+      validator_error (v,
+                       "string is not a valid %s",
+                       format_names[n->format]);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static bool
+push_frame (pdjson_validator *v, size_t ni, enum pdjson_type t)
+{
+  const pdjson_schema *s = v->schema;
+
+  if (!schema_grow (s,
+                    (void **)&v->stack,
+                    &v->stack_capacity,
+                    v->stack_size,
+                    1,
+                    sizeof (frame)))
+  {
+    validator_error (v, "%s", "out of memory");
+    return false;
+  }
+
+  frame *f = v->stack + v->stack_size++;
+  f->node = ni;
+  f->type = t;
+  f->count = 0;
+  f->seen = v->seen_size;
+
+  size_t r = s->nodes[ni].required_size;
+  for (size_t i = 0; i < r; i += 64)
+  {
+    if (!schema_grow (s,
+                      (void **)&v->seen,
+                      &v->seen_capacity,
+                      v->seen_size,
+                      1,
+                      sizeof (uint64_t)))
+    {
+      validator_error (v, "%s", "out of memory");
+      return false;
+    }
+
+    v->seen[v->seen_size++] = 0;
+  }
+
+  return true;
+}
+
+static bool
+check_name (pdjson_validator *v, pdjson_stream *json)
+{
+  const pdjson_schema *s = v->schema;
+  frame *f = v->stack + v->stack_size - 1;
+
+  if (f->node == NODE_ANY)
+  {
+    v->pending = NODE_ANY;
+    return true;
+  }
+
+  const node *n = s->nodes + f->node;
+
+  if (++f->count > n->max_properties)
+  {
+    validator_error (v,
+                     "object has more than %" PRIu64 " members",
+                     n->max_properties);
+    return false;
+  }
+
+  size_t size;
+  const char *name = pdjson_get_name (json, &size);
+
+  bool found;
+  size_t i = find_property (s, n, name, size - 1, &found);
+
+  size_t r = n->additional;
+  if (found)
+  {
+    const struct property *p = n->properties + i;
+
+    if (p->node != NODE_UNDECLARED)
+      r = p->node;
+
+    if (p->required != (size_t)-1)
+      v->seen[f->seen + p->required / 64] |= (uint64_t)1 << (p->required % 64);
+  }
+
+  if (r == NODE_NONE)
+  {
+    validator_error (v, "unexpected member '%s'", name);
+    return false;
+  }
+
+  v->pending = r;
+  return true;
+}
+
+static bool
+validate_event (pdjson_validator *v, pdjson_stream *json, enum pdjson_type t)
+{
+  const pdjson_schema *s = v->schema;
+
+  switch (t)
+  {
+  case PDJSON_DONE:
+  case PDJSON_ERROR:
+    return true;
+  case PDJSON_NAME:
+    return check_name (v, json);
+  case PDJSON_OBJECT_END:
+  case PDJSON_ARRAY_END:
+    {
+      frame *f = v->stack + --v->stack_size;
+      v->seen_size = f->seen;
+
+      if (f->node == NODE_ANY)
+        return true;
+
+      const node *n = s->nodes + f->node;
+
+      if (t == PDJSON_ARRAY_END)
+      {
+        if (f->count < n->min_items)
+        {
+          validator_error (v,
+                           "array has fewer than %" PRIu64 " items",
+                           n->min_items);
+          return false;
+        }
+      }
+      else
+      {
+        if (f->count < n->min_properties)
+        {
+          validator_error (v,
+                           "object has fewer than %" PRIu64 " members",
+                           n->min_properties);
+          return false;
+        }
+
+        if (n->required_size != 0)
+        {
+          const uint64_t *seen = v->seen + f->seen;
+
+          for (size_t i = 0; i != n->properties_size; ++i)
+          {
+            const struct property *p = n->properties + i;
+            size_t r = p->required;
+
+            if (r != (size_t)-1 &&
+                (seen[r / 64] & ((uint64_t)1 << (r % 64))) == 0)
+            {
+              validator_error (v,
+                               "missing required member '%s'",
+                               s->strings + p->name);
+              return false;
+            }
+          }
+        }
+      }
+
+      return true;
+    }
+  default:
+    break;
+  }
+
+  // Value event: determine its schema node.
+  //
+  size_t ni = s->root;
+  if (v->stack_size != 0)
+  {
+    frame *f = v->stack + v->stack_size - 1;
+
+    if (f->node == NODE_ANY)
+      ni = NODE_ANY;
+    else if (f->type == PDJSON_ARRAY)
+    {
+      const node *n = s->nodes + f->node;
+
+      if (++f->count > n->max_items)
+      {
+        validator_error (v,
+                         "array has more than %" PRIu64 " items",
+                         n->max_items);
+        return false;
+      }
+
+      ni = n->items;
+    }
+    else
+      ni = v->pending;
+  }
+
+  if (!check_value (v, json, ni, t))
+    return false;
+
+  return (t == PDJSON_OBJECT || t == PDJSON_ARRAY
+          ? push_frame (v, ni, t)
+          : true);
+}
+
+void
+pdjson_validator_open (pdjson_validator *v, const pdjson_schema *s)
+{
+  memset (v, 0, sizeof (*v));
+  v->schema = s;
+}
+
+void
+pdjson_validator_close (pdjson_validator *v)
+{
+  const pdjson_schema *s = v->schema;
+  schema_release (s, v->stack, v->stack_capacity, sizeof (frame));
+  schema_release (s, v->seen, v->seen_capacity, sizeof (uint64_t));
+  v->stack = NULL;
+  v->seen = NULL;
+}
+
+void
+pdjson_validator_reset (pdjson_validator *v)
+{
+  v->stack_size = 0;
+  v->seen_size = 0;
+  v->error_message[0] = '\0';
+}
+
+enum pdjson_type
+pdjson_validator_next (pdjson_validator *v, pdjson_stream *json)
+{
+  if (v->error_message[0] != '\0')
+    return PDJSON_ERROR;
+
+  enum pdjson_type t = pdjson_next (json);
+  return validate_event (v, json, t) ? t : PDJSON_ERROR;
+}
+
+const char *
+pdjson_validator_get_error (const pdjson_validator *v)
+{
+  return v->error_message[0] != '\0' ? v->error_message : NULL;
+}
@@ -0,0 +1,138 @@
+#ifndef LIBPDJSON5_PDJSON5_SCHEMA_H
+#define LIBPDJSON5_PDJSON5_SCHEMA_H
+
+#include <libpdjson5/pdjson5.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+// Validation against a JSON Schema subset performed during parsing.
+//
+// The schema is compiled into a set of nodes which are then used to check
+// each event as it is returned by pdjson_validator_next(). The following
+// keywords are supported:
+//
+// type                  -- type name or array of type names
+// enum, const           -- scalar values only
+// minimum, maximum      --
+// exclusiveMinimum      -- number (not boolean)
+// exclusiveMaximum      -- number (not boolean)
+// minLength, maxLength  -- length is in codepoints
+// format                -- date, time, date-time, ipv4, uuid, email
+// properties            --
+// required              --
+// additionalProperties  -- boolean or schema
+// minProperties         --
+// maxProperties         --
+// items                 -- schema (not array of schemas)
+// minItems, maxItems    --
+//
+// The keywords that would affect validation but are not supported (pattern,
+// $ref, anyOf, etc) are diagnosed. Other keywords (title, description,
+// $schema, etc) as well as unknown formats are ignored.
+//
+typedef struct pdjson_schema pdjson_schema;
+typedef struct pdjson_validator pdjson_validator;
+
+// Compile the schema from the next value in the stream. The schema memory is
+// allocated with the stream's allocator. Return false on error, in which
+// case the error is either described by pdjson_schema_get_error() or, if it
+// returns NULL, it is a parsing error as described by pdjson_get_error().
+// In both cases pdjson_get_line/column() return the error location in the
+// schema. In case of an error the schema should still be freed.
+//
+LIBPDJSON5_SYMEXPORT bool
+pdjson_schema_compile (pdjson_schema *schema, pdjson_stream *json);
+
+LIBPDJSON5_SYMEXPORT const char *
+pdjson_schema_get_error (const pdjson_schema *schema);
+
+LIBPDJSON5_SYMEXPORT void
+pdjson_schema_free (pdjson_schema *schema);
+
+// Open the validator for the compiled schema. The validator should be
+// closed with pdjson_validator_close().
+//
+LIBPDJSON5_SYMEXPORT void
+pdjson_validator_open (pdjson_validator *validator,
+                       const pdjson_schema *schema);
+
+LIBPDJSON5_SYMEXPORT void
+pdjson_validator_close (pdjson_validator *validator);
+
+// Reset the validator to its initial state. This should be done when the
+// stream is reset after an error or reopened in the middle of a value.
+// Note that in the streaming mode each subsequent value is validated against
+// the schema without a reset.
+//
+LIBPDJSON5_SYMEXPORT void
+pdjson_validator_reset (pdjson_validator *validator);
+
+// Call pdjson_next() and validate the returned event. If the event violates
+// the schema, return PDJSON_ERROR with pdjson_validator_get_error()
+// describing the violation and pdjson_get_line/column() returning the
+// location of the offending event. Otherwise, return the event as is,
+// including PDJSON_ERROR if returned by pdjson_next(), in which case
+// pdjson_validator_get_error() returns NULL.
+//
+// Note that while validating, the stream should only be advanced with this
+// function (no pdjson_peek(), pdjson_skip(), etc). Once a violation has
+// been detected, this function keeps returning PDJSON_ERROR until reset.
+//
+LIBPDJSON5_SYMEXPORT enum pdjson_type
+pdjson_validator_next (pdjson_validator *validator, pdjson_stream *json);
+
+LIBPDJSON5_SYMEXPORT const char *
+pdjson_validator_get_error (const pdjson_validator *validator);
+
+// Private.
+//
+struct pdjson_schema_node;
+struct pdjson_validator_frame;
+
+struct pdjson_schema
+{
+  size_t root; // Root node.
+
+  struct pdjson_schema_node *nodes;
+  size_t nodes_size;
+  size_t nodes_capacity;
+
+  // Member names and enum strings referenced by the nodes.
+  //
+  char *strings;
+  size_t strings_size;
+  size_t strings_capacity;
+
+  struct pdjson_allocator alloc;
+  void *alloc_data;
+
+  char error_message[128];
+};
+
+struct pdjson_validator
+{
+  const pdjson_schema *schema;
+
+  struct pdjson_validator_frame *stack;
+  size_t stack_size;
+  size_t stack_capacity;
+
+  // Bitmaps of the seen required members for the objects on the stack.
+  //
+  uint64_t *seen;
+  size_t seen_size;
+  size_t seen_capacity;
+
+  size_t pending; // Schema node for the value of the last member name.
+
+  char error_message[128];
+};
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // LIBPDJSON5_PDJSON5_SCHEMA_H
@@ -8,8 +8,10 @@
 #  include "pdjson5.h"
 #endif
 
+#include "pdjson5-internal.h"
+
 #include <stdlib.h>   // malloc()/realloc()/free()
-#include <string.h>   // strlen()
+#include <string.h>   // strlen(), mem*()
 #include <inttypes.h> // PR*
 
 // Defaults.
@@ -32,11 +34,22 @@
 #define FLAG_JSON5        0x02U
 #define FLAG_JSON5E       0x04U
 
+// Language flags as passed to the tokenizer functions (see next_event()).
+//
+#define LANG_MASK   (FLAG_JSON5 | FLAG_JSON5E)
+#define LANG_JSON   0x0U
+#define LANG_JSON5  FLAG_JSON5
+#define LANG_JSON5E (FLAG_JSON5 | FLAG_JSON5E)
+
 // Runtime state flags.
 //
 #define FLAG_ERROR         0x08U
 #define FLAG_NEWLINE       0x10U // Newline seen by last call to next().
 #define FLAG_IMPLIED_END   0x20U // Implied top-level object end is pending.
+#define FLAG_BATCH         0x40U // Inside pdjson_next_batch().
+#define FLAG_VALIDATE      0x80U // Inside pdjson_validate().
+#define FLAG_ERROR_NEWLINE 0x100U // Error caused by consumed newline.
+#define FLAG_FRAME         0x200U // Inside a frame (see pdjson_set_framing()).
 
 #define json_error(json, format, ...)                             \
   if (!(json->flags & FLAG_ERROR))                                \
@@ -68,6 +81,128 @@
     json->subtype = PDJSON_ERROR_MEMORY;                          \
   }
 
+// Force inlining of the language-generic tokenizer functions into their
+// language-specialized instantiations (see next_event()).
+//
+#if defined(__GNUC__)
+#  define force_inline inline __attribute__ ((__always_inline__))
+#elif defined(_MSC_VER)
+#  define force_inline __forceinline
+#else
+#  define force_inline inline
+#endif
+
+// Call the language-specialized instantiation of a tokenizer function. If
+// lang is a constant, then this resolves to a direct call.
+//
+#define lang_call(lang, f, ...)                                   \
+  ((lang) == LANG_JSON5E ? f##_json5e (__VA_ARGS__) :             \
+   (lang) == LANG_JSON5  ? f##_json5 (__VA_ARGS__)  :             \
+   f##_json (__VA_ARGS__))
+
+// Instantiate a tokenizer function with the (json, c, lang) signature for
+// each language (see next_event()).
+//
+#define lang_instantiate(f)                                       \
+  static enum pdjson_type                                         \
+  f##_json (pdjson_stream *json, int c)                           \
+  {                                                               \
+    return f (json, c, LANG_JSON);                                \
+  }                                                               \
+                                                                  \
+  static enum pdjson_type                                         \
+  f##_json5 (pdjson_stream *json, int c)                          \
+  {                                                               \
+    return f (json, c, LANG_JSON5);                               \
+  }                                                               \
+                                                                  \
+  static enum pdjson_type                                         \
+  f##_json5e (pdjson_stream *json, int c)                         \
+  {                                                               \
+    return f (json, c, LANG_JSON5E);                              \
+  }
+
+// Statistics counters (see pdjson_get_stats()).
+//
+#ifdef LIBPDJSON5_STATS
+#  define stats_add(json, counter, n) ((json)->stats.counter += (n))
+#  define stats_max(json, counter, n)                             \
+  ((json)->stats.counter < (n) ? (void)((json)->stats.counter = (n)) : (void)0)
+#else
+#  define stats_add(json, counter, n) ((void)0)
+#  define stats_max(json, counter, n) ((void)0)
+#endif
+
+// Static tracepoints (USDT) for bpftrace, perf, etc (see README.md for the
+// list). Note that sys/sdt.h only supports fixed argument counts.
+//
+#ifdef LIBPDJSON5_SDT
+#  include <sys/sdt.h>
+#  define trace2(name, a1, a2) DTRACE_PROBE2 (pdjson5, name, a1, a2)
+#  define trace3(name, a1, a2, a3) DTRACE_PROBE3 (pdjson5, name, a1, a2, a3)
+#  define trace4(name, a1, a2, a3, a4)                            \
+  DTRACE_PROBE4 (pdjson5, name, a1, a2, a3, a4)
+#else
+#  define trace2(name, a1, a2) ((void)0)
+#  define trace3(name, a1, a2, a3) ((void)0)
+#  define trace4(name, a1, a2, a3, a4) ((void)0)
+#endif
+
+// Character classes.
+//
+// Classifying a character with a table lookup instead of a chain of
+// comparisons avoids most of the branches (and their mispredictions) on the
+// inputs with a mix of different tokens. Note that the language-dependent
+// classes (JSON5 spaces, JSON5E identifier characters) are separate bits
+// that are only tested in the corresponding language instantiations (see
+// next_event()).
+//
+#define CHAR_SPACE  0x01U // JSON space.
+#define CHAR_SPACE5 0x02U // Additional JSON5 space.
+#define CHAR_DIGIT  0x04U // Decimal digit.
+#define CHAR_HEX    0x08U // Hexadecimal digit.
+#define CHAR_ID     0x10U // Identifier character (first or subsequent).
+#define CHAR_ID5E   0x20U // Additional subsequent JSON5E identifier character.
+#define CHAR_PLAIN  0x40U // String character without special handling.
+
+#define B  (CHAR_SPACE | CHAR_PLAIN)
+#define SP CHAR_SPACE
+#define S5 CHAR_SPACE5
+#define D  (CHAR_DIGIT | CHAR_HEX | CHAR_PLAIN)
+#define H  (CHAR_HEX | CHAR_ID | CHAR_PLAIN)
+#define I  (CHAR_ID | CHAR_PLAIN)
+#define E  (CHAR_ID5E | CHAR_PLAIN)
+#define P  CHAR_PLAIN
+
+static const unsigned char char_class[256] = {
+   0,  0,  0,  0,  0,  0,  0,  0,  0, SP, SP, S5, S5, SP,  0,  0, // 0x00
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, // 0x10
+   B,  P,  0,  P,  I,  P,  P,  P,  P,  P,  P,  P,  P,  E,  E,  P, // 0x20
+   D,  D,  D,  D,  D,  D,  D,  D,  D,  D,  P,  P,  P,  P,  P,  P, // 0x30
+   P,  H,  H,  H,  H,  H,  H,  I,  I,  I,  I,  I,  I,  I,  I,  I, // 0x40
+   I,  I,  I,  I,  I,  I,  I,  I,  I,  I,  I,  P,  0,  P,  P,  I, // 0x50
+   P,  H,  H,  H,  H,  H,  H,  I,  I,  I,  I,  I,  I,  I,  I,  I, // 0x60
+   I,  I,  I,  I,  I,  I,  I,  I,  I,  I,  I,  P,  P,  P,  P,  P, // 0x70
+  // The rest (non-ASCII) is 0.
+};
+
+#undef B
+#undef SP
+#undef S5
+#undef D
+#undef H
+#undef I
+#undef E
+#undef P
+
+// Return true if the character (or EOF) belongs to any of the classes.
+//
+static inline bool
+is_char_class (int c, unsigned int classes)
+{
+  return (unsigned int)c <= 0xFF && (char_class[c] & classes) != 0;
+}
+
 static size_t
 utf8_seq_length (char byte)
 {
@@ -156,6 +291,114 @@ is_legal_utf8 (const unsigned char *bytes, size_t length)
   return *bytes <= 0xF4;
 }
 
+// In the length framing mode (see pdjson_set_framing()) the input is limited
+// to the end of the current frame. For the buffer input (including the
+// read-ahead window) we hide the bytes past the frame end by adjusting the
+// buffer length so that the fast path is unaffected. The slow path (which is
+// taken for every byte of the other inputs) checks the limit explicitly.
+//
+static void
+source_limit (pdjson_stream *json)
+{
+  struct pdjson_source *source = &json->source;
+
+  if (json->frame_end != UINT64_MAX && source->tag == PDJSON_SOURCE_BUFFER)
+  {
+    uint64_t e = json->frame_end - json->posoff; // Buffer position.
+
+    if (e < source->source.buffer.length)
+    {
+      source->hidden += source->source.buffer.length - (size_t)e;
+      source->source.buffer.length = (size_t)e;
+    }
+  }
+}
+
+static void
+source_unlimit (pdjson_stream *json)
+{
+  struct pdjson_source *source = &json->source;
+
+  source->source.buffer.length += source->hidden;
+  source->hidden = 0;
+  json->frame_end = UINT64_MAX;
+}
+
+static inline bool
+source_limited (const pdjson_stream *json, const struct pdjson_source *source)
+{
+  // Note that the hidden bytes must not be discarded by refilling the
+  // read-ahead window.
+  //
+  return (source->hidden != 0 ||
+          json->posoff + source->position >= json->frame_end);
+}
+
+// Refill the read-ahead window (see pdjson_set_read_ahead()). Return false
+// on EOF or io error (in which case also set the error flag).
+//
+static bool
+source_refill (pdjson_stream *json, struct pdjson_source *source)
+{
+  // Rebase the position-dependent state on the new window contents (note
+  // that the unsigned arithmetic is well-defined even if it wraps around).
+  //
+  uint64_t n = source->position;
+  json->posoff += n;
+  json->linepos -= n;
+
+  source->position = 0;
+  source->source.buffer.length = 0;
+
+  char *d = source->window.data;
+  size_t size = source->window.size;
+  size_t r = 0;
+  bool error = false;
+
+  switch (source->window.tag)
+  {
+  case PDJSON_SOURCE_STREAM:
+    {
+      FILE *stream = source->source.stream.stream;
+
+      r = fread (d, 1, size, stream);
+      error = (r == 0 && ferror (stream));
+      break;
+    }
+  case PDJSON_SOURCE_USER:
+    {
+      void *data = source->source.user.data;
+      const pdjson_user_io *io = &source->source.user.io;
+
+      if (io->read != NULL)
+        r = io->read (d, size, data);
+      else
+      {
+        for (int c; r != size && (c = io->get (data)) != EOF; )
+          d[r++] = (char)c;
+      }
+
+      // Note that if get() failed after reading some data, we assume it
+      // will fail again on the next refill (see pdjson_user_io).
+      //
+      error = (r == 0 && io->error != NULL && io->error (data));
+      break;
+    }
+  case PDJSON_SOURCE_BUFFER:
+  case PDJSON_SOURCE_NULL:
+    break;
+  }
+
+  if (error)
+  {
+    io_error (json, "unable to read input text");
+    return false;
+  }
+
+  source->source.buffer.length = r;
+  source_limit (json);
+  return source->source.buffer.length != 0;
+}
 
 // See documentation for struct pdjson_user_io on reasonable assumptions
 // around the io failure semantics.
@@ -183,8 +426,22 @@ is_legal_utf8 (const unsigned char *bytes, size_t length)
 static int
 source_peek_slow (pdjson_stream *json, struct pdjson_source *source)
 {
+  stats_add (json, slow_peeks, 1);
+
+  if (source_limited (json, source))
+    return EOF;
+
   switch (source->tag)
   {
+  case PDJSON_SOURCE_BUFFER:
+    {
+      // End of buffer or read-ahead window.
+      //
+      if (source->window.tag == 0 || !source_refill (json, source))
+        return EOF; // IOERROR: set by source_refill().
+
+      return (unsigned char)source->source.buffer.buffer[source->position];
+    }
   case PDJSON_SOURCE_USER:
     {
       int c = source->source.user.io.peek (source->source.user.data);
@@ -209,7 +466,6 @@ source_peek_slow (pdjson_stream *json, struct pdjson_source *source)
 
       return c;
     }
-  case PDJSON_SOURCE_BUFFER:
   case PDJSON_SOURCE_NULL:
     break;
   }
@@ -223,18 +479,31 @@ source_peek (pdjson_stream *json)
 {
   struct pdjson_source *source = &json->source;
 
-  return source->tag == PDJSON_SOURCE_BUFFER
-    ? (source->position != source->source.buffer.length
-       ? source->source.buffer.buffer[source->position]
-       : EOF)
+  return (source->tag == PDJSON_SOURCE_BUFFER &&
+          source->position != source->source.buffer.length)
+    ? (unsigned char)source->source.buffer.buffer[source->position]
     : source_peek_slow (json, source);
 }
 
 static int
 source_get_slow (pdjson_stream *json, struct pdjson_source *source)
 {
+  stats_add (json, slow_gets, 1);
+
+  if (source_limited (json, source))
+    return EOF;
+
   switch (source->tag)
   {
+  case PDJSON_SOURCE_BUFFER:
+    {
+      // End of buffer or read-ahead window.
+      //
+      if (source->window.tag == 0 || !source_refill (json, source))
+        return EOF; // IOERROR: set by source_refill().
+
+      return (unsigned char)source->source.buffer.buffer[source->position++];
+    }
   case PDJSON_SOURCE_USER:
     {
       int c = source->source.user.io.get (source->source.user.data);
@@ -260,7 +529,6 @@ source_get_slow (pdjson_stream *json, struct pdjson_source *source)
 
       return c;
     }
-  case PDJSON_SOURCE_BUFFER:
   case PDJSON_SOURCE_NULL:
     break;
   }
@@ -274,27 +542,73 @@ source_get (pdjson_stream *json)
 {
   struct pdjson_source *source = &json->source;
 
-  return source->tag == PDJSON_SOURCE_BUFFER
-    ? (source->position != source->source.buffer.length
-       ? source->source.buffer.buffer[source->position++]
-       : EOF)
+  return (source->tag == PDJSON_SOURCE_BUFFER &&
+          source->position != source->source.buffer.length)
+    ? (unsigned char)source->source.buffer.buffer[source->position++]
     : source_get_slow (json, source);
 }
 
-// Given the first byte of input or EOF (-1), read and decode the remaining
-// bytes of a UTF-8 sequence (if any) and return its single-quoted UTF-8
-// representation (e.g., "'A'") or, for control characters, its name (e.g.,
-// "newline").
+// For the buffer input (including the read-ahead window) the tokenizer loops
+// that consume runs of bytes that need no special handling (spaces, plain
+// string characters, digits) scan the buffer directly, keeping the cursor in
+// a local variable and only writing the position back at the end of the run.
+// The rest is handled with source_get()/source_peek() as usual.
 //
-// Note: the passed character must be consumed, not peeked at (an exception
-// can be made for EOF).
+// Return the beginning of the unread bytes in the buffer input setting end
+// to their end or NULL if the input is not a buffer or there are no unread
+// bytes. If copy is true, then also limit the run to the free space in the
+// name/value buffer so that it is grown as if by pushchar().
 //
-// See also read_space() for similar code.
+static inline const unsigned char *
+source_run (pdjson_stream *json, const unsigned char **end, bool copy)
+{
+  struct pdjson_source *source = &json->source;
+
+  if (source->tag != PDJSON_SOURCE_BUFFER ||
+      source->position == source->source.buffer.length)
+    return NULL;
+
+  const unsigned char *b = (const unsigned char *)source->source.buffer.buffer;
+  const unsigned char *p = b + source->position;
+  const unsigned char *e = b + source->source.buffer.length;
+
+  if (copy && !(json->flags & FLAG_VALIDATE))
+  {
+    size_t n = json->data.string_size - json->data.string_fill;
+
+    if ((size_t)(e - p) > n)
+      e = p + n;
+  }
+
+  *end = e;
+  return p;
+}
+
+// Consume the run of n bytes starting at p returned by source_run() and, if
+// copy is true, append them to the name/value buffer.
 //
-// Note that this function may set FLAG_ERROR in case of an io error.
+static inline void
+source_run_end (pdjson_stream *json,
+                const unsigned char *p,
+                size_t n,
+                bool copy)
+{
+  json->source.position += n;
+
+  if (copy && !(json->flags & FLAG_VALIDATE))
+  {
+    memcpy (json->data.string + json->data.string_fill, p, n);
+    json->data.string_fill += n;
+
+    stats_add (json, string_bytes, n);
+  }
+}
+
+// Return the name of EOF (-1) or an ASCII control character (e.g.,
+// "newline") or NULL if the character is not one of those.
 //
 static const char *
-diag_char (pdjson_stream *json, int c)
+diag_char_name (int c)
 {
   if (c == EOF)
     return "end of text";
@@ -309,13 +623,44 @@ diag_char (pdjson_stream *json, int c)
   case '\f': return "form feed";
   case '\r': return "carrige return";
   default:
-    if (c <= 31)
+    if (c >= 0 && c <= 31)
     {
       //snprintf (..., "control character %02lx", c);
       return "control character";
     }
   }
 
+  return NULL;
+}
+
+// Given the first byte of input or EOF (-1), read and decode the remaining
+// bytes of a UTF-8 sequence (if any) and return its single-quoted UTF-8
+// representation (e.g., "'A'") or, for control characters, its name (e.g.,
+// "newline").
+//
+// Note: the passed character must be consumed, not peeked at (an exception
+// can be made for EOF).
+//
+// See also read_space() for similar code.
+//
+// Note that this function may set FLAG_ERROR in case of an io error.
+//
+static const char *
+diag_char (pdjson_stream *json, int c)
+{
+  const char *r = diag_char_name (c);
+
+  if (r != NULL)
+  {
+    // Note that the newline is consumed by the caller but without the line
+    // housekeeping (see pdjson_recover()).
+    //
+    if (c == '\n')
+      json->flags |= FLAG_ERROR_NEWLINE;
+
+    return r;
+  }
+
   size_t i = 0;
   char *s = json->utf8_char;
 
@@ -356,8 +701,15 @@ diag_char_string (pdjson_stream *json, const char* u)
 {
   char c = *u;
 
+  // Note that the character is not consumed from input and so we don't
+  // call diag_char() for ASCII, which would flag a newline as consumed.
+  //
   if ((unsigned char)c < 0x80)
-    return diag_char (json, c);
+  {
+    const char *r = diag_char_name (c);
+    if (r != NULL)
+      return r;
+  }
 
   size_t i = 0;
   char *s = json->utf8_char;
@@ -380,18 +732,27 @@ diag_char_string (pdjson_stream *json, const char* u)
 static const char *
 diag_codepoint (pdjson_stream *json, uint32_t c)
 {
+  // Note that the codepoint is peeked at rather than consumed and so we
+  // don't call diag_char(), which would flag a newline as consumed.
+  //
   if (c == (uint32_t)-1 /* EOF */)
-    return diag_char (json, EOF);
+    return diag_char_name (EOF);
 
   if (c < 0x80)
-    return diag_char (json, (int)c);
+  {
+    const char *r = diag_char_name ((int)c);
+    if (r != NULL)
+      return r;
+  }
 
   size_t i = 0;
   char *s = json->utf8_char;
 
   s[i++] = '\'';
 
-  if (c < 0x0800)
+  if (c < 0x80)
+    s[i++] = (char)c;
+  else if (c < 0x0800)
   {
     s[i++] = (c >> 6 & 0x1F) | 0xC0;
     s[i++] = (c >> 0 & 0x3F) | 0x80;
@@ -458,6 +819,9 @@ push (pdjson_stream *json, enum pdjson_type type)
 
     json->stack_size += LIBPDJSON5_STACK_INC;
     json->stack = stack;
+
+    stats_add (json, stack_grows, 1);
+    trace2 (stack_grow, json, json->stack_size);
   }
 
   json->stack[new_stack_top].type = type;
@@ -465,6 +829,8 @@ push (pdjson_stream *json, enum pdjson_type type)
 
   json->stack_top = new_stack_top;
 
+  stats_max (json, max_depth, new_stack_top + 1);
+
   return type;
 }
 
@@ -485,6 +851,11 @@ pop (pdjson_stream *json, enum pdjson_type type)
 static bool
 pushchar (pdjson_stream *json, int c)
 {
+  if (json->flags & FLAG_VALIDATE)
+    return true;
+
+  stats_add (json, string_bytes, 1);
+
   if (json->data.string_fill == json->data.string_size)
   {
     size_t size = json->data.string_size * 2;
@@ -502,6 +873,10 @@ pushchar (pdjson_stream *json, int c)
 
     json->data.string_size = size;
     json->data.string = buffer;
+
+    stats_add (json, string_grows, 1);
+    stats_max (json, string_peak, size);
+    trace2 (string_grow, json, size);
   }
 
   json->data.string[json->data.string_fill++] = c;
@@ -555,7 +930,7 @@ is_match_string (pdjson_stream *json,
                  uint64_t* colno,      // Adjusted in case of an error.
                  enum pdjson_type type)
 {
-  const char *string = json->data.string + 1;
+  const char *string = json->data.string + json->data.string_start + 1;
 
   size_t i = 0;
   for (int p; (p = pattern[i + 1]); i++)
@@ -611,6 +986,28 @@ init_string (pdjson_stream *json)
     mem_error (json, "out of memory");
     return false;
   }
+
+  stats_max (json, string_peak, json->data.string_size);
+  return true;
+}
+
+// Prepare the string buffer for reading a new name or value. Normally the
+// value starts at the beginning of the buffer but in the batch mode (see
+// pdjson_next_batch()) the values are accumulated.
+//
+static bool
+start_string (pdjson_stream *json)
+{
+  if (json->flags & FLAG_VALIDATE)
+    return true;
+
+  if (json->data.string == NULL && !init_string (json))
+    return false;
+
+  json->data.string_start = (json->flags & FLAG_BATCH
+                             ? json->data.string_fill
+                             : 0);
+  json->data.string_fill = json->data.string_start;
   return true;
 }
 
@@ -657,33 +1054,10 @@ encode_utf8 (pdjson_stream *json, uint32_t c)
 static int
 hexchar (int c)
 {
-  switch (c)
-  {
-  case '0': return 0;
-  case '1': return 1;
-  case '2': return 2;
-  case '3': return 3;
-  case '4': return 4;
-  case '5': return 5;
-  case '6': return 6;
-  case '7': return 7;
-  case '8': return 8;
-  case '9': return 9;
-  case 'a':
-  case 'A': return 10;
-  case 'b':
-  case 'B': return 11;
-  case 'c':
-  case 'C': return 12;
-  case 'd':
-  case 'D': return 13;
-  case 'e':
-  case 'E': return 14;
-  case 'f':
-  case 'F': return 15;
-  default:
+  if (!is_char_class (c, CHAR_HEX))
     return -1;
-  }
+
+  return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
 }
 
 // Read 4-digit hex number in \uHHHH. Return (uint32_t)-1 if invalid.
@@ -830,8 +1204,10 @@ read_latin (pdjson_stream *json)
 }
 
 static bool
-read_escaped (pdjson_stream *json)
+read_escaped (pdjson_stream *json, uint32_t lang)
 {
+  stats_add (json, escapes, 1);
+
   int c = source_get (json);
   if (c == EOF) // IOERROR
   {
@@ -860,7 +1236,7 @@ read_escaped (pdjson_stream *json)
 
   // Additional JSON5 escapes.
   //
-  if (u == -1 && (json->flags & FLAG_JSON5))
+  if (u == -1 && (lang & FLAG_JSON5))
   {
     if (c == 'x') // \xHH
       return read_latin (json);
@@ -976,16 +1352,26 @@ read_utf8 (pdjson_stream* json, int c)
   return true;
 }
 
-static enum pdjson_type
-read_string (pdjson_stream *json, int quote)
+static force_inline enum pdjson_type
+read_string (pdjson_stream *json, int quote, uint32_t lang)
 {
-  if (json->data.string == NULL && !init_string (json))
+  if (!start_string (json))
     return PDJSON_ERROR;
 
-  json->data.string_fill = 0;
-
   while (true)
   {
+    // Copy the run of characters that need no special handling.
+    //
+    const unsigned char *e, *p = source_run (json, &e, true);
+    if (p != NULL)
+    {
+      const unsigned char *b = p;
+      while (p != e && (char_class[*p] & CHAR_PLAIN) && *p != quote)
+        ++p;
+
+      source_run_end (json, b, (size_t)(p - b), true);
+    }
+
     int c = source_get (json);
     if (c == EOF) // IOERROR
     {
@@ -998,7 +1384,7 @@ read_string (pdjson_stream *json, int quote)
     }
     else if (c == '\\')
     {
-      if (!read_escaped (json))
+      if (!read_escaped (json, lang))
         return PDJSON_ERROR;
     }
     else if ((unsigned int) c >= 0x80)
@@ -1021,10 +1407,13 @@ read_string (pdjson_stream *json, int quote)
       //
       // Note: quote and backslash are handled above.
       //
-      if ((json->flags & FLAG_JSON5)
+      if ((lang & FLAG_JSON5)
           ? (c == '\n' || c == '\r')
           : (c >= 0 && c < 0x20))
       {
+        if (c == '\n')
+          json->flags |= FLAG_ERROR_NEWLINE;
+
         json_error (json, "%s", "unescaped control character in string");
         return PDJSON_ERROR;
       }
@@ -1040,7 +1429,7 @@ read_string (pdjson_stream *json, int quote)
 static inline bool
 is_dec_digit (int c)
 {
-  return c >= '0' && c <= '9';
+  return is_char_class (c, CHAR_DIGIT);
 }
 
 static bool
@@ -1048,8 +1437,22 @@ read_dec_digits (pdjson_stream *json)
 {
   int c;
   size_t nread = 0;
-  while (is_dec_digit (c = source_peek (json))) // IOERROR: not EOF.
+  for (;;)
   {
+    const unsigned char *e, *p = source_run (json, &e, true);
+    if (p != NULL)
+    {
+      const unsigned char *b = p;
+      while (p != e && (char_class[*p] & CHAR_DIGIT))
+        ++p;
+
+      source_run_end (json, b, (size_t)(p - b), true);
+      nread += (size_t)(p - b);
+    }
+
+    if (!is_dec_digit (c = source_peek (json))) // IOERROR: not EOF.
+      break;
+
     source_get (json); // Consume.
     if (!pushchar (json, c))
       return false;
@@ -1071,9 +1474,7 @@ read_dec_digits (pdjson_stream *json)
 static inline bool
 is_hex_digit (int c)
 {
-  return ((c >= '0' && c <= '9') ||
-          (c >= 'a' && c <= 'f') ||
-          (c >= 'A' && c <= 'F'));
+  return is_char_class (c, CHAR_HEX);
 }
 
 static bool
@@ -1102,13 +1503,11 @@ read_hex_digits (pdjson_stream *json)
 // Given a consumed byte that starts a number, read the rest of it.
 //
 static enum pdjson_type
-read_number (pdjson_stream *json, int c)
+read_number (pdjson_stream *json, int c, uint32_t lang)
 {
-  if (json->data.string == NULL && !init_string (json))
+  if (!start_string (json))
     return PDJSON_ERROR;
 
-  json->data.string_fill = 0;
-
   if (!pushchar (json, c))
     return PDJSON_ERROR;
 
@@ -1118,7 +1517,7 @@ read_number (pdjson_stream *json, int c)
   {
     c = source_get (json);
     if (is_dec_digit (c) || // IOERROR: not EOF.
-        ((json->flags & FLAG_JSON5) && (c == 'I' || c == 'N' || c == '.')))
+        ((lang & FLAG_JSON5) && (c == 'I' || c == 'N' || c == '.')))
     {
       if (!pushchar (json, c))
         return PDJSON_ERROR;
@@ -1153,7 +1552,7 @@ read_number (pdjson_stream *json, int c)
 
     if (c == '.' ||  c == 'e' || c == 'E')
       ;
-    else if ((json->flags & FLAG_JSON5) && (c == 'x' || c == 'X'))
+    else if ((lang & FLAG_JSON5) && (c == 'x' || c == 'X'))
     {
       source_get (json); // Consume.
 
@@ -1210,7 +1609,7 @@ read_number (pdjson_stream *json, int c)
     if (!pushchar (json, c))
       return PDJSON_ERROR;
 
-    if ((json->flags & FLAG_JSON5) &&
+    if ((lang & FLAG_JSON5) &&
         !is_dec_digit (source_peek (json))) // IOERROR: subsequent peek/get.
       ; // Trailing dot.
     else if (!read_dec_digits (json))
@@ -1256,26 +1655,16 @@ read_number (pdjson_stream *json, int c)
     : PDJSON_ERROR;
 }
 
+// See Chapter 8, "White Space" in the JSON5 spec for the additional JSON5
+// spaces (\f and \v).
+//
 static inline bool
-is_space (const pdjson_stream *json, int c)
+is_space (int c, uint32_t lang)
 {
-  switch (c)
-  {
-  case ' ':
-  case '\n':
-  case '\t':
-  case '\r':
-    return true;
-
-    // See Chapter 8, "White Space" in the JSON5 spec.
-    //
-  case '\f':
-  case '\v':
-    return json->flags & FLAG_JSON5;
-
-  default:
-    return false;
-  }
+  return is_char_class (c,
+                        (lang & FLAG_JSON5
+                         ? CHAR_SPACE | CHAR_SPACE5
+                         : CHAR_SPACE));
 }
 
 // Given the first byte (consumed), read and decode a multi-byte UTF-8
@@ -1379,6 +1768,8 @@ newline (pdjson_stream *json)
 static int
 skip_comment (pdjson_stream *json, int c)
 {
+  stats_add (json, comment_bytes, c == '#' ? 1 : 2); // `#`, `//`, or `/*`.
+
   switch (c)
   {
   case '/':
@@ -1388,6 +1779,8 @@ skip_comment (pdjson_stream *json, int c)
       //
       while ((c = source_get (json)) != EOF) // IOERROR: return EOF/error flag.
       {
+        stats_add (json, comment_bytes, 1);
+
         if (c == '\n')
         {
           json->flags |= FLAG_NEWLINE;
@@ -1407,11 +1800,14 @@ skip_comment (pdjson_stream *json, int c)
       //
       while ((c = source_get (json)) != EOF) // IOERROR: return EOF/error flag.
       {
+        stats_add (json, comment_bytes, 1);
+
         if (c == '*')
         {
           if (source_peek (json) == '/') // IOERROR: handled by above get().
           {
             c = source_get (json); // Consume closing `/`.
+            stats_add (json, comment_bytes, 1);
             break;
           }
         }
@@ -1435,7 +1831,7 @@ skip_comment (pdjson_stream *json, int c)
 bool
 pdjson_is_space (const pdjson_stream *json, int c)
 {
-  return is_space (json, c);
+  return is_space (c, json->flags & LANG_MASK);
 }
 
 int
@@ -1447,7 +1843,7 @@ pdjson_skip_if_space (pdjson_stream *json, int c, uint32_t* cp)
   if (c == EOF) // IOERROR
     return (json->flags & FLAG_ERROR) ? -1 : 0;
 
-  if (is_space (json, c))
+  if (is_space (c, json->flags & LANG_MASK))
   {
     source_get (json); // Consume.
 
@@ -1524,17 +1920,41 @@ pdjson_skip_if_space (pdjson_stream *json, int c, uint32_t* cp)
 //
 // We will also require \n, not just \r, to be able to omit `,` in JSON5E.
 //
-static int
-next (pdjson_stream *json)
+static force_inline int
+next (pdjson_stream *json, uint32_t lang)
 {
   json->flags &= ~FLAG_NEWLINE;
 
   int c;
   while (true)
   {
+    // Skip the run of spaces.
+    //
+    const unsigned char *e, *p = source_run (json, &e, false);
+    if (p != NULL)
+    {
+      for (const unsigned char *b = p;; ++p)
+      {
+        if (p == e || !(char_class[*p] & CHAR_SPACE))
+        {
+          source_run_end (json, b, (size_t)(p - b), false);
+          break;
+        }
+
+        if (*p == '\n')
+        {
+          source_run_end (json, b, (size_t)(p + 1 - b), false);
+          b = p + 1;
+
+          json->flags |= FLAG_NEWLINE;
+          newline (json);
+        }
+      }
+    }
+
     c = source_get (json); // IOERROR: return EOF/error flag.
 
-    if (is_space (json, c))
+    if (is_space (c, lang))
     {
       if (c == '\n')
       {
@@ -1553,8 +1973,8 @@ next (pdjson_stream *json)
       continue;
     }
 
-    if ((c == '/' && (json->flags & FLAG_JSON5)) ||
-        (c == '#' && (json->flags & FLAG_JSON5E)))
+    if ((c == '/' && (lang & FLAG_JSON5)) ||
+        (c == '#' && (lang & FLAG_JSON5E)))
     {
       if (c == '/')
       {
@@ -1576,8 +1996,8 @@ next (pdjson_stream *json)
 
 // The passed byte is expected to be consumed.
 //
-static enum pdjson_type
-read_value (pdjson_stream *json, int c)
+static force_inline enum pdjson_type
+read_value (pdjson_stream *json, int c, uint32_t lang)
 {
   uint64_t colno = pdjson_get_column (json);
 
@@ -1597,11 +2017,11 @@ read_value (pdjson_stream *json, int c)
     type = push (json, PDJSON_ARRAY);
     break;
   case '\'':
-    if (!(json->flags & FLAG_JSON5))
+    if (!(lang & FLAG_JSON5))
       break;
     // Fall through.
   case '"':
-    type = read_string (json, c);
+    type = read_string (json, c, lang);
     break;
   case 'n':
     type = is_match (json, "null", false /* copy */, PDJSON_NULL);
@@ -1616,7 +2036,7 @@ read_value (pdjson_stream *json, int c)
   case '.': // Leading dot
   case 'I': // Infinity
   case 'N': // NaN
-    if (!(json->flags & FLAG_JSON5))
+    if (!(lang & FLAG_JSON5))
       break;
     // Fall through.
   case '-':
@@ -1630,7 +2050,7 @@ read_value (pdjson_stream *json, int c)
   case '7':
   case '8':
   case '9':
-    type = read_number (json, c);
+    type = read_number (json, c, lang);
     break;
   default:
     break;
@@ -1667,34 +2087,27 @@ read_value (pdjson_stream *json, int c)
 static inline bool
 is_first_id_char (int c)
 {
-  return (c == '_'               ||
-          (c >= 'a' && c <= 'z') ||
-          (c >= 'A' && c <= 'Z') ||
-          c == '$');
+  return is_char_class (c, CHAR_ID);
 }
 
 static inline bool
 is_subseq_id_char (int c, bool extended)
 {
-  return (c == '_'                             ||
-          (c >= 'a' && c <= 'z')               ||
-          (c >= 'A' && c <= 'Z')               ||
-          (c >= '0' && c <= '9')               ||
-          (extended && (c == '-' || c == '.')) ||
-          c == '$');
+  return is_char_class (c,
+                        (extended
+                         ? CHAR_ID | CHAR_DIGIT | CHAR_ID5E
+                         : CHAR_ID | CHAR_DIGIT));
 }
 
 // Read the remainder of an identifier given its first character.
 //
 static enum pdjson_type
-read_identifier (pdjson_stream *json, int c)
+read_identifier (pdjson_stream *json, int c, uint32_t lang)
 {
-  if (json->data.string == NULL && !init_string (json))
+  if (!start_string (json))
     return PDJSON_ERROR;
 
-  json->data.string_fill = 0;
-
-  for (bool extended = (json->flags & FLAG_JSON5E);;)
+  for (bool extended = (lang & FLAG_JSON5E);;)
   {
     if (!pushchar (json, c))
       return PDJSON_ERROR;
@@ -1712,23 +2125,23 @@ read_identifier (pdjson_stream *json, int c)
     : PDJSON_ERROR;
 }
 
-static enum pdjson_type
-read_name (pdjson_stream *json, int c)
+static force_inline enum pdjson_type
+read_name (pdjson_stream *json, int c, uint32_t lang)
 {
   uint64_t colno = pdjson_get_column (json);
 
   json->ntokens++;
 
-  if (c == '"' || ((json->flags & FLAG_JSON5) && c == '\''))
+  if (c == '"' || ((lang & FLAG_JSON5) && c == '\''))
   {
-    if (read_string (json, c) == PDJSON_ERROR)
+    if (read_string (json, c, lang) == PDJSON_ERROR)
       return PDJSON_ERROR;
   }
   // See if this is an unquoted member name.
   //
-  else if ((json->flags & FLAG_JSON5) && is_first_id_char (c))
+  else if ((lang & FLAG_JSON5) && is_first_id_char (c))
   {
-    if (read_identifier (json, c) == PDJSON_ERROR)
+    if (read_identifier (json, c, lang) == PDJSON_ERROR)
       return PDJSON_ERROR;
   }
   else
@@ -1742,6 +2155,9 @@ read_name (pdjson_stream *json, int c)
   return PDJSON_NAME;
 }
 
+lang_instantiate (read_value)
+lang_instantiate (read_name)
+
 enum pdjson_type
 pdjson_peek (pdjson_stream *json)
 {
@@ -1753,158 +2169,617 @@ pdjson_peek (pdjson_stream *json)
   return peek;
 }
 
-enum pdjson_type
-pdjson_next (pdjson_stream *json)
+// Skip the input until (but not including) the specified byte or EOF while
+// keeping the line information up to date. As a special case, the newline
+// byte is consumed. Return false on io error.
+//
+static bool
+skip_until (pdjson_stream *json, int b)
 {
-  if (json->flags & FLAG_ERROR)
-    return PDJSON_ERROR;
-
-  if (json->peek != 0)
+  for (int c;;)
   {
-    enum pdjson_type next = json->peek;
-    json->peek = (enum pdjson_type)0;
-    return next;
-  }
+    c = source_peek (json);
 
-  if (json->pending.type != 0)
-  {
-    enum pdjson_type next = json->pending.type;
-    json->pending.type = (enum pdjson_type)0;
-    json->subtype = json->pending.subtype;
-    json->start_lineno = json->pending.lineno;
-    json->start_colno = json->pending.colno;
+    if (c == EOF)
+      return !(json->flags & FLAG_ERROR);
 
-    if (next == PDJSON_OBJECT_END || next == PDJSON_ARRAY_END)
-      next = pop (json, next);
+    if (c == b && b != '\n')
+      return true;
 
-    return next;
+    source_get (json);
+
+    if (c == '\n')
+    {
+      newline (json);
+
+      if (b == '\n')
+        return true;
+    }
+    else if ((c & 0xC0) == 0x80)
+      json->lineadj++;
   }
+}
 
-  json->subtype = 0;
-  json->start_lineno = 0;
-  json->start_colno = 0;
+// Given that EOF was reached in the length frame, diagnose the end of input
+// before the end of the frame.
+//
+static bool
+check_length_frame (pdjson_stream *json)
+{
+  if (json->posoff + json->source.position != json->frame_end)
+  {
+    json_error (json, "%s", "unexpected end of text in frame");
+    return false;
+  }
 
-  if (json->ntokens > 0 && json->stack_top == (size_t)-1)
+  return true;
+}
+
+// Skip the rest of the length frame while keeping the line information up
+// to date. Return false on io error.
+//
+static bool
+skip_length_frame (pdjson_stream *json)
+{
+  struct pdjson_source *source = &json->source;
+
+  while (true)
   {
-    // In the streaming mode leave any trailing whitespaces in the stream.
-    // This allows the user to validate any desired separation between
-    // values (such as newlines) using pdjson_source_get/peek() with any
-    // remaining whitespaces ignored as leading when we parse the next
-    // value.
+    // For the buffer input (which is limited to the frame end) skip the
+    // available bytes in bulk, only counting newlines and the continuation
+    // bytes on the last line.
     //
-    if (!(json->flags & FLAG_STREAMING))
+    if (source->tag == PDJSON_SOURCE_BUFFER)
     {
-      // If FLAG_IMPLIED_END is set here, then it means we have already seen
-      // EOF.
-      //
-      if (!(json->flags & FLAG_IMPLIED_END))
+      const char *b = source->source.buffer.buffer;
+      size_t e = source->source.buffer.length;
+      size_t p = (size_t)source->position;
+
+      for (const char *n;
+           p != e && (n = (const char *)memchr (b + p, '\n', e - p)) != NULL; )
       {
-        int c = next (json);
-        if (json->flags & FLAG_ERROR)
-          return PDJSON_ERROR;
+        source->position = p = (size_t)(n - b) + 1;
+        newline (json);
+      }
 
-        if (c != EOF)
-        {
-          json_error (json,
-                      "expected end of text instead of %s",
-                      diag_char (json, c));
-          return PDJSON_ERROR;
-        }
+      for (; p != e; ++p)
+      {
+        if (((unsigned char)b[p] & 0xC0) == 0x80)
+          json->lineadj++;
       }
+
+      source->position = e;
     }
 
-    return PDJSON_DONE;
+    int c = source_get (json);
+
+    if (c == EOF)
+      return !(json->flags & FLAG_ERROR) && check_length_frame (json);
+
+    if (c == '\n')
+      newline (json);
+    else if ((c & 0xC0) == 0x80)
+      json->lineadj++;
   }
+}
 
-  int c = next (json);
-  if (json->flags & FLAG_ERROR)
-    return PDJSON_ERROR;
+// Given the first consumed character, read the length frame prefix and
+// limit the input to the end of the frame. Return false on error.
+//
+static bool
+begin_length_frame (pdjson_stream *json, int c)
+{
+  if (c < '0' || c > '9')
+  {
+    json_error (json,
+                "expected frame length instead of %s",
+                diag_char (json, c));
+    return false;
+  }
 
-  if (json->stack_top != (size_t)-1)
+  uint64_t n = (uint64_t)(c - '0');
+  for (; (c = source_peek (json)) >= '0' && c <= '9'; source_get (json))
   {
-    if (json->stack[json->stack_top].type == PDJSON_OBJECT)
+    if (n > (UINT64_MAX - 9) / 10)
     {
-      if (json->stack[json->stack_top].count == 0)
+      json_error (json, "%s", "frame length too large");
+      return false;
+    }
+
+    n = n * 10 + (uint64_t)(c - '0');
+  }
+
+  if ((c = source_get (json)) == '\r')
+    c = source_get (json);
+
+  if (c != '\n')
+  {
+    json_error (json,
+                "expected newline after frame length instead of %s",
+                diag_char (json, c));
+    return false;
+  }
+
+  newline (json);
+
+  json->frame_end = json->posoff + json->source.position + n;
+  json->flags |= FLAG_FRAME;
+  source_limit (json);
+  return true;
+}
+
+// Return true if the line contains all the prefilter patterns.
+//
+static bool
+prefilter_match (const pdjson_stream *json, const char *b, size_t n)
+{
+  for (size_t i = 0; i != json->prefilter_size; ++i)
+  {
+    const char *p = json->prefilter[i];
+    size_t m = strlen (p);
+
+    if (m == 0)
+      continue;
+
+    // Find the candidate first byte with memchr() and compare the rest.
+    //
+    const char *s = b, *e = b + n;
+    for (; (size_t)(e - s) >= m; ++s)
+    {
+      s = (const char *)memchr (s, p[0], (size_t)(e - s) - m + 1);
+
+      if (s == NULL)
+        return false;
+
+      if (memcmp (s + 1, p + 1, m - 1) == 0)
+        break;
+    }
+
+    if ((size_t)(e - s) < m)
+      return false;
+  }
+
+  return true;
+}
+
+// Skip the lines that don't pass the prefilter in the line framing mode.
+//
+static void
+prefilter_lines (pdjson_stream *json)
+{
+  struct pdjson_source *source = &json->source;
+
+  while (source->tag == PDJSON_SOURCE_BUFFER)
+  {
+    const char *b = source->source.buffer.buffer;
+    size_t e = source->source.buffer.length;
+    size_t p = (size_t)source->position;
+
+    // Refill the read-ahead window, if necessary.
+    //
+    if (p == e)
+    {
+      if (source_peek (json) == EOF) // IOERROR: error flag.
+        break;
+
+      continue;
+    }
+
+    // If the newline is not found, then the line is only complete if this
+    // is the buffer input (as opposed to the read-ahead window).
+    //
+    const char *n = (const char *)memchr (b + p, '\n', e - p);
+    size_t le = n != NULL ? (size_t)(n - b) : e;
+
+    if ((n == NULL && source->window.tag != 0) ||
+        prefilter_match (json, b + p, le - p))
+      break;
+
+    if (n != NULL)
+    {
+      source->position = le + 1;
+      newline (json);
+    }
+    else
+    {
+      for (; p != e; ++p)
       {
-        // No member name/value pairs yet.
-        //
-        if (c == '}')
-          return pop (json, PDJSON_OBJECT_END);
+        if (((unsigned char)b[p] & 0xC0) == 0x80)
+          json->lineadj++;
+      }
 
-        json->stack[json->stack_top].count++;
+      source->position = e;
+    }
+  }
+}
+
+// Begin the next frame and return the first character of the value as
+// next() would. Return EOF if there are no more frames or on error.
+//
+static int
+begin_frame (pdjson_stream *json)
+{
+  if (json->framing == PDJSON_FRAMING_LINE && json->prefilter_size != 0)
+    prefilter_lines (json);
+
+  int c = next (json, json->flags & LANG_MASK);
+
+  if (c == EOF)
+    return EOF; // IOERROR: error flag.
 
-        return read_name (json, c);
+  switch (json->framing)
+  {
+  case PDJSON_FRAMING_RS:
+    {
+      if (c != '\x1E')
+      {
+        json_error (json,
+                    "expected record separator instead of %s",
+                    diag_char (json, c));
+        return EOF;
       }
-      else if ((json->stack[json->stack_top].count % 2) == 0)
+
+      // Skip empty records.
+      //
+      while ((c = next (json, json->flags & LANG_MASK)) == '\x1E')
+        ;
+
+      break;
+    }
+  case PDJSON_FRAMING_LINE:
+    {
+      json->frame_line = json->lineno;
+      break;
+    }
+  case PDJSON_FRAMING_LENGTH:
+    {
+      if (!begin_length_frame (json, c))
+        return EOF;
+
+      if ((c = next (json, json->flags & LANG_MASK)) == EOF &&
+          !(json->flags & FLAG_ERROR))
+        json_error (json, "%s", "empty frame");
+
+      return c;
+    }
+  case PDJSON_FRAMING_NONE:
+    break;
+  }
+
+  if (c != EOF)
+    json->flags |= FLAG_FRAME;
+
+  return c;
+}
+
+// End the current frame after the value has been parsed. Return false on
+// error.
+//
+static bool
+end_frame (pdjson_stream *json)
+{
+  switch (json->framing)
+  {
+  case PDJSON_FRAMING_RS:
+    {
+      // Require a newline after the value, which is how truncated values
+      // (for example, numbers) are detected (RFC 7464, Section 2.4). Note
+      // that a newline at the end of a comment counts.
+      //
+      bool nl = false;
+      for (int c;;)
       {
-        // Expecting comma followed by member name or closing brace.
-        //
-        // In JSON5 comma can be followed directly by the closing brace. And
-        // in JSON5E it can also be followed by EOF in case of an implied
-        // top-level object.
-        //
-        // In JSON5E comma can be omitted provided the preceding value and the
-        // following name are separated by a newline. Or, to put it another
-        // way, in this mode, if a newline was seen by the above call to
-        // next() and the returned character is not '}' and, in the implied
-        // case, not EOF, then we can rightfully expect a name.
-        //
-        bool implied = json->stack_top == 0 && (json->flags & FLAG_IMPLIED_END);
-        if (c == ',')
+        c = source_peek (json);
+
+        if (c == '\x1E' || c == EOF)
         {
-          c = next (json);
           if (json->flags & FLAG_ERROR)
-            return PDJSON_ERROR;
+            return false;
 
-          if (((json->flags & FLAG_JSON5) && c == '}') ||
-              (implied && c == EOF))
-            ; // Fall through.
-          else
+          if (!nl)
           {
-            json->stack[json->stack_top].count++;
-            return read_name (json, c);
+            json_error (json,
+                        "expected newline after value instead of %s",
+                        c == EOF ? "end of text" : "record separator");
+            return false;
           }
+
+          break;
         }
-        else if (json->flags & FLAG_JSON5E  &&
-                 json->flags & FLAG_NEWLINE &&
-                 c != '}' && (!implied || c != EOF))
+
+        if (c == '\n')
         {
-          json->stack[json->stack_top].count++;
-          return read_name (json, c);
+          source_get (json);
+          nl = true;
+          newline (json);
+          continue;
         }
 
-        if (!implied)
-        {
-          if (c == '}')
-            return pop (json, PDJSON_OBJECT_END);
+        json->flags &= ~FLAG_NEWLINE;
+
+        int r = pdjson_skip_if_space (json, c, NULL);
+
+        if (r == -1)
+          return false;
 
+        if (r == 0)
+        {
+          source_get (json);
           json_error (json,
-                      "%s",
-                      ((json->flags & FLAG_JSON5E)
-                       ? "expected '}', newline, or ',' after member value"
-                       : "expected ',' or '}' after member value"));
-          return PDJSON_ERROR;
+                      (nl
+                       ? "expected record separator instead of %s"
+                       : "expected newline after value instead of %s"),
+                      diag_char (json, c));
+          return false;
         }
 
-        // Handle implied `}`.
+        // Don't report the location of the comment (see
+        // pdjson_skip_if_space()).
         //
-        if (c == EOF)
-        {
-          json->pending.type = PDJSON_DONE;
-          json->pending.subtype = 0;
-          json->pending.lineno = 0;
-          json->pending.colno = 0;
+        json->start_lineno = 0;
+        json->start_colno = 0;
 
-          return pop (json, PDJSON_OBJECT_END);
-        }
+        if (json->flags & FLAG_NEWLINE)
+          nl = true;
+      }
 
-        if (c == '}')
-        {
-          json_error (json, "%s", "explicit '}' in implied object");
-        }
-        else
+      break;
+    }
+  case PDJSON_FRAMING_LINE:
+    {
+      if (json->lineno != json->frame_line)
+      {
+        json_error (json, "%s", "value spans multiple lines");
+        return false;
+      }
+
+      // Skip trailing whitespaces/comments until the end of the line. Note
+      // that a single-line comment includes the newline while a multi-line
+      // comment cannot span the end of the line.
+      //
+      for (int c;;)
+      {
+        if ((c = source_peek (json)) == '\n')
         {
-          json_error (json, "%s", "expected newline or ',' after member value");
+          source_get (json);
+          newline (json);
+          break;
+        }
+
+        uint32_t cp;
+        int r = pdjson_skip_if_space (json, c, &cp);
+
+        if (r == -1)
+          return false;
+
+        if (r == 0)
+        {
+          if (c == EOF)
+            break;
+
+          source_get (json);
+          json_error (json,
+                      "expected newline after value instead of %s",
+                      diag_char (json, c));
+          return false;
+        }
+
+        if (json->lineno != json->frame_line && cp == '*')
+        {
+          json_error (json, "%s", "comment spans multiple lines");
+          return false;
+        }
+
+        json->start_lineno = 0;
+        json->start_colno = 0;
+
+        if (json->lineno != json->frame_line)
+          break;
+      }
+
+      break;
+    }
+  case PDJSON_FRAMING_LENGTH:
+    {
+      // Skip trailing whitespaces/comments until the end of the frame.
+      //
+      int c = next (json, json->flags & LANG_MASK);
+
+      if (json->flags & FLAG_ERROR)
+        return false;
+
+      if (c != EOF)
+      {
+        json_error (json,
+                    "expected end of frame instead of %s",
+                    diag_char (json, c));
+        return false;
+      }
+
+      if (!check_length_frame (json))
+        return false;
+
+      source_unlimit (json);
+      break;
+    }
+  case PDJSON_FRAMING_NONE:
+    break;
+  }
+
+  json->flags &= ~FLAG_FRAME;
+  return true;
+}
+
+// Return the next event.
+//
+// The language is passed as a constant to this function and the tokenizer
+// functions it calls (next(), read_value(), read_name(), etc) so that each
+// language gets its own instantiation without any runtime tests for the
+// features it does not support. The instantiation is selected based on the
+// language flags set by pdjson_set_language() (see pdjson_next()).
+//
+static force_inline enum pdjson_type
+next_event (pdjson_stream *json, uint32_t lang)
+{
+  if (json->flags & FLAG_ERROR)
+    return PDJSON_ERROR;
+
+  if (json->peek != 0)
+  {
+    enum pdjson_type next = json->peek;
+    json->peek = (enum pdjson_type)0;
+    return next;
+  }
+
+  if (json->pending.type != 0)
+  {
+    enum pdjson_type next = json->pending.type;
+    json->pending.type = (enum pdjson_type)0;
+    json->subtype = json->pending.subtype;
+    json->start_lineno = json->pending.lineno;
+    json->start_colno = json->pending.colno;
+
+    if (next == PDJSON_OBJECT_END || next == PDJSON_ARRAY_END)
+      next = pop (json, next);
+
+    return next;
+  }
+
+  json->subtype = 0;
+  json->start_lineno = 0;
+  json->start_colno = 0;
+
+  if (json->ntokens > 0 && json->stack_top == (size_t)-1)
+  {
+    if ((json->flags & FLAG_FRAME) && !end_frame (json))
+      return PDJSON_ERROR;
+
+    // In the streaming mode leave any trailing whitespaces in the stream.
+    // This allows the user to validate any desired separation between
+    // values (such as newlines) using pdjson_source_get/peek() with any
+    // remaining whitespaces ignored as leading when we parse the next
+    // value.
+    //
+    if (!(json->flags & FLAG_STREAMING))
+    {
+      // If FLAG_IMPLIED_END is set here, then it means we have already seen
+      // EOF.
+      //
+      if (!(json->flags & FLAG_IMPLIED_END))
+      {
+        int c = next (json, lang);
+        if (json->flags & FLAG_ERROR)
+          return PDJSON_ERROR;
+
+        if (c != EOF)
+        {
+          json_error (json,
+                      "expected end of text instead of %s",
+                      diag_char (json, c));
+          return PDJSON_ERROR;
+        }
+      }
+    }
+
+    return PDJSON_DONE;
+  }
+
+  // Begin the next frame at the beginning of a value in the framing mode.
+  //
+  int c = (json->stack_top == (size_t)-1          &&
+           json->framing != PDJSON_FRAMING_NONE   &&
+           json->ntokens == 0                     &&
+           !(json->flags & FLAG_FRAME)
+           ? begin_frame (json)
+           : next (json, lang));
+  if (json->flags & FLAG_ERROR)
+    return PDJSON_ERROR;
+
+  if (json->stack_top != (size_t)-1)
+  {
+    if (json->stack[json->stack_top].type == PDJSON_OBJECT)
+    {
+      if (json->stack[json->stack_top].count == 0)
+      {
+        // No member name/value pairs yet.
+        //
+        if (c == '}')
+          return pop (json, PDJSON_OBJECT_END);
+
+        json->stack[json->stack_top].count++;
+
+        return lang_call (lang, read_name, json, c);
+      }
+      else if ((json->stack[json->stack_top].count % 2) == 0)
+      {
+        // Expecting comma followed by member name or closing brace.
+        //
+        // In JSON5 comma can be followed directly by the closing brace. And
+        // in JSON5E it can also be followed by EOF in case of an implied
+        // top-level object.
+        //
+        // In JSON5E comma can be omitted provided the preceding value and the
+        // following name are separated by a newline. Or, to put it another
+        // way, in this mode, if a newline was seen by the above call to
+        // next() and the returned character is not '}' and, in the implied
+        // case, not EOF, then we can rightfully expect a name.
+        //
+        bool implied = json->stack_top == 0 && (json->flags & FLAG_IMPLIED_END);
+        if (c == ',')
+        {
+          c = next (json, lang);
+          if (json->flags & FLAG_ERROR)
+            return PDJSON_ERROR;
+
+          if (((lang & FLAG_JSON5) && c == '}') ||
+              (implied && c == EOF))
+            ; // Fall through.
+          else
+          {
+            json->stack[json->stack_top].count++;
+            return lang_call (lang, read_name, json, c);
+          }
+        }
+        else if (lang & FLAG_JSON5E         &&
+                 json->flags & FLAG_NEWLINE &&
+                 c != '}' && (!implied || c != EOF))
+        {
+          json->stack[json->stack_top].count++;
+          return lang_call (lang, read_name, json, c);
+        }
+
+        if (!implied)
+        {
+          if (c == '}')
+            return pop (json, PDJSON_OBJECT_END);
+
+          json_error (json,
+                      "%s",
+                      ((lang & FLAG_JSON5E)
+                       ? "expected '}', newline, or ',' after member value"
+                       : "expected ',' or '}' after member value"));
+          return PDJSON_ERROR;
+        }
+
+        // Handle implied `}`.
+        //
+        if (c == EOF)
+        {
+          json->pending.type = PDJSON_DONE;
+          json->pending.subtype = 0;
+          json->pending.lineno = 0;
+          json->pending.colno = 0;
+
+          return pop (json, PDJSON_OBJECT_END);
+        }
+
+        if (c == '}')
+        {
+          json_error (json, "%s", "explicit '}' in implied object");
+        }
+        else
+        {
+          json_error (json, "%s", "expected newline or ',' after member value");
         }
 
         return PDJSON_ERROR;
@@ -1915,13 +2790,13 @@ pdjson_next (pdjson_stream *json)
         //
         if (c == ':')
         {
-          c = next (json);
+          c = next (json, lang);
           if (json->flags & FLAG_ERROR)
             return PDJSON_ERROR;
 
           json->stack[json->stack_top].count++;
 
-          return read_value (json, c);
+          return lang_call (lang, read_value, json, c);
         }
 
         json_error (json, "%s", "expected ':' after member name");
@@ -1942,7 +2817,7 @@ pdjson_next (pdjson_stream *json)
           return pop (json, PDJSON_ARRAY_END);
 
         json->stack[json->stack_top].count++;
-        return read_value (json, c);
+        return lang_call (lang, read_value, json, c);
       }
 
       // Expecting comma followed by array value or closing brace.
@@ -1957,24 +2832,24 @@ pdjson_next (pdjson_stream *json)
       //
       if (c == ',')
       {
-        c = next (json);
+        c = next (json, lang);
         if (json->flags & FLAG_ERROR)
           return PDJSON_ERROR;
 
-        if ((json->flags & FLAG_JSON5) && c == ']')
+        if ((lang & FLAG_JSON5) && c == ']')
           ; // Fall through.
         else
         {
           json->stack[json->stack_top].count++;
-          return read_value (json, c);
+          return lang_call (lang, read_value, json, c);
         }
       }
-      else if (json->flags & FLAG_JSON5E  &&
+      else if (lang & FLAG_JSON5E         &&
                json->flags & FLAG_NEWLINE &&
                c != ']')
       {
         json->stack[json->stack_top].count++;
-        return read_value (json, c);
+        return lang_call (lang, read_value, json, c);
       }
 
       if (c == ']')
@@ -1982,7 +2857,7 @@ pdjson_next (pdjson_stream *json)
 
       json_error (json,
                   "%s",
-                  ((json->flags & FLAG_JSON5E)
+                  ((lang & FLAG_JSON5E)
                    ? "expected ']', newline, or ',' after array value"
                    : "expected ',' or ']' after array value"));
       return PDJSON_ERROR;
@@ -2007,7 +2882,7 @@ pdjson_next (pdjson_stream *json)
     // - Line/columns numbers for implied `{` and `}` are of the first
     //   member name and EOF, respectively.
     //
-    if ((json->flags & FLAG_JSON5E) &&
+    if ((lang & FLAG_JSON5E) &&
         !(json->flags & FLAG_STREAMING))
     {
       bool id;
@@ -2018,9 +2893,19 @@ pdjson_next (pdjson_stream *json)
 
         json->ntokens++;
 
-        if ((id
-             ? read_identifier (json, c)
-             : read_string (json, c)) == PDJSON_ERROR)
+        // Note that we need the identifier in the string buffer for the
+        // literal checks below even in the validation mode.
+        //
+        uint32_t validate = json->flags & FLAG_VALIDATE;
+        json->flags &= ~FLAG_VALIDATE;
+
+        enum pdjson_type r = (id
+                              ? read_identifier (json, c, lang)
+                              : read_string (json, c, lang));
+
+        json->flags |= validate;
+
+        if (r == PDJSON_ERROR)
           return PDJSON_ERROR;
 
         enum pdjson_type type;
@@ -2051,7 +2936,7 @@ pdjson_next (pdjson_stream *json)
             else if ((unsigned int)c < 0x80) ncp = (uint32_t)c;
           }
 
-          if (!is_space (json, c) && c != '/' && c != '#')
+          if (!is_space (c, lang) && c != '/' && c != '#')
           {
             if (c == EOF || (unsigned int)c < 0x80) // IOERROR
               break;
@@ -2121,7 +3006,9 @@ pdjson_next (pdjson_stream *json)
           //
           if (id)
           {
-            switch (json->data.string[0])
+            const char *string = json->data.string + json->data.string_start;
+
+            switch (string[0])
             {
             case 'n':
               type = is_match_string (json, "null", ncp , &colno, PDJSON_NULL);
@@ -2141,7 +3028,7 @@ pdjson_next (pdjson_stream *json)
             default:
               json_error (json,
                           "unexpected %s in value",
-                          diag_char_string (json, json->data.string));
+                          diag_char_string (json, string));
               type = PDJSON_ERROR;
             }
           }
@@ -2163,109 +3050,867 @@ pdjson_next (pdjson_stream *json)
         else
           return PDJSON_ERROR; // IOERROR (don't override location).
 
-        // Note: set even in case of an error since peek() above moved the
-        // position past the name/value.
-        //
-        json->start_lineno = lineno;
-        json->start_colno = colno;
+        // Note: set even in case of an error since peek() above moved the
+        // position past the name/value.
+        //
+        json->start_lineno = lineno;
+        json->start_colno = colno;
+
+        return type;
+      }
+      else if (c == EOF)
+      {
+        // Allow empty implied objects (for example, all members commented
+        // out).
+        //
+        json->pending.type = PDJSON_OBJECT_END;
+        json->pending.subtype = 0;
+        json->pending.lineno = 0;
+        json->pending.colno = 0;
+
+        json->flags |= FLAG_IMPLIED_END;
+
+        json->start_lineno = 1;
+        json->start_colno = 1;
+
+        // Note that we need to push an object entry into the stack to make
+        // sure pdjson_get_context() works correctly.
+        //
+        json->ntokens++; // For `{`.
+        return push (json, PDJSON_OBJECT);
+      }
+      // Else fall through.
+    }
+
+    return lang_call (lang, read_value, json, c);
+  }
+}
+
+// Return the next event counting/tracing it unless it was peeked at (in
+// which case it was counted/traced when peeked at).
+//
+// Besides pdjson_next(), this function is also called directly by the
+// functions that parse further (pdjson_parse_callbacks(), etc) so that
+// their loops are instantiated for each language, the same as
+// next_event().
+//
+static force_inline enum pdjson_type
+next_event_counted (pdjson_stream *json, uint32_t lang)
+{
+#if defined(LIBPDJSON5_STATS) || defined(LIBPDJSON5_SDT)
+  bool peeked = json->peek != 0;
+  enum pdjson_type type = next_event (json, lang);
+
+  if (!peeked)
+  {
+    stats_add (json, events[type], 1);
+    trace3 (event, json, (int)type, json->stack_top + 1);
+
+    if (type == PDJSON_ERROR)
+      trace4 (error,
+              json,
+              (int)json->subtype,
+              (const char *)json->error_message,
+              json->lineno);
+  }
+
+  return type;
+#else
+  return next_event (json, lang);
+#endif
+}
+
+static enum pdjson_type
+next_event_json (pdjson_stream *json)
+{
+  return next_event_counted (json, LANG_JSON);
+}
+
+static enum pdjson_type
+next_event_json5 (pdjson_stream *json)
+{
+  return next_event_counted (json, LANG_JSON5);
+}
+
+static enum pdjson_type
+next_event_json5e (pdjson_stream *json)
+{
+  return next_event_counted (json, LANG_JSON5E);
+}
+
+enum pdjson_type
+pdjson_next (pdjson_stream *json)
+{
+  return lang_call (json->flags & LANG_MASK, next_event, json);
+}
+
+// Parse up to n next events into the events array (see pdjson_next_batch()).
+//
+static force_inline size_t
+next_batch (pdjson_stream *json,
+            pdjson_event *events,
+            size_t n,
+            uint32_t lang)
+{
+  size_t i = 0;
+  while (i != n)
+  {
+    enum pdjson_type type = next_event_counted (json, lang);
+    pdjson_event *e = events + i++;
+
+    e->type = type;
+    e->depth = json->stack_top + 1;
+
+    if (type == PDJSON_NAME || type == PDJSON_STRING || type == PDJSON_NUMBER)
+    {
+      e->offset = json->data.string_start;
+      e->size = json->data.string_fill - json->data.string_start;
+    }
+    else
+    {
+      e->offset = 0;
+      e->size = 0;
+
+      if (type == PDJSON_DONE || type == PDJSON_ERROR)
+        break;
+    }
+  }
+
+  return i;
+}
+
+static size_t
+next_batch_json (pdjson_stream *json, pdjson_event *events, size_t n)
+{
+  return next_batch (json, events, n, LANG_JSON);
+}
+
+static size_t
+next_batch_json5 (pdjson_stream *json, pdjson_event *events, size_t n)
+{
+  return next_batch (json, events, n, LANG_JSON5);
+}
+
+static size_t
+next_batch_json5e (pdjson_stream *json, pdjson_event *events, size_t n)
+{
+  return next_batch (json, events, n, LANG_JSON5E);
+}
+
+size_t
+pdjson_next_batch (pdjson_stream *json, pdjson_event *events, size_t n)
+{
+  // Start accumulating the names/values from the beginning of the string
+  // buffer unless there is a peeked at or pending event whose value is
+  // already there.
+  //
+  if (json->peek == 0 && json->pending.type == 0)
+  {
+    json->data.string_fill = 0;
+    json->data.string_start = 0;
+  }
+
+  json->flags |= FLAG_BATCH;
+
+  size_t r = lang_call (json->flags & LANG_MASK,
+                        next_batch,
+                        json, events, n);
+
+  json->flags &= ~FLAG_BATCH;
+
+  return r;
+}
+
+const char *
+pdjson_get_batch_data (const pdjson_stream *json)
+{
+  return json->data.string == NULL ? "" : json->data.string;
+}
+
+// Parse the next value calling the handlers (see pdjson_parse_callbacks()).
+//
+static force_inline enum pdjson_type
+parse_callbacks (pdjson_stream *json,
+                 const pdjson_handler *h,
+                 void *context,
+                 uint32_t lang)
+{
+  while (true)
+  {
+    enum pdjson_type type = next_event_counted (json, lang);
+    enum pdjson_handler_result r = PDJSON_HANDLER_CONTINUE;
+
+    switch (type)
+    {
+    case PDJSON_ERROR:
+    case PDJSON_DONE:
+      return type;
+    case PDJSON_OBJECT:
+      if (h->object_begin != NULL)
+        r = h->object_begin (context);
+      break;
+    case PDJSON_OBJECT_END:
+      if (h->object_end != NULL)
+        r = h->object_end (context);
+      break;
+    case PDJSON_ARRAY:
+      if (h->array_begin != NULL)
+        r = h->array_begin (context);
+      break;
+    case PDJSON_ARRAY_END:
+      if (h->array_end != NULL)
+        r = h->array_end (context);
+      break;
+    case PDJSON_NAME:
+    case PDJSON_STRING:
+    case PDJSON_NUMBER:
+      {
+        enum pdjson_handler_result (*f) (const char *, size_t, void *) =
+          (type == PDJSON_NAME   ? h->name   :
+           type == PDJSON_STRING ? h->string :
+           h->number);
+
+        if (f != NULL)
+          r = f (json->data.string + json->data.string_start,
+                 json->data.string_fill - json->data.string_start,
+                 context);
+        break;
+      }
+    case PDJSON_TRUE:
+    case PDJSON_FALSE:
+    case PDJSON_NULL:
+      if (h->literal != NULL)
+        r = h->literal (type, context);
+      break;
+    }
+
+    if (r == PDJSON_HANDLER_STOP)
+      return type;
+
+    if (r == PDJSON_HANDLER_SKIP)
+    {
+      if (type == PDJSON_OBJECT || type == PDJSON_ARRAY)
+      {
+        // Skip until the end event of this object/array, that is, the end
+        // event that brings us to the outer level.
+        //
+        size_t top = json->stack_top;
+        for (enum pdjson_type t = (enum pdjson_type)0;
+             !((t == PDJSON_OBJECT_END || t == PDJSON_ARRAY_END) &&
+               json->stack_top + 1 == top); )
+        {
+          if ((t = next_event_counted (json, lang)) == PDJSON_ERROR)
+            return t;
+        }
+      }
+      else if (type == PDJSON_NAME)
+      {
+        if (pdjson_skip (json) == PDJSON_ERROR)
+          return PDJSON_ERROR;
+      }
+    }
+  }
+}
+
+static enum pdjson_type
+parse_callbacks_json (pdjson_stream *json,
+                      const pdjson_handler *h,
+                      void *context)
+{
+  return parse_callbacks (json, h, context, LANG_JSON);
+}
+
+static enum pdjson_type
+parse_callbacks_json5 (pdjson_stream *json,
+                       const pdjson_handler *h,
+                       void *context)
+{
+  return parse_callbacks (json, h, context, LANG_JSON5);
+}
+
+static enum pdjson_type
+parse_callbacks_json5e (pdjson_stream *json,
+                        const pdjson_handler *h,
+                        void *context)
+{
+  return parse_callbacks (json, h, context, LANG_JSON5E);
+}
+
+enum pdjson_type
+pdjson_parse_callbacks (pdjson_stream *json,
+                        const pdjson_handler *h,
+                        void *context)
+{
+  return lang_call (json->flags & LANG_MASK,
+                    parse_callbacks,
+                    json, h, context);
+}
+
+enum pdjson_type
+pdjson_skip (pdjson_stream *json)
+{
+  enum pdjson_type type = pdjson_next (json);
+  uint64_t cnt_arr = 0;
+  uint64_t cnt_obj = 0;
+
+  for (enum pdjson_type skip = type; ; skip = pdjson_next (json))
+  {
+    if (skip == PDJSON_ERROR || skip == PDJSON_DONE)
+      return skip;
+
+    if (skip == PDJSON_ARRAY)
+      ++cnt_arr;
+    else if (skip == PDJSON_ARRAY_END && cnt_arr > 0)
+      --cnt_arr;
+    else if (skip == PDJSON_OBJECT)
+      ++cnt_obj;
+    else if (skip == PDJSON_OBJECT_END && cnt_obj > 0)
+      --cnt_obj;
+
+    if (!cnt_arr && !cnt_obj)
+      break;
+  }
+
+  return type;
+}
+
+enum pdjson_type
+pdjson_skip_until (pdjson_stream *json, enum pdjson_type type)
+{
+  while (true)
+  {
+    enum pdjson_type skip = pdjson_skip (json);
+
+    if (skip == PDJSON_ERROR || skip == PDJSON_DONE)
+      return skip;
+
+    if (skip == type)
+      break;
+  }
+
+  return type;
+}
+
+bool
+pdjson_validate (pdjson_stream *json, uint64_t *error_pos)
+{
+  json->flags |= FLAG_VALIDATE;
+
+  // In the streaming mode the second PDJSON_DONE in a row is the end of
+  // input.
+  //
+  enum pdjson_type type;
+  for (bool first = true;;)
+  {
+    type = pdjson_next (json);
+
+    if (type == PDJSON_ERROR)
+      break;
+
+    if (type == PDJSON_DONE)
+    {
+      if (!(json->flags & FLAG_STREAMING) || first)
+        break;
+
+      pdjson_reset (json);
+      first = true;
+    }
+    else
+      first = false;
+  }
+
+  json->flags &= ~FLAG_VALIDATE;
+
+  if (type == PDJSON_ERROR)
+  {
+    if (error_pos != NULL)
+      *error_pos = pdjson_get_position (json);
+
+    return false;
+  }
+
+  return true;
+}
+
+// Given the consumed first byte of an array element, scan the buffer input
+// until the end of the element without parsing it. Only strings, comments,
+// and nesting are recognized which is sufficient to find the end of a valid
+// element. An invalid element is diagnosed when it is parsed (but note that
+// an unterminated string or container ends the element at the end of text).
+// Keep the line/column information up to date.
+//
+static void
+split_value (pdjson_stream *json, int c)
+{
+  const unsigned char *b =
+    (const unsigned char *)json->source.source.buffer.buffer;
+  size_t n = json->source.source.buffer.length;
+  size_t i = (size_t)json->source.position;
+
+  bool json5 = (json->flags & FLAG_JSON5) != 0;
+  bool json5e = (json->flags & FLAG_JSON5E) != 0;
+
+  // Note that for simplicity we don't distinguish between the object and
+  // array nesting.
+  //
+  size_t depth = 0;
+  for (;;)
+  {
+    if (c == '"' || (c == '\'' && json5))
+    {
+      // Skip until the closing quote, handling escapes (which includes the
+      // JSON5 line continuations).
+      //
+      for (int q = c; i != n; )
+      {
+        c = b[i++];
+
+        if (c == q)
+          break;
+
+        // Note that, as in read_escaped(), the line continuations
+        // (including CRLF) are not counted as newlines.
+        //
+        if (c == '\\' && i != n)
+        {
+          c = b[i++];
+
+          if (c == '\r' || c == '\n')
+          {
+            if (c == '\r' && i != n && b[i] == '\n')
+              i++;
+
+            continue;
+          }
+        }
+
+        if (c == '\n')
+        {
+          json->lineno++;
+          json->linepos = i;
+          json->lineadj = 0;
+        }
+        else if ((c & 0xC0) == 0x80)
+          json->lineadj++;
+      }
+    }
+    else if (c == '{' || c == '[')
+      depth++;
+    else if (c == '}' || c == ']')
+    {
+      if (depth != 0)
+        depth--;
+    }
+    else if ((c == '/' && json5 && i != n && (b[i] == '/' || b[i] == '*')) ||
+             (c == '#' && json5e))
+    {
+      if (c == '/')
+        c = b[i++];
+
+      if (c == '*')
+      {
+        for (; i != n; i++)
+        {
+          if (b[i] == '*' && i + 1 != n && b[i + 1] == '/')
+          {
+            i += 2;
+            break;
+          }
+
+          // Note that, similar to skip_comment(), UTF-8 continuation bytes
+          // in comments are not adjusted for.
+          //
+          if (b[i] == '\n')
+          {
+            json->lineno++;
+            json->linepos = i + 1;
+            json->lineadj = 0;
+          }
+        }
+      }
+      else
+      {
+        // Leave the newline to the code below.
+        //
+        while (i != n && b[i] != '\n' && b[i] != '\r')
+          i++;
+      }
+    }
+    else if (depth == 0)
+    {
+      // Scalar other than string: consume until something that cannot be
+      // part of a number or literal.
+      //
+      for (; i != n; i++)
+      {
+        c = b[i];
+        if (!((c >= 'a' && c <= 'z') ||
+              (c >= 'A' && c <= 'Z') ||
+              (c >= '0' && c <= '9') ||
+              c == '+' || c == '-' || c == '.' || c == '_' || c == '$'))
+          break;
+      }
+    }
+    else if (c == '\n')
+    {
+      json->lineno++;
+      json->linepos = i;
+      json->lineadj = 0;
+    }
+    else if ((c & 0xC0) == 0x80)
+      json->lineadj++;
+
+    if (depth == 0 || i == n)
+      break;
+
+    c = b[i++];
+  }
+
+  json->source.position = i;
+}
+
+size_t
+pdjson_split_array (pdjson_stream *json, pdjson_span *spans, size_t n)
+{
+  if (json->flags & FLAG_ERROR)
+    return 0;
+
+  if (json->source.tag != PDJSON_SOURCE_BUFFER ||
+      json->source.window.tag != 0)
+  {
+    json_error (json, "%s", "array splitting requires buffer input");
+    return 0;
+  }
+
+  int c;
+  if (json->ntokens == 0)
+  {
+    c = next (json, json->flags & LANG_MASK);
+    if (json->flags & FLAG_ERROR)
+      return 0;
+
+    if (c != '[')
+    {
+      json_error (json,
+                  "expected '[' instead of %s",
+                  diag_char (json, c));
+      return 0;
+    }
+
+    json->ntokens++;
+    if (push (json, PDJSON_ARRAY) == PDJSON_ERROR)
+      return 0;
+  }
+  else if (json->stack_top == (size_t)-1)
+    return 0;
+
+  // Note that the separator handling logic here must match pdjson_next().
+  //
+  size_t r = 0;
+  while (r != n)
+  {
+    c = next (json, json->flags & LANG_MASK);
+    if (json->flags & FLAG_ERROR)
+      break;
+
+    struct pdjson_stack *top = &json->stack[json->stack_top];
+
+    bool end = false;
+    if (top->count == 0)
+      end = (c == ']');
+    else if (c == ',')
+    {
+      c = next (json, json->flags & LANG_MASK);
+      if (json->flags & FLAG_ERROR)
+        break;
+
+      end = ((json->flags & FLAG_JSON5) && c == ']');
+    }
+    else if (json->flags & FLAG_JSON5E  &&
+             json->flags & FLAG_NEWLINE &&
+             c != ']')
+      ;
+    else if (c == ']')
+      end = true;
+    else
+    {
+      json_error (json,
+                  "%s",
+                  ((json->flags & FLAG_JSON5E)
+                   ? "expected ']', newline, or ',' after array value"
+                   : "expected ',' or ']' after array value"));
+      break;
+    }
+
+    if (end)
+    {
+      pop (json, PDJSON_ARRAY_END);
+      break;
+    }
+
+    if (c == EOF)
+    {
+      json_error (json, "%s", "unexpected end of text");
+      break;
+    }
+
+    pdjson_span *sp = spans + r++;
+
+    sp->position = pdjson_get_position (json) - 1;
+    sp->line = json->lineno;
+    sp->column = pdjson_get_column (json);
+
+    split_value (json, c);
+
+    sp->size = (size_t)(pdjson_get_position (json) - sp->position);
+
+    json->ntokens++;
+    top->count++;
+  }
+
+  return r;
+}
+
+enum pdjson_error_subtype
+pdjson_get_error_subtype (const pdjson_stream *json)
+{
+  return (enum pdjson_error_subtype)json->subtype;
+}
+
+const char *
+pdjson_get_name (const pdjson_stream *json, size_t *size)
+{
+  return pdjson_get_value (json, size);
+}
+
+// Member name dictionary.
+//
 
-        return type;
-      }
-      else if (c == EOF)
-      {
-        // Allow empty implied objects (for example, all members commented
-        // out).
-        //
-        json->pending.type = PDJSON_OBJECT_END;
-        json->pending.subtype = 0;
-        json->pending.lineno = 0;
-        json->pending.colno = 0;
+struct pdjson_name
+{
+  size_t offset; // In the pool.
+  size_t size;   // Excluding the trailing `\0`.
+  uint64_t hash;
+};
 
-        json->flags |= FLAG_IMPLIED_END;
+static uint64_t
+name_hash (const char *v, size_t n)
+{
+  return fnv1a (FNV1A_BASIS, v, n);
+}
 
-        json->start_lineno = 1;
-        json->start_colno = 1;
+static void
+names_free (pdjson_stream *json)
+{
+  array_release (&json->alloc, json->alloc_data,
+                 json->names.entries,
+                 json->names.capacity,
+                 sizeof (struct pdjson_name));
+  array_release (&json->alloc, json->alloc_data,
+                 json->names.pool,
+                 json->names.pool_capacity,
+                 1);
+  array_release (&json->alloc, json->alloc_data,
+                 json->names.table,
+                 json->names.table_size,
+                 sizeof (size_t));
+
+  memset (&json->names, 0, sizeof (json->names));
+}
 
-        // Note that we need to push an object entry into the stack to make
-        // sure pdjson_get_context() works correctly.
-        //
-        json->ntokens++; // For `{`.
-        return push (json, PDJSON_OBJECT);
-      }
-      // Else fall through.
-    }
+static size_t
+names_find (const pdjson_stream *json, const char *v, size_t n, uint64_t h)
+{
+  if (json->names.table_size == 0)
+    return PDJSON_NAME_UNKNOWN;
+
+  size_t m = json->names.table_size - 1;
+  for (size_t i = (size_t)h & m;; i = (i + 1) & m)
+  {
+    size_t id = json->names.table[i];
+
+    if (id == PDJSON_NAME_UNKNOWN)
+      return id;
 
-    return read_value (json, c);
+    const struct pdjson_name *e = json->names.entries + id;
+    if (e->hash == h &&
+        e->size == n &&
+        memcmp (json->names.pool + e->offset, v, n) == 0)
+      return id;
   }
 }
 
-enum pdjson_type
-pdjson_skip (pdjson_stream *json)
+static void
+names_insert (pdjson_stream *json, size_t id)
 {
-  enum pdjson_type type = pdjson_next (json);
-  uint64_t cnt_arr = 0;
-  uint64_t cnt_obj = 0;
+  size_t m = json->names.table_size - 1;
+  size_t i = (size_t)json->names.entries[id].hash & m;
 
-  for (enum pdjson_type skip = type; ; skip = pdjson_next (json))
+  while (json->names.table[i] != PDJSON_NAME_UNKNOWN)
+    i = (i + 1) & m;
+
+  json->names.table[i] = id;
+}
+
+// Add the name and, if requested, insert it into the hash table. Return its
+// ID or PDJSON_NAME_UNKNOWN if out of memory.
+//
+static size_t
+names_add (pdjson_stream *json,
+           const char *v,
+           size_t n,
+           uint64_t h,
+           bool insert)
+{
+  // Keep the hash table load factor at or below 1/2.
+  //
+  size_t ts = json->names.table_size;
+  if ((json->names.size + 1) * 2 > ts)
   {
-    if (skip == PDJSON_ERROR || skip == PDJSON_DONE)
-      return skip;
+    size_t nts = ts == 0 ? 32 : ts * 2;
 
-    if (skip == PDJSON_ARRAY)
-      ++cnt_arr;
-    else if (skip == PDJSON_ARRAY_END && cnt_arr > 0)
-      --cnt_arr;
-    else if (skip == PDJSON_OBJECT)
-      ++cnt_obj;
-    else if (skip == PDJSON_OBJECT_END && cnt_obj > 0)
-      --cnt_obj;
+    if (nts > SIZE_MAX / sizeof (size_t))
+      return PDJSON_NAME_UNKNOWN;
 
-    if (!cnt_arr && !cnt_obj)
-      break;
+    size_t *t = (size_t *)array_allocate (&json->alloc,
+                                          json->alloc_data,
+                                          nts * sizeof (size_t)); // THROW
+
+    if (t == NULL)
+      return PDJSON_NAME_UNKNOWN;
+
+    for (size_t i = 0; i != nts; ++i)
+      t[i] = PDJSON_NAME_UNKNOWN;
+
+    // Re-insert only the names that are in the old table (that is, skipping
+    // duplicates).
+    //
+    size_t *ot = json->names.table;
+    json->names.table = t;
+    json->names.table_size = nts;
+
+    for (size_t i = 0; i != ts; ++i)
+    {
+      if (ot[i] != PDJSON_NAME_UNKNOWN)
+        names_insert (json, ot[i]);
+    }
+
+    array_release (&json->alloc, json->alloc_data, ot, ts, sizeof (size_t));
   }
 
-  return type;
+  if (!array_grow (&json->alloc, json->alloc_data,
+                   (void **)&json->names.entries,
+                   &json->names.capacity,
+                   json->names.size,
+                   1,
+                   sizeof (struct pdjson_name)) ||
+      !array_grow (&json->alloc, json->alloc_data,
+                   (void **)&json->names.pool,
+                   &json->names.pool_capacity,
+                   json->names.pool_size,
+                   n + 1,
+                   1))
+    return PDJSON_NAME_UNKNOWN;
+
+  size_t id = json->names.size++;
+  struct pdjson_name *e = json->names.entries + id;
+
+  e->offset = json->names.pool_size;
+  e->size = n;
+  e->hash = h;
+
+  memcpy (json->names.pool + e->offset, v, n);
+  json->names.pool[e->offset + n] = '\0';
+  json->names.pool_size += n + 1;
+
+  if (insert)
+    names_insert (json, id);
+
+  return id;
 }
 
-enum pdjson_type
-pdjson_skip_until (pdjson_stream *json, enum pdjson_type type)
+void
+pdjson_set_names (pdjson_stream *json,
+                  const char *const *names,
+                  size_t count,
+                  size_t intern)
 {
-  while (true)
+  names_free (json);
+
+  for (size_t i = 0; i != count; ++i)
   {
-    enum pdjson_type skip = pdjson_skip (json);
+    const char *v = names[i];
+    size_t n = strlen (v);
+    uint64_t h = name_hash (v, n);
 
-    if (skip == PDJSON_ERROR || skip == PDJSON_DONE)
-      return skip;
+    // Note that a duplicate still gets its ID but is not inserted into the
+    // hash table.
+    //
+    bool dup = names_find (json, v, n, h) != PDJSON_NAME_UNKNOWN;
 
-    if (skip == type)
-      break;
+    if (names_add (json, v, n, h, !dup) == PDJSON_NAME_UNKNOWN)
+    {
+      names_free (json);
+      mem_error (json, "out of memory");
+      return;
+    }
   }
 
-  return type;
+  json->names.known = count;
+  json->names.intern = intern;
 }
 
-enum pdjson_error_subtype
-pdjson_get_error_subtype (const pdjson_stream *json)
+size_t
+pdjson_get_name_id (pdjson_stream *json)
 {
-  return (enum pdjson_error_subtype)json->subtype;
+  size_t n = json->data.string_fill - json->data.string_start;
+  const char *v = json->data.string + json->data.string_start;
+
+  if (json->data.string == NULL || n == 0)
+  {
+    v = "";
+    n = 1;
+  }
+
+  n--; // Trailing `\0`.
+
+  uint64_t h = name_hash (v, n);
+  size_t id = names_find (json, v, n, h);
+
+  // Intern the unknown name if enabled and there is room (if out of memory,
+  // then the name stays unknown).
+  //
+  if (id == PDJSON_NAME_UNKNOWN &&
+      json->names.size - json->names.known < json->names.intern)
+    id = names_add (json, v, n, h, true);
+
+  return id;
 }
 
 const char *
-pdjson_get_name (const pdjson_stream *json, size_t *size)
+pdjson_get_name_by_id (const pdjson_stream *json, size_t id, size_t *size)
 {
-  return pdjson_get_value (json, size);
+  if (id >= json->names.size)
+    return NULL;
+
+  const struct pdjson_name *e = json->names.entries + id;
+
+  if (size != NULL)
+    *size = e->size + 1;
+
+  return json->names.pool + e->offset;
 }
 
 const char *
 pdjson_get_value (const pdjson_stream *json, size_t *size)
 {
   if (size != NULL)
-    *size = json->data.string_fill;
+    *size = json->data.string_fill - json->data.string_start;
 
   if (json->data.string == NULL)
     return "";
   else
-    return json->data.string;
+    return json->data.string + json->data.string_start;
 }
 
 const char *
@@ -2274,6 +3919,23 @@ pdjson_get_error (const pdjson_stream *json)
   return json->flags & FLAG_ERROR ? json->error_message : NULL;
 }
 
+bool
+pdjson_get_stats (const pdjson_stream *json, pdjson_stats *stats)
+{
+#ifdef LIBPDJSON5_STATS
+  // While parsing, the bytes counter holds the starting position (see
+  // pdjson_set_location()).
+  //
+  *stats = json->stats;
+  stats->bytes = pdjson_get_position (json) - json->stats.bytes;
+  return true;
+#else
+  (void)json;
+  memset (stats, 0, sizeof (*stats));
+  return false;
+#endif
+}
+
 uint64_t
 pdjson_get_line (const pdjson_stream *json)
 {
@@ -2284,7 +3946,7 @@ uint64_t
 pdjson_get_column (const pdjson_stream *json)
 {
   return json->start_colno == 0
-    ? (json->source.position == 0
+    ? (json->source.position + json->posoff == 0 && json->linepos == 0
        ? 1
        : json->source.position - json->linepos - json->lineadj)
     : json->start_colno;
@@ -2293,7 +3955,7 @@ pdjson_get_column (const pdjson_stream *json)
 uint64_t
 pdjson_get_position (const pdjson_stream *json)
 {
-  return json->source.position;
+  return json->source.position + json->posoff;
 }
 
 size_t
@@ -2369,7 +4031,7 @@ pdjson_reset (pdjson_stream *json)
   json->start_lineno = 0;
   json->start_colno = 0;
 
-  json->flags &= ~(FLAG_ERROR | FLAG_IMPLIED_END);
+  json->flags &= ~(FLAG_ERROR | FLAG_ERROR_NEWLINE | FLAG_IMPLIED_END);
   json->ntokens = 0;
   json->subtype = 0;
   json->peek = (enum pdjson_type)0;
@@ -2377,10 +4039,110 @@ pdjson_reset (pdjson_stream *json)
 
   json->stack_top = (size_t)-1;
   json->data.string_fill = 0;
+  json->data.string_start = 0;
 
   json->error_message[0] = '\0';
 }
 
+bool
+pdjson_recover (pdjson_stream *json, enum pdjson_recover_policy policy)
+{
+  if (!(json->flags & FLAG_ERROR) || json->subtype != PDJSON_ERROR_SYNTAX)
+    return false;
+
+  // Clear the error flag so that we can detect an io error while skipping.
+  //
+  json->flags &= ~FLAG_ERROR;
+
+  bool r;
+  if (policy == PDJSON_RECOVER_FRAME && json->framing != PDJSON_FRAMING_LINE)
+  {
+    switch (json->framing)
+    {
+    case PDJSON_FRAMING_RS:
+      r = skip_until (json, '\x1E');
+      break;
+    case PDJSON_FRAMING_LENGTH:
+      r = (json->flags & FLAG_FRAME) && skip_length_frame (json);
+      break;
+    default:
+      r = false;
+    }
+  }
+  else
+  {
+    // Skip until after the newline unless the error was caused by one, in
+    // which case it is already consumed but not yet accounted for.
+    //
+    if (json->flags & FLAG_ERROR_NEWLINE)
+    {
+      newline (json);
+      r = true;
+    }
+    else
+      r = skip_until (json, '\n');
+  }
+
+  if (!r)
+  {
+    json->flags |= FLAG_ERROR; // Restore or io error.
+    return false;
+  }
+
+  if (json->flags & FLAG_FRAME)
+  {
+    json->flags &= ~FLAG_FRAME;
+    source_unlimit (json);
+  }
+
+  pdjson_reset (json);
+  return true;
+}
+
+int
+pdjson_skip_frame (pdjson_stream *json)
+{
+  if (json->flags & FLAG_ERROR)
+    return -1;
+
+  bool r;
+  switch (json->framing)
+  {
+  case PDJSON_FRAMING_RS:
+  case PDJSON_FRAMING_LINE:
+    {
+      if (begin_frame (json) == EOF)
+        return json->flags & FLAG_ERROR ? -1 : 0;
+
+      r = skip_until (json,
+                      json->framing == PDJSON_FRAMING_RS ? '\x1E' : '\n');
+      break;
+    }
+  case PDJSON_FRAMING_LENGTH:
+    {
+      int c = next (json, json->flags & LANG_MASK);
+
+      if (c == EOF)
+        return json->flags & FLAG_ERROR ? -1 : 0;
+
+      r = begin_length_frame (json, c) && skip_length_frame (json);
+      break;
+    }
+  default:
+    {
+      json_error (json, "%s", "framing mode is not set");
+      return -1;
+    }
+  }
+
+  if (!r)
+    return -1;
+
+  json->flags &= ~FLAG_FRAME;
+  source_unlimit (json);
+  return 1;
+}
+
 static void
 init (pdjson_stream *json, bool reinit)
 {
@@ -2388,14 +4150,29 @@ init (pdjson_stream *json, bool reinit)
   json->linepos = 0;
   json->lineadj = 0;
   json->linecon = 0;
+  json->posoff = 0;
   json->start_lineno = 0;
   json->start_colno = 0;
   json->source.position = 0;
+  json->source.hidden = 0;
+  json->frame_end = UINT64_MAX;
+  json->frame_line = 0;
+
+  if (!reinit)
+  {
+    json->framing = PDJSON_FRAMING_NONE;
+    json->prefilter = NULL;
+    json->prefilter_size = 0;
+    memset (&json->names, 0, sizeof (json->names));
+  }
 
-  json->flags &= reinit ? ~(FLAG_ERROR | FLAG_IMPLIED_END) : 0;
+  json->flags &= reinit
+    ? ~(FLAG_ERROR | FLAG_ERROR_NEWLINE | FLAG_FRAME | FLAG_IMPLIED_END)
+    : 0;
   json->ntokens = 0;
   json->subtype = 0;
   json->peek = (enum pdjson_type)0;
+  memset (&json->stats, 0, sizeof (json->stats));
   json->pending.type = (enum pdjson_type)0;
 
   json->error_message[0] = '\0';
@@ -2408,12 +4185,20 @@ init (pdjson_stream *json, bool reinit)
   }
 
   json->data.string_fill = 0;
+  json->data.string_start = 0;
   if (!reinit)
   {
     json->data.string = NULL;
     json->data.string_size = 0;
   }
 
+  json->source.window.tag = (enum pdjson_source_tag)0;
+  if (!reinit)
+  {
+    json->source.window.data = NULL;
+    json->source.window.size = 0;
+  }
+
   if (!reinit)
   {
     json->alloc.malloc = NULL;
@@ -2421,6 +4206,34 @@ init (pdjson_stream *json, bool reinit)
     json->alloc.free = NULL;
     json->alloc_data = NULL;
   }
+
+  trace2 (open, json, (int)reinit);
+}
+
+// Switch the stream or user input to the read-ahead window, if enabled.
+//
+static void
+init_window (pdjson_stream *json)
+{
+  struct pdjson_source *source = &json->source;
+
+  if (source->window.size == 0 ||
+      (source->tag != PDJSON_SOURCE_STREAM &&
+       source->tag != PDJSON_SOURCE_USER))
+    return;
+
+  // Rebase the position-dependent state on the (empty) window (see
+  // source_refill() for details).
+  //
+  uint64_t n = source->position;
+  json->posoff += n;
+  json->linepos -= n;
+
+  source->position = 0;
+  source->window.tag = source->tag;
+  source->tag = PDJSON_SOURCE_BUFFER;
+  source->source.buffer.buffer = source->window.data;
+  source->source.buffer.length = 0;
 }
 
 void
@@ -2473,6 +4286,7 @@ pdjson_open_stream (pdjson_stream *json, FILE *stream)
   init (json, false);
   json->source.tag = PDJSON_SOURCE_STREAM;
   json->source.source.stream.stream = stream;
+  init_window (json);
 }
 
 void
@@ -2481,6 +4295,7 @@ pdjson_reopen_stream (pdjson_stream *json, FILE *stream)
   init (json, true);
   json->source.tag = PDJSON_SOURCE_STREAM;
   json->source.source.stream.stream = stream;
+  init_window (json);
 }
 
 void
@@ -2490,6 +4305,7 @@ pdjson_open_user (pdjson_stream *json, const pdjson_user_io *io, void *data)
   json->source.tag = PDJSON_SOURCE_USER;
   json->source.source.user.data = data;
   json->source.source.user.io = *io;
+  init_window (json);
 }
 
 void
@@ -2499,6 +4315,7 @@ pdjson_reopen_user (pdjson_stream *json, const pdjson_user_io *io, void *data)
   json->source.tag = PDJSON_SOURCE_USER;
   json->source.source.user.data = data;
   json->source.source.user.io = *io;
+  init_window (json);
 }
 
 void
@@ -2523,6 +4340,73 @@ pdjson_set_streaming (pdjson_stream *json, bool mode)
     json->flags &= ~FLAG_STREAMING;
 }
 
+void
+pdjson_set_framing (pdjson_stream *json, enum pdjson_framing framing)
+{
+  json->framing = framing;
+
+  if (framing != PDJSON_FRAMING_NONE)
+    json->flags |= FLAG_STREAMING;
+}
+
+void
+pdjson_set_prefilter (pdjson_stream *json,
+                      const char *const *patterns,
+                      size_t count)
+{
+  json->prefilter = count != 0 ? patterns : NULL;
+  json->prefilter_size = count;
+}
+
+void
+pdjson_set_read_ahead (pdjson_stream *json, size_t size)
+{
+  struct pdjson_source *source = &json->source;
+
+  if (size == source->window.size)
+    return;
+
+  // Switch back to the underlying input, if necessary.
+  //
+  if (source->window.tag != 0)
+  {
+    source->tag = source->window.tag;
+    source->window.tag = (enum pdjson_source_tag)0;
+  }
+
+  if (source->window.data != NULL)
+  {
+    if (json->alloc.malloc == NULL)
+      free (source->window.data);
+    else
+      json->alloc.free (source->window.data,
+                        source->window.size,
+                        json->alloc_data);
+
+    source->window.data = NULL;
+    source->window.size = 0;
+  }
+
+  if (size != 0)
+  {
+    char *data = (char *)
+      (json->alloc.malloc == NULL
+       ? malloc (size)
+       : json->alloc.malloc (size, json->alloc_data)); // THROW
+
+    if (data == NULL)
+    {
+      mem_error (json, "out of memory");
+      return;
+    }
+
+    source->window.data = data;
+    source->window.size = size;
+
+    init_window (json);
+  }
+}
+
 void
 pdjson_set_language (pdjson_stream *json, enum pdjson_language language)
 {
@@ -2541,13 +4425,77 @@ pdjson_set_language (pdjson_stream *json, enum pdjson_language language)
   }
 }
 
+void
+pdjson_set_location (pdjson_stream *json,
+                     uint64_t position,
+                     uint64_t line,
+                     uint64_t column)
+{
+  // Note that the unsigned arithmetic below is well-defined even if it
+  // wraps around (and cancels out in pdjson_get_column/position()).
+  //
+  stats_add (json, bytes, position - pdjson_get_position (json));
+
+  json->posoff = position - json->source.position;
+  json->lineno = line;
+  json->linepos = json->source.position - (column - 1);
+  json->lineadj = 0;
+  json->linecon = 0;
+}
+
+bool
+pdjson_checkpoint (const pdjson_stream *json, struct pdjson_checkpoint *cp)
+{
+  // Note that in the length framing mode the frame is only ended when the
+  // PDJSON_DONE event is returned.
+  //
+  if (!(json->flags & FLAG_STREAMING)           ||
+      (json->flags & (FLAG_ERROR | FLAG_FRAME)) ||
+      json->stack_top != (size_t)-1             ||
+      json->peek != 0                           ||
+      json->pending.type != 0                   ||
+      json->linecon != 0)
+    return false;
+
+  cp->position = json->source.position + json->posoff;
+  cp->line = json->lineno;
+  cp->column = json->source.position - json->linepos - json->lineadj + 1;
+  cp->language = (uint32_t)
+    (json->flags & FLAG_JSON5E ? PDJSON_LANGUAGE_JSON5E :
+     json->flags & FLAG_JSON5  ? PDJSON_LANGUAGE_JSON5  :
+     PDJSON_LANGUAGE_JSON);
+  cp->framing = (uint32_t)json->framing;
+
+  return true;
+}
+
+bool
+pdjson_resume (pdjson_stream *json, const struct pdjson_checkpoint *cp)
+{
+  if (cp->line == 0                         ||
+      cp->column == 0                       ||
+      cp->language > PDJSON_LANGUAGE_JSON5E ||
+      cp->framing > PDJSON_FRAMING_LENGTH)
+    return false;
+
+  pdjson_set_location (json, cp->position, cp->line, cp->column);
+  pdjson_set_language (json, (enum pdjson_language)cp->language);
+  pdjson_set_streaming (json, true);
+  pdjson_set_framing (json, (enum pdjson_framing)cp->framing);
+
+  return true;
+}
+
 void
 pdjson_close (pdjson_stream *json)
 {
+  trace2 (close, json, pdjson_get_position (json));
+
   if (json->alloc.malloc == NULL)
   {
     free (json->stack);
     free (json->data.string);
+    free (json->source.window.data);
   }
   else
   {
@@ -2557,5 +4505,10 @@ pdjson_close (pdjson_stream *json)
     json->alloc.free (json->data.string,
                       json->data.string_size,
                       json->alloc_data);
+    json->alloc.free (json->source.window.data,
+                      json->source.window.size,
+                      json->alloc_data);
   }
+
+  names_free (json);
 }
@@ -71,11 +71,20 @@ struct pdjson_allocator
 // the subsequent get() will return an error as well. Finally, we assume we
 // can call failed peek() again with consistent results.
 //
+// The optional read() function is only used in the read-ahead mode (see
+// pdjson_set_read_ahead()). It is expected to read up to the specified
+// number of bytes into the buffer and return the number of bytes read,
+// returning 0 on EOF or error (again, the fread() model). If it is NULL,
+// then get() is used to fill the buffer. Note that this member was added
+// after the initial three and so code that assigns the members one by one
+// should be updated to also set read (to NULL if not provided).
+//
 struct pdjson_user_io
 {
   int (*peek) (void *user_data);
   int (*get) (void *user_data);
   bool (*error) (void *user_data);
+  size_t (*read) (void *buffer, size_t size, void *user_data);
 };
 
 typedef struct pdjson_stream pdjson_stream;
@@ -139,6 +148,88 @@ pdjson_set_allocator (pdjson_stream *json,
 LIBPDJSON5_SYMEXPORT void
 pdjson_set_streaming (pdjson_stream *json, bool mode);
 
+// Framing of values in the streaming mode.
+//
+// In the RS mode each value is preceded by the record separator character
+// (0x1E) and followed by a newline (RFC 7464 JSON text sequences). Empty
+// records are ignored.
+//
+// In the line mode each value must be on its own line. Empty lines are
+// ignored.
+//
+// In the length mode each value is preceded by its length in bytes, as a
+// decimal number followed by a newline. The value must occupy the entire
+// frame (except for leading and trailing whitespaces) and is not read past
+// its end.
+//
+enum pdjson_framing
+{
+  PDJSON_FRAMING_NONE,   // Whitespace-separated values (default).
+  PDJSON_FRAMING_RS,     // Record separator-prefixed values.
+  PDJSON_FRAMING_LINE,   // Newline-delimited values.
+  PDJSON_FRAMING_LENGTH  // Length-prefixed values.
+};
+
+// Set the framing mode. Setting a mode other than none also enables the
+// streaming mode. Violations of the framing are reported as syntax errors.
+// The framing setting is preserved when reopening the parser.
+//
+LIBPDJSON5_SYMEXPORT void
+pdjson_set_framing (pdjson_stream *json, enum pdjson_framing framing);
+
+// Skip the next frame without parsing its contents. Should be called
+// instead of pdjson_next() at the beginning of a value (that is, after
+// opening or resetting the parser). Return 1 if a frame was skipped, 0 if
+// there are no more frames, and -1 if there was an error (which can be
+// queried as usual).
+//
+// In the length mode this is done without examining the frame contents
+// other than to count newlines. In the other modes, the frame is skipped
+// until the next record separator or newline.
+//
+LIBPDJSON5_SYMEXPORT int
+pdjson_skip_frame (pdjson_stream *json);
+
+// Set the raw byte prefilter for the line framing mode: a line that does not
+// contain all the specified patterns (for example, a member name including
+// its quotes) is skipped without being parsed. Note that a line that passes
+// the prefilter is not guaranteed to contain the patterns as a name or value
+// (or at all, see below) and should still be checked by the caller. Setting
+// the prefilter with zero patterns disables it.
+//
+// The pattern strings are not copied and should remain valid while the
+// prefilter is in effect. The prefilter setting is preserved when reopening
+// the parser.
+//
+// The prefilter is only applied to lines that are entirely available in the
+// buffer input or the read-ahead window (see pdjson_set_read_ahead()) with
+// the rest passed through to the parser.
+//
+LIBPDJSON5_SYMEXPORT void
+pdjson_set_prefilter (pdjson_stream *json,
+                      const char *const *patterns,
+                      size_t count);
+
+// Enable reading the stream or user input ahead in blocks of the specified
+// size (0 disables this mode). In this mode the input is consumed from the
+// block at the same speed as the buffer input and the number of calls to
+// the underlying stream or user io functions is reduced to one per block (if
+// the user read() function is provided). The user read() function can also
+// be used to overlap reading and parsing, for example, by returning blocks
+// that were prefetched by a separate thread.
+//
+// Note that in this mode the input may be read past the end of the parsed
+// text (which matters, for example, in the streaming mode if the rest of the
+// input is read by other means). Note also that io errors are still reported
+// at the position where the data became unavailable.
+//
+// The read-ahead setting should be specified after opening the parser and
+// before performing any parsing. It is preserved when reopening the parser
+// and only has effect on the stream and user inputs.
+//
+LIBPDJSON5_SYMEXPORT void
+pdjson_set_read_ahead (pdjson_stream *json, size_t size);
+
 enum pdjson_language
 {
   PDJSON_LANGUAGE_JSON,   // Strict JSON.
@@ -149,6 +240,61 @@ enum pdjson_language
 LIBPDJSON5_SYMEXPORT void
 pdjson_set_language (pdjson_stream *json, enum pdjson_language language);
 
+// Set the location of the next input byte: its position, line, and column.
+// This is primarily useful for parsing a fragment of a larger input (for
+// example, an element returned by pdjson_split_array() below) while
+// reporting the same locations as would parsing the entire input. Note that
+// this function should be called after opening the parser and before
+// performing any parsing.
+//
+LIBPDJSON5_SYMEXPORT void
+pdjson_set_location (pdjson_stream *json,
+                     uint64_t position,
+                     uint64_t line,
+                     uint64_t column);
+
+// Parser state checkpoint in the streaming mode.
+//
+// A checkpoint captures everything necessary to continue parsing the input
+// from the beginning of the next value: the location of the next input byte
+// as well as the language and framing settings. It only contains fixed-size
+// integers and can be saved and restored as is, for example, by a process
+// that follows an append-only file and needs to continue where it left off
+// after a restart without re-reading the input from the beginning.
+//
+struct pdjson_checkpoint
+{
+  uint64_t position; // Position of the next input byte.
+  uint64_t line;     // Line of the next input byte.
+  uint64_t column;   // Column of the next input byte.
+  uint32_t language; // enum pdjson_language
+  uint32_t framing;  // enum pdjson_framing
+};
+
+// Save the parser state between top-level values in the streaming mode,
+// that is, before parsing the first value or after the PDJSON_DONE event,
+// including the second one that indicates the end of the input (so that
+// parsing can be resumed once more input becomes available). Return false
+// if the parser is not in such a state (for example, in the middle of a
+// value, after an error, not in the streaming mode, etc).
+//
+// Note that any whitespaces that follow the value are left unconsumed and,
+// in the length framing mode, the trailing whitespaces in the frame are
+// consumed.
+//
+LIBPDJSON5_SYMEXPORT bool
+pdjson_checkpoint (const pdjson_stream *json, struct pdjson_checkpoint *cp);
+
+// Restore the parser state from the checkpoint, enabling the streaming mode.
+// The input should be positioned at the checkpoint position (for example,
+// with fseek()). Like pdjson_set_location(), this function should be called
+// after opening the parser and before performing any parsing. Return false
+// if the checkpoint is invalid, in which case the parser state is left
+// unchanged.
+//
+LIBPDJSON5_SYMEXPORT bool
+pdjson_resume (pdjson_stream *json, const struct pdjson_checkpoint *cp);
+
 LIBPDJSON5_SYMEXPORT enum pdjson_type
 pdjson_next (pdjson_stream *json);
 
@@ -163,6 +309,34 @@ pdjson_peek (pdjson_stream *json);
 LIBPDJSON5_SYMEXPORT void
 pdjson_reset (pdjson_stream *json);
 
+// Error recovery policy for pdjson_recover().
+//
+enum pdjson_recover_policy
+{
+  PDJSON_RECOVER_NEWLINE, // Skip the rest of the line containing the error.
+  PDJSON_RECOVER_FRAME    // Skip the rest of the frame (see framing below).
+};
+
+// Recover from a syntax error by skipping the rest of the erroneous value
+// according to the policy and resetting the parser (see pdjson_reset()) so
+// that parsing can continue, normally in the streaming mode. The line,
+// column, and position information remains accurate. Return false if there
+// is no syntax error to recover from (no error, io or memory error) or if an
+// io error occurred while skipping.
+//
+// With the frame policy, the rest of the current frame is skipped (see
+// pdjson_skip_frame() for details). In the length mode, an error in the
+// frame length itself is not recoverable.
+//
+// With the newline policy, if the error was caused by a newline (for
+// example, an unterminated value at the end of the line), then the next line
+// is not skipped. Note also that if the error in the value is only detected
+// on one of the subsequent lines (for example, because of a missing closing
+// bracket), then the rest of that line is skipped.
+//
+LIBPDJSON5_SYMEXPORT bool
+pdjson_recover (pdjson_stream *json, enum pdjson_recover_policy policy);
+
 // Get subtype for certain events.
 //
 LIBPDJSON5_SYMEXPORT enum pdjson_error_subtype
@@ -175,6 +349,41 @@ pdjson_get_error_subtype (const pdjson_stream *json);
 LIBPDJSON5_SYMEXPORT const char *
 pdjson_get_name (const pdjson_stream *json, size_t *size);
 
+// Member name dictionary.
+//
+// Register the expected member names so that after the PDJSON_NAME event
+// pdjson_get_name_id() can be used to map the name to its index in the
+// names array instead of comparing it to each expected name. If the name
+// is not in the dictionary, then PDJSON_NAME_UNKNOWN is returned unless
+// interning of unknown names is enabled, in which case such names are
+// assigned IDs starting from count in the order of appearance, up to the
+// specified maximum number of interned names. The interned IDs are stable
+// while the dictionary is in effect (including across values in the
+// streaming mode) and their names can be obtained with
+// pdjson_get_name_by_id().
+//
+// The names are copied and, if there are duplicates, the first one is used.
+// Setting the dictionary with zero names and zero interned names disables
+// it. The dictionary is preserved when reopening the parser. On failure to
+// allocate memory the memory error is reported as usual.
+//
+#define PDJSON_NAME_UNKNOWN ((size_t)-1)
+
+LIBPDJSON5_SYMEXPORT void
+pdjson_set_names (pdjson_stream *json,
+                  const char *const *names,
+                  size_t count,
+                  size_t intern);
+
+LIBPDJSON5_SYMEXPORT size_t
+pdjson_get_name_id (pdjson_stream *json);
+
+// Return the name with the specified ID or NULL if there is no such ID. The
+// returned size counts the trailing `\0`.
+//
+LIBPDJSON5_SYMEXPORT const char *
+pdjson_get_name_by_id (const pdjson_stream *json, size_t id, size_t *size);
+
 // Return the string or number value after the PDJSON_STRING or PDJSON_NUMBER
 // events.
 //
@@ -183,6 +392,96 @@ pdjson_get_name (const pdjson_stream *json, size_t *size);
 LIBPDJSON5_SYMEXPORT const char *
 pdjson_get_value (const pdjson_stream *json, size_t *size);
 
+// Parsing event as returned by pdjson_next_batch().
+//
+struct pdjson_event
+{
+  enum pdjson_type type;
+  size_t depth;  // As returned by pdjson_get_depth().
+  size_t offset; // Name/value offset in pdjson_get_batch_data().
+  size_t size;   // Name/value size (counts the trailing `\0`) or 0.
+};
+
+typedef struct pdjson_event pdjson_event;
+
+// Parse up to n next events storing them in the events array and return the
+// number of events stored. The batch ends early after the PDJSON_DONE or
+// PDJSON_ERROR event. This is equivalent to calling pdjson_next() and then
+// pdjson_get_depth() and pdjson_get_name/value() for each event but with
+// less per-event overhead.
+//
+// The names and values of all the events in the batch are accumulated in
+// the data buffer returned by pdjson_get_batch_data() which remains valid
+// until the next call to pdjson_next_batch(), pdjson_next/peek(), or
+// pdjson_reset(). The accessor functions (pdjson_get_value(),
+// pdjson_get_line(), pdjson_get_error(), etc) return information about the
+// last event in the batch.
+//
+LIBPDJSON5_SYMEXPORT size_t
+pdjson_next_batch (pdjson_stream *json, pdjson_event *events, size_t n);
+
+LIBPDJSON5_SYMEXPORT const char *
+pdjson_get_batch_data (const pdjson_stream *json);
+
+// Handler result for pdjson_parse_callbacks().
+//
+enum pdjson_handler_result
+{
+  PDJSON_HANDLER_CONTINUE,
+  PDJSON_HANDLER_STOP, // Stop parsing.
+  PDJSON_HANDLER_SKIP  // Skip array/object or member value (see below).
+};
+
+// Parsing event handlers for pdjson_parse_callbacks(). Any handler can be
+// NULL in which case the corresponding events are ignored. The name and
+// value sizes count the trailing `\0` (as in pdjson_get_name/value()).
+//
+// Returning PDJSON_HANDLER_SKIP from the object_begin/array_begin handler
+// skips the object/array contents, including its end event. Returning it
+// from the name handler skips the member value. In other handlers it has
+// the same effect as PDJSON_HANDLER_CONTINUE.
+//
+struct pdjson_handler
+{
+  enum pdjson_handler_result (*object_begin) (void *context);
+  enum pdjson_handler_result (*object_end) (void *context);
+  enum pdjson_handler_result (*array_begin) (void *context);
+  enum pdjson_handler_result (*array_end) (void *context);
+
+  enum pdjson_handler_result (*name) (const char *name,
+                                      size_t size,
+                                      void *context);
+
+  enum pdjson_handler_result (*string) (const char *value,
+                                        size_t size,
+                                        void *context);
+
+  enum pdjson_handler_result (*number) (const char *value,
+                                        size_t size,
+                                        void *context);
+
+  // PDJSON_TRUE, PDJSON_FALSE, or PDJSON_NULL.
+  //
+  enum pdjson_handler_result (*literal) (enum pdjson_type type,
+                                         void *context);
+};
+
+typedef struct pdjson_handler pdjson_handler;
+
+// Parse the next value calling the handlers for each event. Return
+// PDJSON_DONE if the value has been parsed completely, PDJSON_ERROR in case
+// of an error, or the event for which a handler returned PDJSON_HANDLER_STOP.
+// The handlers may call the accessor functions (pdjson_get_line(),
+// pdjson_get_context(), etc) but not the functions that parse further.
+//
+// Note that in the streaming mode, as with pdjson_next(), the stream has to
+// be reset before parsing the next value.
+//
+LIBPDJSON5_SYMEXPORT enum pdjson_type
+pdjson_parse_callbacks (pdjson_stream *json,
+                        const pdjson_handler *handler,
+                        void *context);
+
 // Skip over the next value, skipping over entire arrays and objects. Return
 // the skipped value.
 //
@@ -195,6 +494,55 @@ pdjson_skip (pdjson_stream *json);
 LIBPDJSON5_SYMEXPORT enum pdjson_type
 pdjson_skip_until (pdjson_stream *json, enum pdjson_type type);
 
+// Validate the rest of the input without returning any events. Return true
+// if the input is valid and false otherwise, in which case pdjson_get_error()
+// and pdjson_get_line/column() describe the error and, if error_pos is not
+// NULL, the error position is stored there. In the streaming mode validate
+// all the values until the end of input.
+//
+// The validation is exactly as performed by pdjson_next() except that the
+// names and values are not copied to the string buffer. As a result, the
+// name/value accessors should not be used after this call.
+//
+LIBPDJSON5_SYMEXPORT bool
+pdjson_validate (pdjson_stream *json, uint64_t *error_pos);
+
+// Top-level array element span (see pdjson_split_array() below).
+//
+struct pdjson_span
+{
+  uint64_t position; // Position of the first byte of the element.
+  uint64_t line;     // Line of the first byte of the element.
+  uint64_t column;   // Column of the first byte of the element.
+  size_t   size;     // Size of the element in bytes.
+};
+
+typedef struct pdjson_span pdjson_span;
+
+// Find the boundaries of the top-level array elements without parsing the
+// elements themselves and store up to n element spans in the spans array.
+// Return the number of spans stored or 0 if there are no more elements. In
+// the latter case call pdjson_next() to check for the trailing text and
+// obtain the final PDJSON_DONE event (or PDJSON_ERROR if there was an error
+// while splitting).
+//
+// This function can only be used with the buffer input and before calling
+// pdjson_next(). It only validates the array itself (brackets, commas, etc)
+// with each element expected to be parsed separately, for example:
+//
+// pdjson_reopen_buffer (ejson, buffer + s->position, s->size);
+// pdjson_set_location (ejson, s->position, s->line, s->column);
+//
+// Because the elements can be parsed independently, this arrangement allows
+// parsing a large array concurrently by distributing the element spans
+// between several threads, each with its own pdjson_stream instance. The
+// line/column/position information reported for each element is the same as
+// when parsing the entire array with pdjson_next() (but note that the
+// diagnostics for some invalid elements may be worded differently).
+//
+LIBPDJSON5_SYMEXPORT size_t
+pdjson_split_array (pdjson_stream *json, pdjson_span *spans, size_t n);
+
 LIBPDJSON5_SYMEXPORT uint64_t
 pdjson_get_line (const pdjson_stream *json);
 
@@ -226,6 +574,39 @@ pdjson_get_context (const pdjson_stream *json, uint64_t *count);
 LIBPDJSON5_SYMEXPORT const char *
 pdjson_get_error (const pdjson_stream *json);
 
+// Parsing statistics.
+//
+// The counters are only maintained if the library is built with the
+// LIBPDJSON5_STATS macro defined and otherwise cost nothing. They are reset
+// when the stream is opened or reopened.
+//
+struct pdjson_stats
+{
+  uint64_t bytes;                   // Input bytes consumed.
+  uint64_t events[PDJSON_NULL + 1]; // Events returned, by type.
+  size_t   max_depth;               // Maximum depth of nesting reached.
+  uint64_t string_bytes;            // Bytes added to name/value buffer.
+  uint64_t string_grows;            // Name/value buffer reallocations.
+  size_t   string_peak;             // Peak name/value buffer size.
+  uint64_t stack_grows;             // Nesting stack reallocations.
+  uint64_t slow_gets;               // Input gets that took the slow path.
+  uint64_t slow_peeks;              // Input peeks that took the slow path.
+  uint64_t comment_bytes;           // Comment bytes skipped.
+  uint64_t escapes;                 // Escape sequences decoded.
+};
+
+typedef struct pdjson_stats pdjson_stats;
+
+// Get the parsing statistics. Return false (and zero all the counters) if
+// the statistics are not enabled (see above).
+//
+// Note that the peeked at events are counted when peeked at and that the
+// events returned by the functions that parse further (pdjson_skip(),
+// pdjson_next_batch(), etc) are counted as well.
+//
+LIBPDJSON5_SYMEXPORT bool
+pdjson_get_stats (const pdjson_stream *json, pdjson_stats *stats);
+
 // Direct byte stream access.
 //
 LIBPDJSON5_SYMEXPORT int
@@ -286,7 +667,11 @@ struct pdjson_source
 {
   enum pdjson_source_tag tag;
   uint64_t position;
-  union
+
+  // Note that this is not a union since in the read-ahead mode the buffer
+  // is used as a window into the stream or user input.
+  //
+  struct
   {
     struct
     {
@@ -305,6 +690,21 @@ struct pdjson_source
       pdjson_user_io io;
     } user;
   } source;
+
+  // Read-ahead window. If tag is not 0, then it is the underlying input
+  // (stream or user) and the source tag is PDJSON_SOURCE_BUFFER.
+  //
+  struct
+  {
+    enum pdjson_source_tag tag;
+    char *data;
+    size_t size;
+  } window;
+
+  // Number of buffer bytes hidden beyond the end of the current length
+  // frame.
+  //
+  size_t hidden;
 };
 
 struct pdjson_stream
@@ -339,11 +739,48 @@ struct pdjson_stream
   size_t   lineadj; // Adjustment for multi-byte UTF-8 sequences.
   size_t   linecon; // Number of remaining UTF-8 continuation bytes.
 
+  // Offset of the source position from the reported position (see
+  // pdjson_set_location()).
+  //
+  uint64_t posoff;
+
   // Start line/column for value events or 0.
   //
   uint64_t start_lineno;
   uint64_t start_colno;
 
+  // Framing mode and the current frame state: the end position of the
+  // length frame (or UINT64_MAX if none) and the start line of the line
+  // frame.
+  //
+  enum pdjson_framing framing;
+  uint64_t frame_end;
+  uint64_t frame_line;
+
+  // Line framing mode prefilter patterns.
+  //
+  const char *const *prefilter;
+  size_t prefilter_size;
+
+  // Member name dictionary: names by ID and the open addressing hash table
+  // of IDs (with the power of two size).
+  //
+  struct
+  {
+    struct pdjson_name *entries;
+    size_t size;
+    size_t capacity;
+    size_t known;  // Number of registered names.
+    size_t intern; // Maximum number of interned names.
+
+    char *pool;
+    size_t pool_size;
+    size_t pool_capacity;
+
+    size_t *table;
+    size_t table_size;
+  } names;
+
   struct pdjson_stack *stack;
   size_t stack_top;
   size_t stack_size;
@@ -363,6 +800,7 @@ struct pdjson_stream
   struct
   {
     char *string;
+    size_t string_start; // Start of the current name/value.
     size_t string_fill;
     size_t string_size;
   } data;
@@ -373,6 +811,8 @@ struct pdjson_stream
   struct pdjson_allocator alloc;
   void *alloc_data;
 
+  struct pdjson_stats stats; // Only maintained with LIBPDJSON5_STATS.
+
   char error_message[128];
   char utf8_char[6]; // Up to 4 for UTF-8, 2 for quotes, one for \0.
 };
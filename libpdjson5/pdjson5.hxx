@@ -0,0 +1,738 @@
+#ifndef LIBPDJSON5_PDJSON5_HXX
+#define LIBPDJSON5_PDJSON5_HXX
+
+// Header-only C++17 layer on top of the C API.
+//
+// The parser class owns the underlying pdjson_stream, names and values are
+// returned as std::string_view (valid until the next call that advances the
+// parser), and errors are reported as exceptions. For example:
+//
+// pdjson5::parser p (text);
+//
+// if (p.next () == pdjson5::event::object)
+// {
+//   for (std::string_view n: p.members ())
+//   {
+//     if (n == "port" && p.next () == pdjson5::event::number)
+//       port = p.number<std::uint16_t> ();
+//
+//     // Unconsumed (or partially consumed) values are skipped.
+//   }
+// }
+//
+// If compiled in the C++20 mode with coroutines support, the events of a
+// value can also be iterated over with the events() generator.
+//
+#include <limits>
+#include <cstdio>      // FILE
+#include <cstdint>
+#include <cstddef>     // size_t, ptrdiff_t, max_align_t
+#include <cstring>     // memcpy()
+#include <iterator>    // input_iterator_tag
+#include <stdexcept>   // runtime_error, invalid_argument, out_of_range
+#include <string_view>
+#include <type_traits>
+#include <system_error> // errc
+#include <charconv>     // from_chars()
+#include <memory_resource>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#  include <coroutine>
+#  include <exception> // exception_ptr
+#  define LIBPDJSON5_COROUTINES 1
+#endif
+
+#include <libpdjson5/pdjson5.h>
+
+namespace pdjson5
+{
+  enum class event
+  {
+    done        = PDJSON_DONE,
+    object      = PDJSON_OBJECT,
+    object_end  = PDJSON_OBJECT_END,
+    array       = PDJSON_ARRAY,
+    array_end   = PDJSON_ARRAY_END,
+    name        = PDJSON_NAME,
+    string      = PDJSON_STRING,
+    number      = PDJSON_NUMBER,
+    true_       = PDJSON_TRUE,
+    false_      = PDJSON_FALSE,
+    null        = PDJSON_NULL
+  };
+
+  enum class language
+  {
+    json   = PDJSON_LANGUAGE_JSON,
+    json5  = PDJSON_LANGUAGE_JSON5,
+    json5e = PDJSON_LANGUAGE_JSON5E
+  };
+
+  enum class error_subtype
+  {
+    syntax = PDJSON_ERROR_SYNTAX,
+    memory = PDJSON_ERROR_MEMORY,
+    io     = PDJSON_ERROR_IO
+  };
+
+  // Thrown instead of returning the PDJSON_ERROR event. The what() string
+  // is the error message as returned by pdjson_get_error().
+  //
+  class error: public std::runtime_error
+  {
+  public:
+    error_subtype subtype;
+    std::uint64_t line;
+    std::uint64_t column;
+    std::uint64_t position;
+
+    error (error_subtype s,
+           std::uint64_t l,
+           std::uint64_t c,
+           std::uint64_t p,
+           const char* m)
+        : std::runtime_error (m), subtype (s), line (l), column (c),
+          position (p) {}
+  };
+
+  // Adapter of std::pmr::memory_resource to pdjson_allocator. Because
+  // pdjson_allocator's realloc() is not passed the old size, each block is
+  // prefixed with a header that stores its size. Allocation failures
+  // (exceptions) are reported as memory errors by the parser.
+  //
+  struct memory_resource_allocator
+  {
+    static constexpr std::size_t header = alignof (std::max_align_t);
+
+    static const pdjson_allocator functions;
+
+    static void*
+    allocate (std::size_t n, void* r) noexcept
+    {
+      if (n > std::numeric_limits<std::size_t>::max () - header)
+        return nullptr;
+
+      n += header;
+
+      void* p;
+      try
+      {
+        p = static_cast<std::pmr::memory_resource*> (r)->allocate (
+          n, alignof (std::max_align_t));
+      }
+      catch (...)
+      {
+        return nullptr;
+      }
+
+      std::memcpy (p, &n, sizeof (n));
+      return static_cast<char*> (p) + header;
+    }
+
+    static void
+    deallocate (void* p, std::size_t, void* r) noexcept
+    {
+      if (p == nullptr)
+        return;
+
+      char* b (static_cast<char*> (p) - header);
+
+      std::size_t n;
+      std::memcpy (&n, b, sizeof (n));
+
+      static_cast<std::pmr::memory_resource*> (r)->deallocate (
+        b, n, alignof (std::max_align_t));
+    }
+
+    static void*
+    reallocate (void* p, std::size_t n, void* r) noexcept
+    {
+      void* np (allocate (n, r));
+
+      if (np != nullptr && p != nullptr)
+      {
+        std::size_t on;
+        std::memcpy (&on, static_cast<char*> (p) - header, sizeof (on));
+        on -= header;
+
+        std::memcpy (np, p, on < n ? on : n);
+        deallocate (p, on, r);
+      }
+
+      return np;
+    }
+  };
+
+  inline const pdjson_allocator memory_resource_allocator::functions = {
+    &memory_resource_allocator::allocate,
+    &memory_resource_allocator::reallocate,
+    &memory_resource_allocator::deallocate};
+
+  class parser;
+
+  // Input iterator over object member names (see parser::members()).
+  //
+  class member_iterator
+  {
+  public:
+    using value_type        = std::string_view;
+    using reference         = const std::string_view&;
+    using pointer           = const std::string_view*;
+    using difference_type   = std::ptrdiff_t;
+    using iterator_category = std::input_iterator_tag;
+
+    member_iterator () = default; // End.
+    member_iterator (parser& p, std::size_t d): p_ (&p), d_ (d) {advance ();}
+
+    reference operator* () const {return n_;}
+    pointer operator-> () const {return &n_;}
+
+    member_iterator& operator++ () {advance (); return *this;}
+    void operator++ (int) {advance ();}
+
+    friend bool
+    operator== (const member_iterator& x, const member_iterator& y)
+    {
+      return x.p_ == y.p_;
+    }
+
+    friend bool
+    operator!= (const member_iterator& x, const member_iterator& y)
+    {
+      return !(x == y);
+    }
+
+  private:
+    void
+    advance ();
+
+  private:
+    parser* p_ = nullptr;
+    std::size_t d_ = 0;
+    std::string_view n_;
+  };
+
+  // Input iterator over array element events (see parser::elements()).
+  //
+  class element_iterator
+  {
+  public:
+    using value_type        = event;
+    using reference         = const event&;
+    using pointer           = const event*;
+    using difference_type   = std::ptrdiff_t;
+    using iterator_category = std::input_iterator_tag;
+
+    element_iterator () = default; // End.
+    element_iterator (parser& p, std::size_t d): p_ (&p), d_ (d) {advance ();}
+
+    reference operator* () const {return e_;}
+    pointer operator-> () const {return &e_;}
+
+    element_iterator& operator++ () {advance (); return *this;}
+    void operator++ (int) {advance ();}
+
+    friend bool
+    operator== (const element_iterator& x, const element_iterator& y)
+    {
+      return x.p_ == y.p_;
+    }
+
+    friend bool
+    operator!= (const element_iterator& x, const element_iterator& y)
+    {
+      return !(x == y);
+    }
+
+  private:
+    void
+    advance ();
+
+  private:
+    parser* p_ = nullptr;
+    std::size_t d_ = 0;
+    event e_ = event::done;
+  };
+
+  template <typename I>
+  class range
+  {
+  public:
+    range (parser& p, std::size_t d): p_ (p), d_ (d) {}
+
+    I begin () const {return I (p_, d_);}
+    I end () const {return I ();}
+
+  private:
+    parser& p_;
+    std::size_t d_;
+  };
+
+#ifdef LIBPDJSON5_COROUTINES
+  // Generator of parsing events (see parser::events()).
+  //
+  class event_generator
+  {
+  public:
+    struct promise_type
+    {
+      event value = event::done;
+      std::exception_ptr exception;
+
+      event_generator
+      get_return_object () noexcept
+      {
+        return event_generator (handle::from_promise (*this));
+      }
+
+      std::suspend_always initial_suspend () const noexcept {return {};}
+      std::suspend_always final_suspend () const noexcept {return {};}
+
+      std::suspend_always
+      yield_value (event e) noexcept
+      {
+        value = e;
+        return {};
+      }
+
+      void return_void () const noexcept {}
+      void unhandled_exception () {exception = std::current_exception ();}
+    };
+
+    using handle = std::coroutine_handle<promise_type>;
+
+    class iterator
+    {
+    public:
+      using value_type        = event;
+      using reference         = const event&;
+      using pointer           = const event*;
+      using difference_type   = std::ptrdiff_t;
+      using iterator_category = std::input_iterator_tag;
+
+      iterator () = default; // End.
+      explicit iterator (handle h): h_ (h) {resume ();}
+
+      reference operator* () const {return h_.promise ().value;}
+
+      iterator& operator++ () {resume (); return *this;}
+      void operator++ (int) {resume ();}
+
+      friend bool
+      operator== (const iterator& x, const iterator& y)
+      {
+        return x.h_ == y.h_;
+      }
+
+      friend bool
+      operator!= (const iterator& x, const iterator& y)
+      {
+        return !(x == y);
+      }
+
+    private:
+      void
+      resume ()
+      {
+        h_.resume ();
+
+        if (h_.done ())
+        {
+          std::exception_ptr e (std::move (h_.promise ().exception));
+          h_ = nullptr;
+
+          if (e)
+            std::rethrow_exception (e);
+        }
+      }
+
+    private:
+      handle h_;
+    };
+
+    event_generator (event_generator&& x) noexcept: h_ (x.h_) {x.h_ = nullptr;}
+    event_generator (const event_generator&) = delete;
+    event_generator& operator= (const event_generator&) = delete;
+    event_generator& operator= (event_generator&&) = delete;
+
+    ~event_generator () {if (h_) h_.destroy ();}
+
+    // Note that a generator can only be iterated over once.
+    //
+    iterator begin () {return iterator (h_);}
+    iterator end () const {return iterator ();}
+
+  private:
+    explicit event_generator (handle h): h_ (h) {}
+
+    handle h_;
+  };
+#endif
+
+  class parser
+  {
+  public:
+    // Parse the buffer, which should remain valid while the parser is in
+    // use. If the memory resource is not NULL, then use it to allocate the
+    // parser memory.
+    //
+    explicit
+    parser (std::string_view buffer, std::pmr::memory_resource* mr = nullptr)
+    {
+      pdjson_open_buffer (&s_, buffer.data (), buffer.size ());
+      set_resource (mr);
+    }
+
+    // Parse the stream, which should remain open while the parser is in use.
+    //
+    explicit
+    parser (std::FILE* stream, std::pmr::memory_resource* mr = nullptr)
+    {
+      pdjson_open_stream (&s_, stream);
+      set_resource (mr);
+    }
+
+    ~parser () {if (open_) pdjson_close (&s_);}
+
+    // Note that pdjson_stream contains no pointers into itself and so can be
+    // moved by copying its bytes.
+    //
+    parser (parser&& x) noexcept: open_ (x.open_)
+    {
+      std::memcpy (&s_, &x.s_, sizeof (s_));
+      x.open_ = false;
+    }
+
+    parser&
+    operator= (parser&& x) noexcept
+    {
+      if (this != &x)
+      {
+        if (open_)
+          pdjson_close (&s_);
+
+        std::memcpy (&s_, &x.s_, sizeof (s_));
+        open_ = x.open_;
+        x.open_ = false;
+      }
+
+      return *this;
+    }
+
+    parser (const parser&) = delete;
+    parser& operator= (const parser&) = delete;
+
+    void
+    set_streaming (bool mode) {pdjson_set_streaming (&s_, mode);}
+
+    void
+    set_language (language l)
+    {
+      pdjson_set_language (&s_, static_cast<pdjson_language> (l));
+    }
+
+    // Return the next event or throw error.
+    //
+    event
+    next () {return check (pdjson_next (&s_));}
+
+    event
+    peek () {return check (pdjson_peek (&s_));}
+
+    // Skip over the next value (see pdjson_skip()) and return its event.
+    //
+    event
+    skip () {return check (pdjson_skip (&s_));}
+
+    void
+    reset () {pdjson_reset (&s_);}
+
+    // Return the member name after event::name or the string or number
+    // value after event::string or event::number. The string remains valid
+    // until the parser is advanced.
+    //
+    std::string_view
+    name () const
+    {
+      std::size_t n;
+      const char* s (pdjson_get_name (&s_, &n));
+      return std::string_view (s, n - 1);
+    }
+
+    std::string_view
+    value () const
+    {
+      std::size_t n;
+      const char* s (pdjson_get_value (&s_, &n));
+      return std::string_view (s, n - 1);
+    }
+
+    // Convert the number value after event::number to the specified integer
+    // or floating point type. Throw std::invalid_argument if the number is
+    // not representable by the type (for example, has a fraction for an
+    // integer type) and std::out_of_range if it is out of the type's range.
+    // JSON5 hexadecimal integers, explicit plus signs, and (for floating
+    // point types) Infinity and NaN are supported.
+    //
+    template <typename T>
+    T
+    number () const;
+
+    std::uint64_t line () const {return pdjson_get_line (&s_);}
+    std::uint64_t column () const {return pdjson_get_column (&s_);}
+    std::uint64_t position () const {return pdjson_get_position (&s_);}
+    std::size_t depth () const {return pdjson_get_depth (&s_);}
+
+    // Iterate over the members of the object or elements of the array that
+    // have just been started (that is, right after event::object or
+    // event::array). For members, the name is returned and the value should
+    // be read with next(). For elements, the first event of each element is
+    // returned and, if it is event::object or event::array, the rest of it
+    // can be read with next() (or members()/elements()). In both cases, the
+    // value or its remainder that was not read is skipped with pdjson_skip()
+    // and the iteration ends after the closing event is consumed.
+    //
+    range<member_iterator>
+    members () {return range<member_iterator> (*this, consumed_depth ());}
+
+    range<element_iterator>
+    elements () {return range<element_iterator> (*this, consumed_depth ());}
+
+#ifdef LIBPDJSON5_COROUTINES
+    // Generate the events of the next value until (but not including)
+    // event::done. Note that the parser should outlive the generator.
+    //
+    event_generator
+    events ()
+    {
+      for (event e; (e = next ()) != event::done; )
+        co_yield e;
+    }
+#endif
+
+    // Access the underlying C API stream.
+    //
+    pdjson_stream* handle () {return &s_;}
+    const pdjson_stream* handle () const {return &s_;}
+
+  private:
+    void
+    set_resource (std::pmr::memory_resource* mr)
+    {
+      if (mr != nullptr)
+        pdjson_set_allocator (&s_, &memory_resource_allocator::functions, mr);
+    }
+
+    event
+    check (pdjson_type t) const
+    {
+      if (t == PDJSON_ERROR)
+        throw error (static_cast<error_subtype> (
+                       pdjson_get_error_subtype (&s_)),
+                     line (),
+                     column (),
+                     position (),
+                     pdjson_get_error (&s_));
+
+      return static_cast<event> (t);
+    }
+
+    // Return the depth as of the last consumed event, that is, disregarding
+    // the peeked event, if any.
+    //
+    std::size_t
+    consumed_depth () const
+    {
+      std::size_t d (depth ());
+
+      switch (s_.peek)
+      {
+      case PDJSON_OBJECT:
+      case PDJSON_ARRAY:      return d - 1;
+      case PDJSON_OBJECT_END:
+      case PDJSON_ARRAY_END:  return d + 1;
+      default:                return d;
+      }
+    }
+
+    friend class member_iterator;
+    friend class element_iterator;
+
+    // Finish the partially read or skip the unread value at depth d, that
+    // is, the value of the last returned member or element.
+    //
+    void
+    finish (std::size_t d)
+    {
+      // Note that after peeking the parser state already reflects the
+      // peeked event and pdjson_skip() picks it up.
+      //
+      while (depth () > d)
+        skip ();
+    }
+
+  private:
+    pdjson_stream s_;
+    bool open_ = true;
+  };
+
+  inline void member_iterator::
+  advance ()
+  {
+    parser& p (*p_);
+
+    for (;;)
+    {
+      if (p.s_.peek == 0)
+      {
+        p.finish (d_);
+
+        // Skip the value if only the name has been read (the number of
+        // events observed at this level is odd).
+        //
+        std::uint64_t n;
+        pdjson_get_context (&p.s_, &n);
+
+        if (n % 2 != 0)
+        {
+          p.skip ();
+          continue;
+        }
+      }
+
+      event e (p.next ());
+      std::size_t d (p.depth ());
+
+      if (d < d_ || e == event::done) // End of this object.
+      {
+        p_ = nullptr;
+        return;
+      }
+
+      if (d == d_ && e == event::name)
+      {
+        n_ = p.name ();
+        return;
+      }
+
+      // Otherwise this is a peeked event that has now been consumed.
+    }
+  }
+
+  inline void element_iterator::
+  advance ()
+  {
+    parser& p (*p_);
+
+    for (;;)
+    {
+      if (p.s_.peek == 0)
+        p.finish (d_);
+
+      event e (p.next ());
+      std::size_t d (p.depth ());
+
+      if (d < d_ || e == event::done) // End of this array.
+      {
+        p_ = nullptr;
+        return;
+      }
+
+      // An element is either a scalar at this depth or the start of an
+      // object/array one level deeper.
+      //
+      if (e == event::object || e == event::array
+          ? d == d_ + 1
+          : d == d_ && e != event::object_end && e != event::array_end)
+      {
+        e_ = e;
+        return;
+      }
+
+      // Otherwise this is a peeked event that has now been consumed.
+    }
+  }
+
+  template <typename T>
+  T parser::
+  number () const
+  {
+    static_assert (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>,
+                   "integer or floating point type expected");
+
+    std::string_view v (value ());
+    const char* b (v.data ());
+    const char* e (b + v.size ());
+
+    bool neg (false);
+    if (b != e && (*b == '-' || *b == '+'))
+      neg = *b++ == '-';
+
+    bool hex (e - b > 2 && b[0] == '0' && (b[1] == 'x' || b[1] == 'X'));
+
+    // Parse the magnitude of a decimal or hexadecimal integer.
+    //
+    auto integer = [b, e, hex] ()
+    {
+      unsigned long long m;
+      auto r (std::from_chars (b + (hex ? 2 : 0), e, m, hex ? 16 : 10));
+
+      if (r.ec == std::errc::result_out_of_range)
+        throw std::out_of_range ("number out of range");
+
+      if (r.ec != std::errc () || r.ptr != e)
+        throw std::invalid_argument ("invalid integer number");
+
+      return m;
+    };
+
+    if constexpr (std::is_integral_v<T>)
+    {
+      unsigned long long m (integer ());
+
+      using U = std::make_unsigned_t<T>;
+      constexpr unsigned long long max (std::numeric_limits<T>::max ());
+
+      if constexpr (std::is_signed_v<T>)
+      {
+        if (neg ? m > max + 1 : m > max)
+          throw std::out_of_range ("number out of range");
+
+        return neg ? static_cast<T> (U (0) - static_cast<U> (m))
+                   : static_cast<T> (m);
+      }
+      else
+      {
+        if (m > max || (neg && m != 0))
+          throw std::out_of_range ("number out of range");
+
+        return static_cast<T> (m);
+      }
+    }
+    else
+    {
+      T r;
+
+      if (hex)
+        r = static_cast<T> (integer ());
+      else if (std::string_view (b, e - b) == "Infinity")
+        r = std::numeric_limits<T>::infinity ();
+      else if (std::string_view (b, e - b) == "NaN")
+        r = std::numeric_limits<T>::quiet_NaN ();
+      else
+      {
+        auto cr (std::from_chars (b, e, r));
+
+        if (cr.ec == std::errc::result_out_of_range)
+          throw std::out_of_range ("number out of range");
+
+        if (cr.ec != std::errc () || cr.ptr != e)
+          throw std::invalid_argument ("invalid floating point number");
+      }
+
+      return neg ? -r : r;
+    }
+  }
+}
+
+#endif // LIBPDJSON5_PDJSON5_HXX
@@ -0,0 +1,1182 @@
+// Usage: pdjson5-gen <schema> <output>
+//
+// Generate C struct definitions and their deserialization functions from
+// the schema, writing them into <output>.h and <output>.c.
+//
+// The schema is a JSON5E object with each member defining a struct and each
+// struct member defining a field. The field type is either a string that
+// names the value type or a single-element array that contains such a
+// string for the array of values, for example:
+//
+// # Order line.
+// #
+// item: {
+//   sku: "string"
+//   quantity: "uint32"
+//   price: "double"
+// }
+//
+// order: {
+//   id: "uint64"
+//   paid: "bool"
+//   items: ["item"]
+//   ship-to: "address"
+// }
+//
+// The value type is one of bool, int32, int64, uint32, uint64, double,
+// string, or the name of a struct defined earlier in the schema. Field
+// names that are not valid C identifiers are mapped by replacing invalid
+// characters with `_` (and appending `_` to C keywords).
+//
+// For each struct the following functions are generated:
+//
+// const char *<struct>_parse (pdjson_stream *json, struct <struct> *v);
+// void <struct>_free (struct <struct> *v);
+//
+// The parse function zero-initializes the struct and reads the next value
+// into it, returning NULL on success or the error message otherwise (with
+// pdjson_get_line/column() pointing to the offending value). Unknown
+// members are skipped with pdjson_skip() and missing members leave the
+// fields zero. The free function releases the strings and arrays and
+// should be called even if parsing failed.
+//
+
+#include <stdio.h>
+#include <ctype.h>  // isalnum(), isprint()
+#include <stdlib.h> // malloc(), realloc(), free(), exit()
+#include <string.h> // str*(), mem*()
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h> // PR*
+
+#include <libpdjson5/pdjson5.h>
+
+enum kind
+{
+  KIND_BOOL,
+  KIND_INT32,
+  KIND_INT64,
+  KIND_UINT32,
+  KIND_UINT64,
+  KIND_DOUBLE,
+  KIND_STRING,
+  KIND_STRUCT,
+  KIND_COUNT = KIND_STRUCT
+};
+
+static const char *const kind_names[] = {
+  "bool", "int32", "int64", "uint32", "uint64", "double", "string"};
+
+static const char *const kind_types[] = {
+  "bool", "int32_t", "int64_t", "uint32_t", "uint64_t", "double", "char *"};
+
+struct field
+{
+  char *name;   // Member name.
+  size_t size;  // Member name size (without `\0`).
+  char *id;     // C identifier.
+  enum kind kind;
+  size_t ref;   // Struct index if kind is KIND_STRUCT.
+  bool array;
+};
+
+struct type
+{
+  char *name;
+  struct field *fields;
+  size_t fields_size;
+};
+
+static struct type *types = NULL;
+static size_t types_size = 0;
+
+// Types and array element types used (so that we only generate the helper
+// functions that are necessary).
+//
+static bool used[KIND_COUNT];
+static bool used_array[KIND_COUNT];
+static bool *used_struct_array = NULL;
+
+static void *
+xrealloc (void *p, size_t n)
+{
+  if ((p = realloc (p, n)) == NULL)
+  {
+    fprintf (stderr, "error: out of memory\n");
+    exit (1);
+  }
+
+  return p;
+}
+
+static char *
+xstrdup (const char *s, size_t n)
+{
+  char *r = (char *)xrealloc (NULL, n + 1);
+  memcpy (r, s, n);
+  r[n] = '\0';
+  return r;
+}
+
+static bool
+is_keyword (const char *s)
+{
+  static const char *const keywords[] = {
+    "auto", "break", "case", "char", "const", "continue", "default", "do",
+    "double", "else", "enum", "extern", "float", "for", "goto", "if",
+    "inline", "int", "long", "register", "restrict", "return", "short",
+    "signed", "sizeof", "static", "struct", "switch", "typedef", "union",
+    "unsigned", "void", "volatile", "while", "bool", "true", "false"};
+
+  for (size_t i = 0; i != sizeof (keywords) / sizeof (keywords[0]); ++i)
+  {
+    if (strcmp (s, keywords[i]) == 0)
+      return true;
+  }
+
+  return false;
+}
+
+// Map the name to a C identifier.
+//
+static char *
+identifier (const char *s, size_t n)
+{
+  char *r = (char *)xrealloc (NULL, n + 3);
+  size_t i = 0;
+
+  if (!isalpha ((unsigned char)s[0]) && s[0] != '_')
+    r[i++] = '_';
+
+  for (size_t j = 0; j != n; ++j)
+    r[i++] = isalnum ((unsigned char)s[j]) ? s[j] : '_';
+
+  r[i] = '\0';
+
+  if (is_keyword (r))
+  {
+    r[i++] = '_';
+    r[i] = '\0';
+  }
+
+  return r;
+}
+
+static bool
+is_identifier (const char *s, size_t n)
+{
+  if (n == 0 || (!isalpha ((unsigned char)s[0]) && s[0] != '_'))
+    return false;
+
+  for (size_t i = 0; i != n; ++i)
+  {
+    if (!isalnum ((unsigned char)s[i]) && s[i] != '_')
+      return false;
+  }
+
+  return !is_keyword (s);
+}
+
+static const char *schema_path;
+
+static bool
+error (pdjson_stream *json, const char *m, const char *a)
+{
+  fprintf (stderr,
+           "%s:%" PRIu64 ":%" PRIu64 ": error: ",
+           schema_path,
+           pdjson_get_line (json),
+           pdjson_get_column (json));
+
+  if (a != NULL)
+    fprintf (stderr, m, a);
+  else
+    fputs (m, stderr);
+
+  fputc ('\n', stderr);
+  return false;
+}
+
+// Parse the field type that starts with the specified event.
+//
+static bool
+parse_type (pdjson_stream *json, enum pdjson_type t, struct field *f)
+{
+  if ((f->array = (t == PDJSON_ARRAY)))
+    t = pdjson_next (json);
+
+  if (t == PDJSON_ERROR)
+    return error (json, pdjson_get_error (json), NULL);
+
+  if (t != PDJSON_STRING)
+    return error (json, "expected type name string", NULL);
+
+  size_t n;
+  const char *s = pdjson_get_value (json, &n);
+
+  size_t i = 0;
+  for (; i != KIND_COUNT && strcmp (s, kind_names[i]) != 0; ++i) ;
+
+  if (i != KIND_COUNT)
+    f->kind = (enum kind)i;
+  else
+  {
+    for (i = 0; i != types_size && strcmp (s, types[i].name) != 0; ++i) ;
+
+    if (i == types_size)
+      return error (json, "unknown type '%s'", s);
+
+    f->kind = KIND_STRUCT;
+    f->ref = i;
+  }
+
+  if (f->array)
+  {
+    t = pdjson_next (json);
+
+    if (t == PDJSON_ERROR)
+      return error (json, pdjson_get_error (json), NULL);
+
+    if (t != PDJSON_ARRAY_END)
+      return error (json, "expected end of array element type", NULL);
+  }
+
+  return true;
+}
+
+static bool
+parse_struct (pdjson_stream *json, struct type *s)
+{
+  enum pdjson_type t = pdjson_next (json);
+
+  if (t == PDJSON_ERROR)
+    return error (json, pdjson_get_error (json), NULL);
+
+  if (t != PDJSON_OBJECT)
+    return error (json, "expected struct definition object", NULL);
+
+  while ((t = pdjson_next (json)) == PDJSON_NAME)
+  {
+    size_t n;
+    const char *m = pdjson_get_name (json, &n);
+
+    if (n == 1 || memchr (m, '\0', n - 1) != NULL)
+      return error (json, "invalid field name", NULL);
+
+    s->fields = (struct field *)
+      xrealloc (s->fields, (s->fields_size + 1) * sizeof (struct field));
+
+    struct field *f = s->fields + s->fields_size++;
+    f->name = xstrdup (m, n - 1);
+    f->size = n - 1;
+    f->id = identifier (m, n - 1);
+    f->ref = 0;
+
+    for (size_t i = 0; i != s->fields_size - 1; ++i)
+    {
+      if (strcmp (s->fields[i].id, f->id) == 0)
+        return error (json, "duplicate field '%s'", f->id);
+    }
+
+    if (!parse_type (json, pdjson_next (json), f))
+      return false;
+  }
+
+  if (t == PDJSON_ERROR)
+    return error (json, pdjson_get_error (json), NULL);
+
+  if (s->fields_size == 0)
+    return error (json, "struct '%s' has no fields", s->name);
+
+  return true;
+}
+
+static bool
+parse_schema (pdjson_stream *json)
+{
+  enum pdjson_type t = pdjson_next (json);
+
+  if (t == PDJSON_ERROR)
+    return error (json, pdjson_get_error (json), NULL);
+
+  if (t != PDJSON_OBJECT)
+    return error (json, "expected schema object", NULL);
+
+  while ((t = pdjson_next (json)) == PDJSON_NAME)
+  {
+    size_t n;
+    const char *m = pdjson_get_name (json, &n);
+
+    if (!is_identifier (m, n - 1))
+      return error (json, "invalid struct name '%s'", m);
+
+    for (size_t i = 0; i != KIND_COUNT; ++i)
+    {
+      if (strcmp (m, kind_names[i]) == 0)
+        return error (json, "struct name '%s' is reserved", m);
+    }
+
+    for (size_t i = 0; i != types_size; ++i)
+    {
+      if (strcmp (m, types[i].name) == 0)
+        return error (json, "duplicate struct '%s'", m);
+    }
+
+    types = (struct type *)
+      xrealloc (types, (types_size + 1) * sizeof (struct type));
+
+    struct type *s = types + types_size;
+    s->name = xstrdup (m, n - 1);
+    s->fields = NULL;
+    s->fields_size = 0;
+
+    if (!parse_struct (json, s))
+    {
+      types_size++; // Free it.
+      return false;
+    }
+
+    types_size++;
+  }
+
+  if (t == PDJSON_ERROR)
+    return error (json, pdjson_get_error (json), NULL);
+
+  if ((t = pdjson_next (json)) != PDJSON_DONE)
+    return error (json,
+                  t == PDJSON_ERROR ? pdjson_get_error (json)
+                                    : "expected end of text",
+                  NULL);
+
+  return true;
+}
+
+// Return the C type of the field value (array element).
+//
+static void
+print_value_type (FILE *o, const struct field *f)
+{
+  if (f->kind == KIND_STRUCT)
+    fprintf (o, "struct %s ", types[f->ref].name);
+  else
+    fprintf (o, "%s%s",
+             kind_types[f->kind],
+             f->kind == KIND_STRING ? "" : " ");
+}
+
+// Return the name of the value (array element) reader function suffix.
+//
+static const char *
+value_name (const struct field *f)
+{
+  return f->kind == KIND_STRUCT ? types[f->ref].name : kind_names[f->kind];
+}
+
+// Print the name bytes as a C string literal body.
+//
+static void
+print_literal (FILE *o, const char *s, size_t n)
+{
+  for (size_t i = 0; i != n; ++i)
+  {
+    unsigned char c = (unsigned char)s[i];
+
+    if (c == '"' || c == '\\')
+      fprintf (o, "\\%c", c);
+    else if (isprint (c) && c != '?') // Avoid trigraphs.
+      fputc (c, o);
+    else
+      fprintf (o, "\\%03o", c);
+  }
+}
+
+static void
+print_char (FILE *o, char ch)
+{
+  unsigned char c = (unsigned char)ch;
+
+  if (c == '\'' || c == '\\')
+    fprintf (o, "'\\%c'", c);
+  else if (isprint (c) && c != '?')
+    fprintf (o, "'%c'", c);
+  else
+    fprintf (o, "'\\%03o'", c);
+}
+
+static void
+generate_header (FILE *o, const char *guard)
+{
+  fprintf (o,
+           "// Generated by pdjson5-gen from %s. Do not edit.\n"
+           "//\n"
+           "\n"
+           "#ifndef %s\n"
+           "#define %s\n"
+           "\n"
+           "#include <stdint.h>\n"
+           "#include <stddef.h> // size_t\n"
+           "#include <stdbool.h>\n"
+           "\n"
+           "#include <libpdjson5/pdjson5.h>\n"
+           "\n"
+           "#ifdef __cplusplus\n"
+           "extern \"C\"\n"
+           "{\n"
+           "#endif // __cplusplus\n",
+           schema_path,
+           guard,
+           guard);
+
+  for (size_t i = 0; i != types_size; ++i)
+  {
+    const struct type *s = types + i;
+
+    fprintf (o, "\nstruct %s\n{\n", s->name);
+
+    for (size_t j = 0; j != s->fields_size; ++j)
+    {
+      const struct field *f = s->fields + j;
+
+      if (f->array)
+      {
+        fprintf (o, "  struct\n  {\n    ");
+        print_value_type (o, f);
+        fprintf (o, "*data;\n    size_t size;\n  } %s;\n", f->id);
+      }
+      else
+      {
+        fprintf (o, "  ");
+        print_value_type (o, f);
+        fprintf (o, "%s;\n", f->id);
+      }
+    }
+
+    fprintf (o,
+             "};\n"
+             "\n"
+             "const char *\n"
+             "%s_parse (pdjson_stream *json, struct %s *v);\n"
+             "\n"
+             "void\n"
+             "%s_free (struct %s *v);\n",
+             s->name, s->name, s->name, s->name);
+  }
+
+  fprintf (o,
+           "\n"
+           "#ifdef __cplusplus\n"
+           "} // extern \"C\"\n"
+           "#endif // __cplusplus\n"
+           "\n"
+           "#endif // %s\n",
+           guard);
+}
+
+// Helper functions for the built-in types.
+//
+static const char mismatch_function[] =
+  "// Return the parsing error message if the event is PDJSON_ERROR and the\n"
+  "// type mismatch message otherwise.\n"
+  "//\n"
+  "static const char *\n"
+  "mismatch (pdjson_stream *json, enum pdjson_type t, const char *m)\n"
+  "{\n"
+  "  return t == PDJSON_ERROR ? pdjson_get_error (json) : m;\n"
+  "}\n"
+  "\n"
+  "// Returned by the member dispatch for unknown members.\n"
+  "//\n"
+  "static const char unknown[] = \"unknown member\";\n";
+
+static const char integer_function[] =
+  "\n"
+  "// Parse the decimal or (JSON5) hexadecimal integer number value into its\n"
+  "// sign and magnitude.\n"
+  "//\n"
+  "static const char *\n"
+  "parse_integer (pdjson_stream *json,\n"
+  "               enum pdjson_type t,\n"
+  "               bool *neg,\n"
+  "               uint64_t *m)\n"
+  "{\n"
+  "  if (t != PDJSON_NUMBER)\n"
+  "    return mismatch (json, t, \"expected number\");\n"
+  "\n"
+  "  size_t n;\n"
+  "  const char *s = pdjson_get_value (json, &n);\n"
+  "  const char *e = s + n - 1;\n"
+  "\n"
+  "  *neg = false;\n"
+  "  if (*s == '-' || *s == '+')\n"
+  "    *neg = *s++ == '-';\n"
+  "\n"
+  "  unsigned int b = 10;\n"
+  "  if (e - s > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))\n"
+  "  {\n"
+  "    b = 16;\n"
+  "    s += 2;\n"
+  "  }\n"
+  "\n"
+  "  uint64_t r = 0;\n"
+  "  for (; s != e; ++s)\n"
+  "  {\n"
+  "    unsigned int d;\n"
+  "    char c = *s;\n"
+  "\n"
+  "    if (c >= '0' && c <= '9')\n"
+  "      d = (unsigned int)(c - '0');\n"
+  "    else if (b == 16 && c >= 'a' && c <= 'f')\n"
+  "      d = (unsigned int)(c - 'a' + 10);\n"
+  "    else if (b == 16 && c >= 'A' && c <= 'F')\n"
+  "      d = (unsigned int)(c - 'A' + 10);\n"
+  "    else\n"
+  "      return \"expected integer\";\n"
+  "\n"
+  "    if (r > (UINT64_MAX - d) / b)\n"
+  "      return \"number out of range\";\n"
+  "\n"
+  "    r = r * b + d;\n"
+  "  }\n"
+  "\n"
+  "  *m = r;\n"
+  "  return NULL;\n"
+  "}\n";
+
+static const char signed_function[] =
+  "\n"
+  "static const char *\n"
+  "read_signed (pdjson_stream *json,\n"
+  "             enum pdjson_type t,\n"
+  "             int64_t max,\n"
+  "             int64_t *r)\n"
+  "{\n"
+  "  bool neg;\n"
+  "  uint64_t m;\n"
+  "  const char *e = parse_integer (json, t, &neg, &m);\n"
+  "\n"
+  "  if (e != NULL)\n"
+  "    return e;\n"
+  "\n"
+  "  if (m > (uint64_t)max + (neg ? 1 : 0))\n"
+  "    return \"number out of range\";\n"
+  "\n"
+  "  *r = !neg ? (int64_t)m : m == 0 ? 0 : -(int64_t)(m - 1) - 1;\n"
+  "  return NULL;\n"
+  "}\n";
+
+static const char unsigned_function[] =
+  "\n"
+  "static const char *\n"
+  "read_unsigned (pdjson_stream *json,\n"
+  "               enum pdjson_type t,\n"
+  "               uint64_t max,\n"
+  "               uint64_t *r)\n"
+  "{\n"
+  "  bool neg;\n"
+  "  uint64_t m;\n"
+  "  const char *e = parse_integer (json, t, &neg, &m);\n"
+  "\n"
+  "  if (e != NULL)\n"
+  "    return e;\n"
+  "\n"
+  "  if (m > max || (neg && m != 0))\n"
+  "    return \"number out of range\";\n"
+  "\n"
+  "  *r = m;\n"
+  "  return NULL;\n"
+  "}\n";
+
+static const char bool_function[] =
+  "\n"
+  "static const char *\n"
+  "read_bool (pdjson_stream *json, enum pdjson_type t, bool *r)\n"
+  "{\n"
+  "  if (t != PDJSON_TRUE && t != PDJSON_FALSE)\n"
+  "    return mismatch (json, t, \"expected boolean\");\n"
+  "\n"
+  "  *r = t == PDJSON_TRUE;\n"
+  "  return NULL;\n"
+  "}\n";
+
+// Note that strtod() handles the JSON5 Infinity, NaN, hexadecimal, and
+// leading/trailing decimal point forms.
+//
+static const char double_function[] =
+  "\n"
+  "static const char *\n"
+  "read_double (pdjson_stream *json, enum pdjson_type t, double *r)\n"
+  "{\n"
+  "  if (t != PDJSON_NUMBER)\n"
+  "    return mismatch (json, t, \"expected number\");\n"
+  "\n"
+  "  size_t n;\n"
+  "  const char *s = pdjson_get_value (json, &n);\n"
+  "\n"
+  "  // Note that strtod() expects the decimal point of the current\n"
+  "  // locale. So if it is not '.', convert a copy of the value with it\n"
+  "  // replaced.\n"
+  "  //\n"
+  "  const char *v = s;\n"
+  "  const char *p = localeconv ()->decimal_point;\n"
+  "  const char *dp;\n"
+  "  char buf[64];\n"
+  "\n"
+  "  if ((p[0] != '.' || p[1] != '\\0') && (dp = strchr (s, '.')) != NULL)\n"
+  "  {\n"
+  "    size_t pn = strlen (p);\n"
+  "    size_t dn = (size_t)(dp - s);\n"
+  "    size_t bn = n - 1 + pn;\n"
+  "\n"
+  "    char *b = bn <= sizeof (buf) ? buf : (char *)malloc (bn);\n"
+  "    if (b == NULL)\n"
+  "      return \"out of memory\";\n"
+  "\n"
+  "    memcpy (b, s, dn);\n"
+  "    memcpy (b + dn, p, pn);\n"
+  "    memcpy (b + dn + pn, dp + 1, n - dn - 1);\n"
+  "\n"
+  "    v = b;\n"
+  "    n = bn;\n"
+  "  }\n"
+  "\n"
+  "  char *e;\n"
+  "  double d = strtod (v, &e);\n"
+  "  bool ok = e == v + n - 1;\n"
+  "\n"
+  "  if (v != s && v != buf)\n"
+  "    free ((char *)v);\n"
+  "\n"
+  "  if (!ok)\n"
+  "    return \"invalid number\";\n"
+  "\n"
+  "  if ((d == HUGE_VAL || d == -HUGE_VAL) &&\n"
+  "      (s[0] == '-' || s[0] == '+' ? s[1] : s[0]) != 'I')\n"
+  "    return \"number out of range\";\n"
+  "\n"
+  "  *r = d;\n"
+  "  return NULL;\n"
+  "}\n";
+
+static const char string_function[] =
+  "\n"
+  "static const char *\n"
+  "read_string (pdjson_stream *json, enum pdjson_type t, char **r)\n"
+  "{\n"
+  "  if (t != PDJSON_STRING)\n"
+  "    return mismatch (json, t, \"expected string\");\n"
+  "\n"
+  "  size_t n;\n"
+  "  const char *s = pdjson_get_value (json, &n);\n"
+  "\n"
+  "  char *p = (char *)malloc (n);\n"
+  "  if (p == NULL)\n"
+  "    return \"out of memory\";\n"
+  "\n"
+  "  memcpy (p, s, n);\n"
+  "  free (*r); // Duplicate member.\n"
+  "  *r = p;\n"
+  "  return NULL;\n"
+  "}\n";
+
+static void
+generate_integer_reader (FILE *o, enum kind k)
+{
+  bool s = k == KIND_INT32 || k == KIND_INT64;
+  const char *b = s ? "int64_t" : "uint64_t";
+  const char *m = k == KIND_INT32  ? "INT32_MAX"  :
+                  k == KIND_INT64  ? "INT64_MAX"  :
+                  k == KIND_UINT32 ? "UINT32_MAX" : "UINT64_MAX";
+
+  fprintf (o,
+           "\n"
+           "static const char *\n"
+           "read_%s (pdjson_stream *json, enum pdjson_type t, %s *r)\n"
+           "{\n"
+           "  %s v;\n"
+           "  const char *e = read_%s (json, t, %s, &v);\n"
+           "\n"
+           "  if (e == NULL)\n"
+           "    *r = (%s)v;\n"
+           "\n"
+           "  return e;\n"
+           "}\n",
+           kind_names[k], kind_types[k],
+           b,
+           s ? "signed" : "unsigned", m,
+           kind_types[k]);
+}
+
+// Generate the array reader and free functions for the field value type.
+//
+static void
+generate_array_functions (FILE *o, const struct field *f)
+{
+  const char *n = value_name (f);
+
+  fprintf (o, "\nstatic void\nfree_%s_array (", n);
+  print_value_type (o, f);
+  fprintf (o, "*data, size_t size)\n{\n");
+
+  if (f->kind == KIND_STRING)
+    fprintf (o,
+             "  for (size_t i = 0; i != size; ++i)\n"
+             "    free (data[i]);\n"
+             "\n");
+  else if (f->kind == KIND_STRUCT)
+    fprintf (o,
+             "  for (size_t i = 0; i != size; ++i)\n"
+             "    %s_free (&data[i]);\n"
+             "\n",
+             n);
+  else
+    fprintf (o, "  (void)size;\n");
+
+  fprintf (o,
+           "  free (data);\n"
+           "}\n"
+           "\n"
+           "static const char *\n"
+           "read_%s_array (pdjson_stream *json,\n"
+           "%*senum pdjson_type t,\n"
+           "%*s",
+           n,
+           (int)(strlen ("read__array (") + strlen (n)), "",
+           (int)(strlen ("read__array (") + strlen (n)), "");
+  print_value_type (o, f);
+  fprintf (o,
+           "**data,\n"
+           "%*ssize_t *size)\n"
+           "{\n"
+           "  if (t != PDJSON_ARRAY)\n"
+           "    return mismatch (json, t, \"expected array\");\n"
+           "\n"
+           "  free_%s_array (*data, *size); // Duplicate member.\n"
+           "  *data = NULL;\n"
+           "  *size = 0;\n"
+           "\n"
+           "  for (size_t capacity = 0;;)\n"
+           "  {\n"
+           "    if ((t = pdjson_next (json)) == PDJSON_ARRAY_END)\n"
+           "      return NULL;\n"
+           "\n"
+           "    if (*size == capacity)\n"
+           "    {\n"
+           "      size_t c = capacity == 0 ? 8 : capacity * 2;\n"
+           "\n"
+           "      void *d = c <= SIZE_MAX / sizeof (**data)\n"
+           "        ? realloc (*data, c * sizeof (**data))\n"
+           "        : NULL;\n"
+           "\n"
+           "      if (d == NULL)\n"
+           "        return \"out of memory\";\n"
+           "\n"
+           "      *data = d;\n"
+           "      capacity = c;\n"
+           "    }\n"
+           "\n"
+           "    memset (*data + *size, 0, sizeof (**data));\n"
+           "\n"
+           "    const char *e = read_%s (json, t, *data + (*size)++);\n"
+           "    if (e != NULL)\n"
+           "      return e;\n"
+           "  }\n"
+           "}\n",
+           (int)(strlen ("read__array (") + strlen (n)), "",
+           n,
+           n);
+}
+
+// Fields of the struct being generated sorted by the member name size and
+// then first byte.
+//
+static const struct field *sort_fields;
+
+static int
+compare_fields (const void *x, const void *y)
+{
+  const struct field *a = sort_fields + *(const size_t *)x;
+  const struct field *b = sort_fields + *(const size_t *)y;
+
+  if (a->size != b->size)
+    return a->size < b->size ? -1 : 1;
+
+  unsigned char ac = (unsigned char)a->name[0];
+  unsigned char bc = (unsigned char)b->name[0];
+
+  if (ac != bc)
+    return ac < bc ? -1 : 1;
+
+  return 0;
+}
+
+static void
+generate_field_read (FILE *o, const struct field *f, const char *indent)
+{
+  if (f->array)
+    fprintf (o,
+             "%se = read_%s_array (json,\n"
+             "%s%*spdjson_next (json),\n"
+             "%s%*s&v->%s.data,\n"
+             "%s%*s&v->%s.size);\n",
+             indent, value_name (f),
+             indent, (int)(strlen ("e = read__array (") +
+                           strlen (value_name (f))), "",
+             indent, (int)(strlen ("e = read__array (") +
+                           strlen (value_name (f))), "", f->id,
+             indent, (int)(strlen ("e = read__array (") +
+                           strlen (value_name (f))), "", f->id);
+  else
+    fprintf (o,
+             "%se = read_%s (json, pdjson_next (json), &v->%s);\n",
+             indent, value_name (f), f->id);
+}
+
+static void
+generate_struct (FILE *o, const struct type *s)
+{
+  // Reader.
+  //
+  fprintf (o,
+           "\n"
+           "static const char *\n"
+           "read_%s (pdjson_stream *json, enum pdjson_type t, struct %s *v)\n"
+           "{\n"
+           "  if (t != PDJSON_OBJECT)\n"
+           "    return mismatch (json, t, \"expected object\");\n"
+           "\n"
+           "  while ((t = pdjson_next (json)) != PDJSON_OBJECT_END)\n"
+           "  {\n"
+           "    if (t == PDJSON_ERROR)\n"
+           "      return pdjson_get_error (json);\n"
+           "\n"
+           "    size_t n;\n"
+           "    const char *s = pdjson_get_name (json, &n);\n"
+           "    const char *e = unknown;\n"
+           "\n"
+           "    // Dispatch on the name size and then first byte.\n"
+           "    //\n"
+           "    switch (n - 1)\n"
+           "    {\n",
+           s->name, s->name);
+
+  size_t *fs = (size_t *)xrealloc (NULL, s->fields_size * sizeof (size_t));
+  for (size_t i = 0; i != s->fields_size; ++i)
+    fs[i] = i;
+
+  sort_fields = s->fields;
+  qsort (fs, s->fields_size, sizeof (size_t), &compare_fields);
+
+  for (size_t i = 0; i != s->fields_size; )
+  {
+    const struct field *f = s->fields + fs[i];
+    size_t size = f->size;
+
+    fprintf (o,
+             "    case %zu:\n"
+             "      switch (s[0])\n"
+             "      {\n",
+             size);
+
+    for (; i != s->fields_size && (f = s->fields + fs[i])->size == size; )
+    {
+      char c = f->name[0];
+
+      fprintf (o, "      case ");
+      print_char (o, c);
+      fprintf (o, ":\n");
+
+      // Fields with the same size and first byte are distinguished by
+      // comparing the rest of the name.
+      //
+      for (bool first = true;
+           i != s->fields_size &&
+             (f = s->fields + fs[i])->size == size &&
+             f->name[0] == c;
+           ++i, first = false)
+      {
+        if (size == 1)
+          generate_field_read (o, f, "        ");
+        else
+        {
+          fprintf (o,
+                   "        %sif (memcmp (s + 1, \"",
+                   first ? "" : "else ");
+          print_literal (o, f->name + 1, size - 1);
+          fprintf (o, "\", %zu) == 0)\n", size - 1);
+          generate_field_read (o, f, "          ");
+        }
+      }
+
+      fprintf (o, "        break;\n");
+    }
+
+    fprintf (o,
+             "      }\n"
+             "      break;\n");
+  }
+
+  free (fs);
+
+  fprintf (o,
+           "    }\n"
+           "\n"
+           "    if (e == unknown)\n"
+           "    {\n"
+           "      if (pdjson_skip (json) == PDJSON_ERROR)\n"
+           "        return pdjson_get_error (json);\n"
+           "    }\n"
+           "    else if (e != NULL)\n"
+           "      return e;\n"
+           "  }\n"
+           "\n"
+           "  return NULL;\n"
+           "}\n");
+
+  // Parse function.
+  //
+  fprintf (o,
+           "\n"
+           "const char *\n"
+           "%s_parse (pdjson_stream *json, struct %s *v)\n"
+           "{\n"
+           "  memset (v, 0, sizeof (*v));\n"
+           "  return read_%s (json, pdjson_next (json), v);\n"
+           "}\n",
+           s->name, s->name, s->name);
+
+  // Free function.
+  //
+  fprintf (o,
+           "\n"
+           "void\n"
+           "%s_free (struct %s *v)\n"
+           "{\n",
+           s->name, s->name);
+
+  bool empty = true;
+  for (size_t i = 0; i != s->fields_size; ++i)
+  {
+    const struct field *f = s->fields + i;
+
+    if (f->array)
+      fprintf (o,
+               "  free_%s_array (v->%s.data, v->%s.size);\n",
+               value_name (f), f->id, f->id);
+    else if (f->kind == KIND_STRING)
+      fprintf (o, "  free (v->%s);\n", f->id);
+    else if (f->kind == KIND_STRUCT)
+      fprintf (o, "  %s_free (&v->%s);\n", types[f->ref].name, f->id);
+    else
+      continue;
+
+    empty = false;
+  }
+
+  if (empty)
+    fprintf (o, "  (void)v;\n");
+
+  fprintf (o, "}\n");
+}
+
+static void
+generate_source (FILE *o, const char *header)
+{
+  fprintf (o,
+           "// Generated by pdjson5-gen from %s. Do not edit.\n"
+           "//\n"
+           "\n"
+           "#include \"%s\"\n"
+           "\n"
+           "#include <math.h>   // HUGE_VAL\n"
+           "#include <locale.h> // localeconv()\n"
+           "#include <stdlib.h> // malloc(), realloc(), free(), strtod()\n"
+           "#include <string.h> // str*(), mem*()\n"
+           "#include <stdint.h>\n"
+           "#include <stdbool.h>\n"
+           "\n",
+           schema_path,
+           header);
+
+  fputs (mismatch_function, o);
+
+  bool si = used[KIND_INT32] || used[KIND_INT64];
+  bool ui = used[KIND_UINT32] || used[KIND_UINT64];
+
+  if (si || ui)
+    fputs (integer_function, o);
+
+  if (si)
+    fputs (signed_function, o);
+
+  if (ui)
+    fputs (unsigned_function, o);
+
+  for (size_t k = 0; k != KIND_COUNT; ++k)
+  {
+    if (!used[k])
+      continue;
+
+    switch (k)
+    {
+    case KIND_BOOL:   fputs (bool_function, o);   break;
+    case KIND_DOUBLE: fputs (double_function, o); break;
+    case KIND_STRING: fputs (string_function, o); break;
+    default:          generate_integer_reader (o, (enum kind)k); break;
+    }
+
+    if (used_array[k])
+    {
+      struct field f;
+      f.kind = (enum kind)k;
+      f.ref = 0;
+      generate_array_functions (o, &f);
+    }
+  }
+
+  for (size_t i = 0; i != types_size; ++i)
+  {
+    generate_struct (o, types + i);
+
+    if (used_struct_array[i])
+    {
+      struct field f;
+      f.kind = KIND_STRUCT;
+      f.ref = i;
+      generate_array_functions (o, &f);
+    }
+  }
+}
+
+static void
+free_types (void)
+{
+  for (size_t i = 0; i != types_size; ++i)
+  {
+    struct type *s = types + i;
+
+    for (size_t j = 0; j != s->fields_size; ++j)
+    {
+      free (s->fields[j].name);
+      free (s->fields[j].id);
+    }
+
+    free (s->fields);
+    free (s->name);
+  }
+
+  free (types);
+  free (used_struct_array);
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 3)
+  {
+    fprintf (stderr, "usage: %s <schema> <output>\n", argv[0]);
+    return 1;
+  }
+
+  schema_path = argv[1];
+  const char *output = argv[2];
+
+  FILE *f = fopen (schema_path, "rb");
+  if (f == NULL)
+  {
+    fprintf (stderr, "error: unable to open '%s'\n", schema_path);
+    return 1;
+  }
+
+  pdjson_stream json[1];
+  pdjson_open_stream (json, f);
+  pdjson_set_language (json, PDJSON_LANGUAGE_JSON5E);
+
+  bool r = parse_schema (json);
+
+  pdjson_close (json);
+  fclose (f);
+
+  if (!r)
+  {
+    free_types ();
+    return 1;
+  }
+
+  // Determine the used types.
+  //
+  used_struct_array = (bool *)xrealloc (NULL, types_size * sizeof (bool) + 1);
+  memset (used_struct_array, 0, types_size * sizeof (bool) + 1);
+
+  for (size_t i = 0; i != types_size; ++i)
+  {
+    for (size_t j = 0; j != types[i].fields_size; ++j)
+    {
+      const struct field *fd = types[i].fields + j;
+
+      if (fd->kind == KIND_STRUCT)
+      {
+        if (fd->array)
+          used_struct_array[fd->ref] = true;
+      }
+      else
+      {
+        used[fd->kind] = true;
+
+        if (fd->array)
+          used_array[fd->kind] = true;
+      }
+    }
+  }
+
+  // Derive the header name (for the include directive) and the include
+  // guard from the output path.
+  //
+  const char *base = output;
+  for (const char *p = output; *p != '\0'; ++p)
+  {
+    if (*p == '/' || *p == '\\')
+      base = p + 1;
+  }
+
+  size_t n = strlen (output);
+  char *path = (char *)xrealloc (NULL, n + 3);
+  size_t bn = strlen (base);
+  char *header = (char *)xrealloc (NULL, bn + 3);
+  memcpy (header, base, bn);
+  memcpy (header + bn, ".h", 3);
+
+  char *guard = identifier (header, strlen (header));
+  for (char *p = guard; *p != '\0'; ++p)
+    *p = (char)toupper ((unsigned char)*p);
+
+  sprintf (path, "%s.h", output);
+  if ((f = fopen (path, "wb")) != NULL)
+  {
+    generate_header (f, guard);
+    r = fclose (f) == 0;
+  }
+  else
+    r = false;
+
+  if (r)
+  {
+    sprintf (path, "%s.c", output);
+    if ((f = fopen (path, "wb")) != NULL)
+    {
+      generate_source (f, header);
+      r = fclose (f) == 0;
+    }
+    else
+      r = false;
+  }
+
+  if (!r)
+    fprintf (stderr, "error: unable to write '%s'\n", path);
+
+  free (guard);
+  free (header);
+  free (path);
+  free_types ();
+
+  return r ? 0 : 1;
+}
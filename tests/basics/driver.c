@@ -3,6 +3,23 @@
 // --streaming      --  enable streaming mode
 // --separator      --  handle/print value separors in streaming mode
 // --io-error <pos> --  cause input stream error at or after position
+// --split          --  split top-level array and parse elements separately
+// --read-ahead <n> --  read input ahead in blocks of n bytes
+// --batch <n>      --  parse in batches of n events (no line/column output)
+// --callbacks      --  parse with event handler callbacks
+// --skip <name>    --  skip values of members with this name (callbacks)
+// --stop <name>    --  stop parsing at member with this name (callbacks)
+// --validate       --  only validate the input printing the error position
+// --recover        --  recover from syntax errors skipping to next newline
+//                      or, if framing is specified, end of frame
+// --framing <mode> --  streaming mode framing: rs, line, or length
+// --skip-frame <n> --  skip n'th frame (1-based) with pdjson_skip_frame()
+// --prefilter <p>  --  skip lines without pattern p in line framing mode
+//                      (can be specified multiple times)
+// --checkpoint     --  print checkpoint after each value in streaming mode
+// --names <n,...>  --  set member name dictionary and print name IDs
+// --intern <n>     --  intern up to n unknown member names
+// --resume <p,l,c> --  resume parsing at position p, line l, and column c
 // --json5          --  accept JSON5 input
 // --json5e         --  accept JSON5E input
 //
@@ -22,12 +39,372 @@
 #undef NDEBUG
 #include <assert.h>
 
+// Print the event in the <line>,<column>: <indentation><value> format.
+//
+static bool name_ids = false; // Print member name IDs.
+
+static void
+print_event (pdjson_stream *json, enum pdjson_type t, size_t *ind)
+{
+  printf ("%3" PRIu64 ",%3" PRIu64 ": ",
+          pdjson_get_line (json),
+          pdjson_get_column (json));
+
+  if (t == PDJSON_ARRAY_END || t == PDJSON_OBJECT_END)
+    (*ind)--;
+
+  for (size_t i = 0; i != *ind; ++i)
+    fputs ("  ", stdout);
+
+  if (t == PDJSON_ARRAY || t == PDJSON_OBJECT)
+    (*ind)++;
+
+  switch (t)
+  {
+  case PDJSON_NULL:
+    printf ("<null>\n");
+    break;
+  case PDJSON_TRUE:
+    printf ("<true>\n");
+    break;
+  case PDJSON_FALSE:
+    printf ("<false>\n");
+    break;
+  case PDJSON_NAME:
+    {
+      uint64_t n;
+      assert (pdjson_get_context (json, &n) == PDJSON_OBJECT && n % 2 != 0);
+    }
+    // Fall through.
+  case PDJSON_STRING:
+  case PDJSON_NUMBER:
+    {
+      size_t n;
+      const char* s = (t == PDJSON_NAME
+                       ? pdjson_get_name (json, &n)
+                       : pdjson_get_value (json, &n));
+      assert (strlen (s) + 1 == n);
+
+      // Print numbers and object member names without quoted.
+      //
+      printf (t == PDJSON_STRING ? "\"%s\"" : "%s", s);
+
+      // Print the member name ID if the dictionary is set.
+      //
+      if (t == PDJSON_NAME && name_ids)
+      {
+        size_t id = pdjson_get_name_id (json);
+
+        if (id != PDJSON_NAME_UNKNOWN)
+        {
+          size_t in;
+          const char *is = pdjson_get_name_by_id (json, id, &in);
+          assert (is != NULL && in == n && memcmp (is, s, n) == 0);
+
+          printf (" #%zu", id);
+        }
+        else
+          printf (" #?");
+      }
+
+      printf ("\n");
+      break;
+    }
+  case PDJSON_ARRAY:
+    assert (pdjson_get_context (json, NULL) == PDJSON_ARRAY);
+    printf ("[\n");
+    break;
+  case PDJSON_ARRAY_END:
+    printf ("]\n");
+    break;
+  case PDJSON_OBJECT:
+    assert (pdjson_get_context (json, NULL) == PDJSON_OBJECT);
+    printf ("{\n");
+    break;
+  case PDJSON_OBJECT_END:
+    printf ("}\n");
+    break;
+  case PDJSON_ERROR:
+  case PDJSON_DONE:
+    assert (false);
+  }
+}
+
+static void
+print_error (pdjson_stream *json)
+{
+  const char *et;
+  switch (pdjson_get_error_subtype (json))
+  {
+  case PDJSON_ERROR_SYNTAX: et = "";         break;
+  case PDJSON_ERROR_MEMORY: et = " (memory)"; break;
+  case PDJSON_ERROR_IO:     et = " (io)";     break;
+  default: assert (false);
+  }
+
+  fprintf (stderr,
+           "<stdin>:%" PRIu64 ":%" PRIu64 ": error: %s%s\n",
+           pdjson_get_line (json),
+           pdjson_get_column (json),
+           pdjson_get_error (json),
+           et);
+}
+
+// Parse the input in batches of the specified number of events (see
+// --batch).
+//
+static int
+parse_batch (pdjson_stream *json, size_t n)
+{
+  pdjson_event *events = (pdjson_event *)malloc (n * sizeof (pdjson_event));
+  assert (events != NULL);
+
+  enum pdjson_type t = PDJSON_DONE;
+  for (size_t m; (m = pdjson_next_batch (json, events, n)) != 0; )
+  {
+    assert (m <= n);
+
+    const char *data = pdjson_get_batch_data (json);
+
+    for (size_t i = 0; i != m; ++i)
+    {
+      const pdjson_event *e = events + i;
+
+      if ((t = e->type) == PDJSON_DONE || t == PDJSON_ERROR)
+      {
+        assert (i + 1 == m && e->size == 0);
+        break;
+      }
+
+      // Note that the depth of the array/object start event already
+      // includes the new array/object.
+      //
+      size_t ind = e->depth;
+      if (t == PDJSON_ARRAY || t == PDJSON_OBJECT)
+        ind--;
+
+      for (size_t j = 0; j != ind; ++j)
+        fputs ("  ", stdout);
+
+      switch (t)
+      {
+      case PDJSON_NULL:       printf ("<null>\n");  break;
+      case PDJSON_TRUE:       printf ("<true>\n");  break;
+      case PDJSON_FALSE:      printf ("<false>\n"); break;
+      case PDJSON_ARRAY:      printf ("[\n");       break;
+      case PDJSON_ARRAY_END:  printf ("]\n");       break;
+      case PDJSON_OBJECT:     printf ("{\n");       break;
+      case PDJSON_OBJECT_END: printf ("}\n");       break;
+      case PDJSON_NAME:
+      case PDJSON_STRING:
+      case PDJSON_NUMBER:
+        {
+          const char *s = data + e->offset;
+          assert (strlen (s) + 1 == e->size);
+
+          printf (t == PDJSON_STRING ? "\"%s\"\n" : "%s\n", s);
+          break;
+        }
+      case PDJSON_ERROR:
+      case PDJSON_DONE:
+        assert (false);
+      }
+    }
+
+    if (t == PDJSON_DONE || t == PDJSON_ERROR)
+      break;
+  }
+
+  free (events);
+
+  if (t == PDJSON_ERROR)
+  {
+    print_error (json);
+    return 1;
+  }
+
+  return 0;
+}
+
+// Parsing with event handler callbacks (see --callbacks).
+//
+struct context
+{
+  pdjson_stream *json;
+  size_t ind;
+  const char *skip;
+  const char *stop;
+};
+
+static enum pdjson_handler_result
+on_event (struct context *c, enum pdjson_type t)
+{
+  print_event (c->json, t, &c->ind);
+  return PDJSON_HANDLER_CONTINUE;
+}
+
+static enum pdjson_handler_result
+on_object_begin (void *c) {return on_event (c, PDJSON_OBJECT);}
+
+static enum pdjson_handler_result
+on_object_end (void *c) {return on_event (c, PDJSON_OBJECT_END);}
+
+static enum pdjson_handler_result
+on_array_begin (void *c) {return on_event (c, PDJSON_ARRAY);}
+
+static enum pdjson_handler_result
+on_array_end (void *c) {return on_event (c, PDJSON_ARRAY_END);}
+
+static enum pdjson_handler_result
+on_name (const char *v, size_t n, void *p)
+{
+  struct context *c = (struct context *)p;
+  assert (strlen (v) + 1 == n);
+
+  if (c->stop != NULL && strcmp (v, c->stop) == 0)
+    return PDJSON_HANDLER_STOP;
+
+  on_event (c, PDJSON_NAME);
+
+  return (c->skip != NULL && strcmp (v, c->skip) == 0
+          ? PDJSON_HANDLER_SKIP
+          : PDJSON_HANDLER_CONTINUE);
+}
+
+static enum pdjson_handler_result
+on_string (const char *v, size_t n, void *c)
+{
+  assert (strlen (v) + 1 == n);
+  return on_event (c, PDJSON_STRING);
+}
+
+static enum pdjson_handler_result
+on_number (const char *v, size_t n, void *c)
+{
+  assert (strlen (v) + 1 == n);
+  return on_event (c, PDJSON_NUMBER);
+}
+
+static enum pdjson_handler_result
+on_literal (enum pdjson_type t, void *c)
+{
+  return on_event (c, t);
+}
+
+static int
+parse_callbacks (pdjson_stream *json, const char *skip, const char *stop)
+{
+  const pdjson_handler h = {
+    &on_object_begin, &on_object_end,
+    &on_array_begin, &on_array_end,
+    &on_name, &on_string, &on_number, &on_literal};
+
+  struct context c = {json, 0, skip, stop};
+
+  enum pdjson_type t = pdjson_parse_callbacks (json, &h, &c);
+
+  if (t == PDJSON_ERROR)
+  {
+    print_error (json);
+    return 1;
+  }
+
+  if (t != PDJSON_DONE)
+    printf ("<stopped>\n");
+
+  return 0;
+}
+
+// Split the top-level array read from stdin and parse each element with a
+// separate parser instance (see --split).
+//
+static int
+split_array (enum pdjson_language language)
+{
+  size_t size = 0, capacity = 4096;
+  char *buf = (char *)malloc (capacity);
+  assert (buf != NULL);
+
+  for (size_t n; (n = fread (buf + size, 1, capacity - size, stdin)) != 0; )
+  {
+    if ((size += n) == capacity)
+    {
+      buf = (char *)realloc (buf, capacity *= 2);
+      assert (buf != NULL);
+    }
+  }
+
+  pdjson_stream json[1], ejson[1];
+  pdjson_open_buffer (json, buf, size);
+  pdjson_set_language (json, language);
+
+  pdjson_open_null (ejson);
+  pdjson_set_language (ejson, language);
+
+  // Use a small number of spans to exercise resuming.
+  //
+  pdjson_span spans[2];
+
+  int r = 0;
+  for (size_t n; r == 0 && (n = pdjson_split_array (json, spans, 2)) != 0; )
+  {
+    for (size_t i = 0; i != n; ++i)
+    {
+      const pdjson_span *sp = spans + i;
+
+      pdjson_reopen_buffer (ejson, buf + sp->position, sp->size);
+      pdjson_set_location (ejson, sp->position, sp->line, sp->column);
+
+      size_t ind = 1;
+      enum pdjson_type t;
+      while ((t = pdjson_next (ejson)) != PDJSON_DONE && t != PDJSON_ERROR)
+        print_event (ejson, t, &ind);
+
+      if (t == PDJSON_ERROR)
+      {
+        print_error (ejson);
+        r = 1;
+        break;
+      }
+    }
+  }
+
+  if (r == 0 && pdjson_next (json) == PDJSON_ERROR)
+  {
+    print_error (json);
+    r = 1;
+  }
+
+  pdjson_close (ejson);
+  pdjson_close (json);
+  free (buf);
+
+  return r;
+}
+
 int
 main (int argc, char *argv[])
 {
   bool streaming = false;
   bool separator = false;
+  bool split = false;
+  size_t batch = 0;
+  bool callbacks = false;
+  bool validate = false;
+  bool recover = false;
+  enum pdjson_framing framing = PDJSON_FRAMING_NONE;
+  uint64_t skip_frame = 0;
+  bool checkpoint = false;
+  const char *prefilter[8];
+  size_t prefilter_size = 0;
+  const char *names[8];
+  size_t names_size = 0;
+  size_t intern = 0;
+  const char *resume = NULL;
+  const char *skip = NULL;
+  const char *stop = NULL;
   uint64_t io_error = (uint64_t)-1;
+  size_t read_ahead = 0;
   enum pdjson_language language = PDJSON_LANGUAGE_JSON;
 
   for (int i = 1; i < argc; ++i)
@@ -38,6 +415,8 @@ main (int argc, char *argv[])
       streaming = true;
     else if (strcmp (a, "--separator") == 0)
       separator = true;
+    else if (strcmp (a, "--split") == 0)
+      split = true;
     else if (strcmp (a, "--io-error") == 0)
     {
       if (++i < argc)
@@ -51,6 +430,139 @@ main (int argc, char *argv[])
       fprintf (stderr, "error: missing or invalid --io-error argument\n");
       return 1;
     }
+    else if (strcmp (a, "--read-ahead") == 0)
+    {
+      if (++i < argc)
+      {
+        errno = 0;
+        read_ahead = (size_t)strtoull (argv[i], NULL, 10);
+        if (errno == 0 && read_ahead != 0)
+          continue;
+      }
+
+      fprintf (stderr, "error: missing or invalid --read-ahead argument\n");
+      return 1;
+    }
+    else if (strcmp (a, "--batch") == 0)
+    {
+      if (++i < argc)
+      {
+        errno = 0;
+        batch = (size_t)strtoull (argv[i], NULL, 10);
+        if (errno == 0 && batch != 0)
+          continue;
+      }
+
+      fprintf (stderr, "error: missing or invalid --batch argument\n");
+      return 1;
+    }
+    else if (strcmp (a, "--callbacks") == 0)
+      callbacks = true;
+    else if (strcmp (a, "--validate") == 0)
+      validate = true;
+    else if (strcmp (a, "--recover") == 0)
+      recover = true;
+    else if (strcmp (a, "--framing") == 0)
+    {
+      const char *v = ++i < argc ? argv[i] : "";
+
+      if      (strcmp (v, "rs") == 0)     framing = PDJSON_FRAMING_RS;
+      else if (strcmp (v, "line") == 0)   framing = PDJSON_FRAMING_LINE;
+      else if (strcmp (v, "length") == 0) framing = PDJSON_FRAMING_LENGTH;
+      else
+      {
+        fprintf (stderr, "error: missing or invalid --framing argument\n");
+        return 1;
+      }
+    }
+    else if (strcmp (a, "--skip-frame") == 0)
+    {
+      if (++i < argc)
+      {
+        errno = 0;
+        skip_frame = strtoull (argv[i], NULL, 10);
+        if (errno == 0 && skip_frame != 0)
+          continue;
+      }
+
+      fprintf (stderr, "error: missing or invalid --skip-frame argument\n");
+      return 1;
+    }
+    else if (strcmp (a, "--prefilter") == 0)
+    {
+      if (++i < argc && prefilter_size != 8)
+      {
+        prefilter[prefilter_size++] = argv[i];
+        continue;
+      }
+
+      fprintf (stderr, "error: missing or too many --prefilter arguments\n");
+      return 1;
+    }
+    else if (strcmp (a, "--names") == 0)
+    {
+      if (++i < argc)
+      {
+        // Split the comma-separated list in place.
+        //
+        for (char *p = argv[i]; names_size != 8; )
+        {
+          names[names_size++] = p;
+
+          if ((p = strchr (p, ',')) == NULL)
+            break;
+
+          *p++ = '\0';
+        }
+
+        name_ids = true;
+        continue;
+      }
+
+      fprintf (stderr, "error: missing --names argument\n");
+      return 1;
+    }
+    else if (strcmp (a, "--intern") == 0)
+    {
+      if (++i < argc)
+      {
+        errno = 0;
+        intern = (size_t)strtoull (argv[i], NULL, 10);
+        if (errno == 0)
+        {
+          name_ids = true;
+          continue;
+        }
+      }
+
+      fprintf (stderr, "error: missing or invalid --intern argument\n");
+      return 1;
+    }
+    else if (strcmp (a, "--checkpoint") == 0)
+      checkpoint = true;
+    else if (strcmp (a, "--resume") == 0)
+    {
+      if (++i < argc)
+      {
+        resume = argv[i];
+        continue;
+      }
+
+      fprintf (stderr, "error: missing --resume argument\n");
+      return 1;
+    }
+    else if (strcmp (a, "--skip") == 0 || strcmp (a, "--stop") == 0)
+    {
+      if (++i < argc)
+      {
+        *(a[3] == 'k' ? &skip : &stop) = argv[i];
+        callbacks = true;
+        continue;
+      }
+
+      fprintf (stderr, "error: missing %s argument\n", a);
+      return 1;
+    }
     else if (strcmp (a, "--json5") == 0)
       language = PDJSON_LANGUAGE_JSON5;
     else if (strcmp (a, "--json5e") == 0)
@@ -68,16 +580,134 @@ main (int argc, char *argv[])
     return 1;
   }
 
+  if (prefilter_size != 0 && framing != PDJSON_FRAMING_LINE)
+  {
+    fprintf (stderr, "error: --prefilter specified without --framing line\n");
+    return 1;
+  }
+
+  if (split)
+  {
+    if (streaming || io_error != (uint64_t)-1)
+    {
+      fprintf (stderr,
+               "error: --split specified with --streaming or --io-error\n");
+      return 1;
+    }
+
+    return split_array (language);
+  }
+
   pdjson_stream json[1];
   pdjson_open_stream (json, stdin);
+  pdjson_set_read_ahead (json, read_ahead);
   pdjson_set_streaming (json, streaming);
   pdjson_set_language (json, language);
+  pdjson_set_framing (json, framing);
+  pdjson_set_prefilter (json, prefilter, prefilter_size);
+
+  if (name_ids)
+    pdjson_set_names (json, names, names_size, intern);
+
+  // The resume argument is the checkpoint position, line, and column with
+  // the language and framing taken from the options.
+  //
+  if (resume != NULL)
+  {
+    struct pdjson_checkpoint cp;
+    cp.language = (uint32_t)language;
+    cp.framing = (uint32_t)framing;
+
+    if (sscanf (resume,
+                "%" SCNu64 ",%" SCNu64 ",%" SCNu64,
+                &cp.position, &cp.line, &cp.column) != 3 ||
+        !pdjson_resume (json, &cp))
+    {
+      fprintf (stderr, "error: invalid --resume argument\n");
+      pdjson_close (json);
+      return 1;
+    }
+
+    streaming = true;
+  }
+
+  if (framing != PDJSON_FRAMING_NONE)
+    streaming = true;
+
+  if (batch != 0)
+  {
+    if (streaming || io_error != (uint64_t)-1)
+    {
+      fprintf (stderr,
+               "error: --batch specified with --streaming or --io-error\n");
+      return 1;
+    }
+
+    int r = parse_batch (json, batch);
+    pdjson_close (json);
+    return r;
+  }
+
+  if (callbacks)
+  {
+    if (streaming || io_error != (uint64_t)-1)
+    {
+      fprintf (stderr,
+               "error: --callbacks specified with --streaming/--io-error\n");
+      return 1;
+    }
+
+    int r = parse_callbacks (json, skip, stop);
+    pdjson_close (json);
+    return r;
+  }
+
+  if (validate)
+  {
+    if (io_error != (uint64_t)-1)
+    {
+      fprintf (stderr, "error: --validate specified with --io-error\n");
+      return 1;
+    }
+
+    uint64_t p;
+    int r = 0;
+    if (pdjson_validate (json, &p))
+      printf ("<valid>\n");
+    else
+    {
+      printf ("<invalid at %" PRIu64 ">\n", p);
+      print_error (json);
+      r = 1;
+    }
+
+    pdjson_close (json);
+    return r;
+  }
 
   size_t ind = 0; // Indentation.
+  bool failed = false;
+  uint64_t frame = 0; // Number of values/frames started.
 
   enum pdjson_type t;
   for (bool first = true;;)
   {
+    if (first && ++frame == skip_frame)
+    {
+      int r = pdjson_skip_frame (json);
+
+      if (r == -1)
+      {
+        t = PDJSON_ERROR;
+        break;
+      }
+
+      if (r == 1)
+        printf ("%3" PRIu64 ",%3" PRIu64 ": <skipped>\n",
+                pdjson_get_line (json),
+                pdjson_get_column (json));
+    }
+
     if (io_error != (uint64_t)-1)
     {
       uint64_t p = pdjson_get_position (json);
@@ -100,10 +730,45 @@ main (int argc, char *argv[])
     t = pdjson_next (json);
 
     if (t == PDJSON_ERROR)
+    {
+      if (recover && pdjson_get_error_subtype (json) == PDJSON_ERROR_SYNTAX)
+      {
+        print_error (json);
+        failed = true;
+
+        if (!pdjson_recover (json,
+                             (framing != PDJSON_FRAMING_NONE
+                              ? PDJSON_RECOVER_FRAME
+                              : PDJSON_RECOVER_NEWLINE)))
+          break;
+
+        printf ("%3" PRIu64 ",%3" PRIu64 ": <recovered>\n",
+                pdjson_get_line (json),
+                pdjson_get_column (json));
+
+        ind = 0;
+        first = true;
+        continue;
+      }
+
       break;
+    }
 
     if (t == PDJSON_DONE)
     {
+      if (checkpoint)
+      {
+        struct pdjson_checkpoint cp;
+        if (pdjson_checkpoint (json, &cp))
+          printf ("%3" PRIu64 ",%3" PRIu64 ": <checkpoint %" PRIu64 ",%"
+                  PRIu64 ",%" PRIu64 ">\n",
+                  pdjson_get_line (json),
+                  pdjson_get_column (json),
+                  cp.position, cp.line, cp.column);
+        else
+          printf ("<no checkpoint>\n");
+      }
+
       // Second PDJSON_DONE in the streamig mode is the end of multi-value.
       //
       if (!streaming || first)
@@ -141,88 +806,13 @@ main (int argc, char *argv[])
     if (first)
       first = false;
 
-    printf ("%3" PRIu64 ",%3" PRIu64 ": ",
-            pdjson_get_line (json),
-            pdjson_get_column (json));
-
-    if (t == PDJSON_ARRAY_END || t == PDJSON_OBJECT_END)
-      ind--;
-
-    for (size_t i = 0; i != ind; ++i)
-      fputs ("  ", stdout);
-
-    if (t == PDJSON_ARRAY || t == PDJSON_OBJECT)
-      ind++;
-
-    switch (t)
-    {
-    case PDJSON_NULL:
-      printf ("<null>\n");
-      break;
-    case PDJSON_TRUE:
-      printf ("<true>\n");
-      break;
-    case PDJSON_FALSE:
-      printf ("<false>\n");
-      break;
-    case PDJSON_NAME:
-      {
-        uint64_t n;
-        assert (pdjson_get_context (json, &n) == PDJSON_OBJECT && n % 2 != 0);
-      }
-      // Fall through.
-    case PDJSON_STRING:
-    case PDJSON_NUMBER:
-      {
-        size_t n;
-        const char* s = (t == PDJSON_NAME
-                         ? pdjson_get_name (json, &n)
-                         : pdjson_get_value (json, &n));
-        assert (strlen (s) + 1 == n);
-
-        // Print numbers and object member names without quoted.
-        //
-        printf (t == PDJSON_STRING ? "\"%s\"\n" : "%s\n", s);
-        break;
-      }
-    case PDJSON_ARRAY:
-      assert (pdjson_get_context (json, NULL) == PDJSON_ARRAY);
-      printf ("[\n");
-      break;
-    case PDJSON_ARRAY_END:
-      printf ("]\n");
-      break;
-    case PDJSON_OBJECT:
-      assert (pdjson_get_context (json, NULL) == PDJSON_OBJECT);
-      printf ("{\n");
-      break;
-    case PDJSON_OBJECT_END:
-      printf ("}\n");
-      break;
-    case PDJSON_ERROR:
-    case PDJSON_DONE:
-      assert (false);
-    }
+    print_event (json, t, &ind);
   }
 
-  int r = 0;
+  int r = failed ? 1 : 0;
   if (t == PDJSON_ERROR)
   {
-    const char *et;
-    switch (pdjson_get_error_subtype (json))
-    {
-    case PDJSON_ERROR_SYNTAX: et = "";         break;
-    case PDJSON_ERROR_MEMORY: et = " (memory)"; break;
-    case PDJSON_ERROR_IO:     et = " (io)";     break;
-    default: assert (false);
-    }
-
-    fprintf (stderr,
-             "<stdin>:%" PRIu64 ":%" PRIu64 ": error: %s%s\n",
-             pdjson_get_line (json),
-             pdjson_get_column (json),
-             pdjson_get_error (json),
-             et);
+    print_error (json);
     r = 1;
   }
 
@@ -0,0 +1,150 @@
+// Usage: driver
+//
+// Read the stdin values (in the streaming mode) into the person struct and
+// print them.
+//
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <iterator> // istreambuf_iterator
+#include <optional>
+
+#include <libpdjson5/pdjson5.hxx>
+#include <libpdjson5/pdjson5-bind.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+
+struct address
+{
+  string city;
+  optional<uint32_t> zip;
+};
+
+struct person
+{
+  string name;
+  uint16_t age = 0;
+  bool admin = false;
+  double score = 0;
+  vector<string> tags;
+  optional<address> home;
+  vector<address> history;
+  vector<vector<int>> matrix;
+};
+
+PDJSON5_FIELDS (address, city, zip)
+
+// Bind some fields to members with different names.
+//
+template <>
+struct pdjson5::fields<person>
+{
+  static constexpr auto value = std::make_tuple (
+    pdjson5::field ("name", &person::name),
+    pdjson5::field ("age", &person::age),
+    pdjson5::field ("admin", &person::admin),
+    pdjson5::field ("score", &person::score),
+    pdjson5::field ("tags", &person::tags),
+    pdjson5::field ("home-address", &person::home),
+    pdjson5::field ("history", &person::history),
+    pdjson5::field ("matrix", &person::matrix));
+};
+
+// Test the dispatch at compile time.
+//
+static_assert (pdjson5::field_index<person> ("name") == 0);
+static_assert (pdjson5::field_index<person> ("home-address") == 5);
+static_assert (pdjson5::field_index<person> ("matrix") == 7);
+static_assert (pdjson5::field_index<person> ("home") == size_t (-1));
+static_assert (pdjson5::field_index<address> ("zip") == 1);
+static_assert (pdjson5::field_index<address> ("") == size_t (-1));
+
+static void
+print (const address& a)
+{
+  cout << a.city;
+
+  if (a.zip)
+    cout << ' ' << *a.zip;
+}
+
+static void
+print (const person& p)
+{
+  cout << "name: '" << p.name << "'" << endl
+       << "age: " << p.age << endl
+       << "admin: " << (p.admin ? "true" : "false") << endl
+       << "score: " << p.score << endl;
+
+  cout << "tags:";
+  for (const string& t: p.tags)
+    cout << ' ' << t;
+  cout << endl;
+
+  if (p.home)
+  {
+    cout << "home: ";
+    print (*p.home);
+    cout << endl;
+  }
+
+  for (const address& a: p.history)
+  {
+    cout << "history: ";
+    print (a);
+    cout << endl;
+  }
+
+  for (const vector<int>& r: p.matrix)
+  {
+    cout << "matrix:";
+    for (int v: r)
+      cout << ' ' << v;
+    cout << endl;
+  }
+}
+
+int
+main ()
+{
+  string in ((istreambuf_iterator<char> (cin)), istreambuf_iterator<char> ());
+
+  pdjson5::parser p (in);
+  p.set_streaming (true);
+
+  try
+  {
+    for (bool first (true); p.peek () != pdjson5::event::done; first = false)
+    {
+      person x (pdjson5::read<person> (p));
+
+      pdjson5::event e (p.next ());
+      assert (e == pdjson5::event::done);
+      p.reset ();
+
+      if (!first)
+        cout << endl;
+
+      print (x);
+    }
+  }
+  catch (const pdjson5::error& e)
+  {
+    cerr << "<stdin>:" << e.line << ":" << e.column << ": error: "
+         << e.what () << endl;
+    return 1;
+  }
+  catch (const pdjson5::bind_error& e)
+  {
+    cerr << "<stdin>:" << e.line << ":" << e.column << ": error: "
+         << e.what () << endl;
+    return 1;
+  }
+
+  return 0;
+}
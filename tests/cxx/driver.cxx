@@ -0,0 +1,338 @@
+// Usage: driver [<options>]
+//
+// Parse stdin with the C++ layer and print each value back in the compact
+// form on its own line.
+//
+// --streaming      --  enable streaming mode
+// --skip <name>    --  skip values of members with this name unread
+// --first <name>   --  only read first event of values of members with this
+//                      name leaving the rest unread
+// --peek           --  peek at each member value and into each object and
+//                      array element before reading
+// --numbers        --  print numbers converted to int64_t or, if that fails,
+//                      double
+// --events         --  print event names instead of values (using the
+//                      events() generator if available)
+// --resource       --  allocate parser memory with a memory resource
+// --json5          --  accept JSON5 input
+// --json5e         --  accept JSON5E input
+//
+
+#include <cstdio>
+#include <string>
+#include <cstdint>
+#include <cstring>   // strcmp()
+#include <iostream>
+#include <iterator>  // istreambuf_iterator
+#include <stdexcept>
+#include <string_view>
+#include <memory_resource>
+
+#include <libpdjson5/pdjson5.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+using namespace pdjson5;
+
+static const char* skip_name = nullptr;
+static const char* first_name = nullptr;
+static bool peek = false;
+static bool convert = false;
+
+// Memory resource that counts outstanding allocations.
+//
+class counting_resource: public pmr::memory_resource
+{
+public:
+  size_t total = 0;
+  size_t outstanding = 0;
+
+private:
+  void*
+  do_allocate (size_t n, size_t a) override
+  {
+    ++total;
+    ++outstanding;
+    return pmr::new_delete_resource ()->allocate (n, a);
+  }
+
+  void
+  do_deallocate (void* p, size_t n, size_t a) override
+  {
+    --outstanding;
+    pmr::new_delete_resource ()->deallocate (p, n, a);
+  }
+
+  bool
+  do_is_equal (const pmr::memory_resource& r) const noexcept override
+  {
+    return this == &r;
+  }
+};
+
+static void
+print_string (string_view s)
+{
+  cout << '"';
+  for (char c: s)
+  {
+    switch (c)
+    {
+    case '"':  cout << "\\\""; break;
+    case '\\': cout << "\\\\"; break;
+    case '\n': cout << "\\n";  break;
+    default:   cout << c;      break;
+    }
+  }
+  cout << '"';
+}
+
+static void
+print_number (parser& p)
+{
+  if (convert)
+  {
+    try
+    {
+      cout << p.number<int64_t> ();
+      return;
+    }
+    catch (const exception&) {}
+
+    try
+    {
+      char b[32];
+      snprintf (b, sizeof (b), "%g", p.number<double> ());
+      cout << b;
+      return;
+    }
+    catch (const exception& e)
+    {
+      cout << '<' << e.what () << '>';
+      return;
+    }
+  }
+
+  cout << p.value ();
+}
+
+// Print the value that starts with the event that has just been read.
+//
+static void
+print_value (parser& p, event e)
+{
+  switch (e)
+  {
+  case event::object:
+    {
+      cout << '{';
+
+      bool f (true);
+      for (string_view n: p.members ())
+      {
+        if (!f)
+          cout << ',';
+
+        f = false;
+
+        print_string (n);
+        cout << ':';
+
+        if (skip_name != nullptr && n == skip_name)
+        {
+          cout << "<skipped>";
+          continue;
+        }
+
+        // Note that the name is no longer valid after reading the value.
+        //
+        bool first (first_name != nullptr && n == first_name);
+
+        if (peek)
+          p.peek ();
+
+        e = p.next ();
+
+        if (first)
+        {
+          cout << (e == event::object ? "{...}" :
+                   e == event::array  ? "[...]" : "<first>");
+          continue;
+        }
+
+        print_value (p, e);
+      }
+
+      cout << '}';
+      break;
+    }
+  case event::array:
+    {
+      cout << '[';
+
+      bool f (true);
+      for (event e: p.elements ())
+      {
+        if (!f)
+          cout << ',';
+
+        f = false;
+
+        // Note that peeking at a scalar value would invalidate it.
+        //
+        if (peek && (e == event::object || e == event::array))
+          p.peek ();
+
+        print_value (p, e);
+      }
+
+      cout << ']';
+      break;
+    }
+  case event::string: print_string (p.value ()); break;
+  case event::number: print_number (p);          break;
+  case event::true_:  cout << "true";            break;
+  case event::false_: cout << "false";           break;
+  case event::null:   cout << "null";            break;
+  default:            assert (false);
+  }
+}
+
+static const char*
+event_name (event e)
+{
+  switch (e)
+  {
+  case event::done:       return "done";
+  case event::object:     return "object";
+  case event::object_end: return "object_end";
+  case event::array:      return "array";
+  case event::array_end:  return "array_end";
+  case event::name:       return "name";
+  case event::string:     return "string";
+  case event::number:     return "number";
+  case event::true_:      return "true";
+  case event::false_:     return "false";
+  case event::null:       return "null";
+  }
+
+  return nullptr;
+}
+
+int
+main (int argc, char* argv[])
+{
+  bool streaming (false);
+  bool events (false);
+  bool resource (false);
+  language lang (language::json);
+
+  for (int i (1); i < argc; ++i)
+  {
+    const char* a (argv[i]);
+
+    if (strcmp (a, "--streaming") == 0)
+      streaming = true;
+    else if (strcmp (a, "--skip") == 0 && i + 1 < argc)
+      skip_name = argv[++i];
+    else if (strcmp (a, "--first") == 0 && i + 1 < argc)
+      first_name = argv[++i];
+    else if (strcmp (a, "--peek") == 0)
+      peek = true;
+    else if (strcmp (a, "--numbers") == 0)
+      convert = true;
+    else if (strcmp (a, "--events") == 0)
+      events = true;
+    else if (strcmp (a, "--resource") == 0)
+      resource = true;
+    else if (strcmp (a, "--json5") == 0)
+      lang = language::json5;
+    else if (strcmp (a, "--json5e") == 0)
+      lang = language::json5e;
+    else
+    {
+      cerr << "error: unexpected argument '" << a << "'" << endl;
+      return 1;
+    }
+  }
+
+  string in ((istreambuf_iterator<char> (cin)), istreambuf_iterator<char> ());
+
+  counting_resource mr;
+  int r (0);
+  {
+    parser p (in, resource ? &mr : nullptr);
+    p.set_streaming (streaming);
+    p.set_language (lang);
+
+    // Test moving the parser.
+    //
+    parser p1 (move (p));
+    p = move (p1);
+
+    try
+    {
+      for (;;)
+      {
+        bool f (true);
+
+        if (events)
+        {
+#ifdef LIBPDJSON5_COROUTINES
+          for (event e: p.events ())
+          {
+            cout << (f ? "" : " ") << event_name (e);
+            f = false;
+          }
+#else
+          for (event e; (e = p.next ()) != event::done; )
+          {
+            cout << (f ? "" : " ") << event_name (e);
+            f = false;
+          }
+#endif
+        }
+        else
+        {
+          event e (p.next ());
+
+          if (e != event::done)
+          {
+            print_value (p, e);
+            f = false;
+
+            e = p.next ();
+            assert (e == event::done);
+          }
+        }
+
+        // In the streaming mode the end of input is indicated by a value
+        // without any events.
+        //
+        if (f)
+          break;
+
+        cout << endl;
+
+        if (!streaming)
+          break;
+
+        p.reset ();
+      }
+    }
+    catch (const pdjson5::error& e)
+    {
+      cout << endl;
+      cerr << "<stdin>:" << e.line << ":" << e.column << ": error: "
+           << e.what () << endl;
+      r = 1;
+    }
+  }
+
+  if (resource)
+    assert (mr.total != 0 && mr.outstanding == 0);
+
+  return r;
+}
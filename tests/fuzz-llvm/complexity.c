@@ -0,0 +1,321 @@
+// LibFuzzer driver that looks for inputs that take superlinear time or
+// memory to parse.
+//
+// Each input is parsed in every language and streaming mode combination,
+// both event by event and by skipping values with pdjson_skip(). Then the
+// input is scaled SCALE times, by repeating it as a whole and by repeating
+// each of its bytes except for the delimiters (which lengthens the tokens,
+// whitespace runs, and nesting levels), and parsed again. For each cost
+// (the number of events, bytes added to the name/value buffer, slow path
+// input calls, depth of nesting, peak name/value buffer size and, if
+// available, user space instructions retired) the cost per input byte
+// consumed is compared between the original and scaled inputs and inputs
+// for which it grows more than SLACK times are reported as crashes. Note
+// that comparing per byte consumed rather than per input size accounts for
+// scaled inputs that fail to parse at a different point.
+//
+// Note that this driver includes the library source file in order to enable
+// the statistics (see pdjson_get_stats()). The scale and slack factors can
+// be adjusted by defining the SCALE and SLACK macros. The instructions
+// comparison can be adjusted by defining the INSTRUCTIONS_PER_BYTE (maximum
+// per byte cost of a linear parse) and INSTRUCTIONS_BASE (constant overhead)
+// macros, for example, if the sanitizers inflate the counts too much.
+//
+
+// syscall() is not in POSIX.
+//
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#  define _DEFAULT_SOURCE
+#endif
+
+#define LIBPDJSON5_STATS
+
+#include <libpdjson5/pdjson5.c>
+
+#include <stdio.h>
+#include <stdlib.h> // abort(), malloc()
+#include <string.h> // strchr(), mem*()
+#include <stddef.h>
+#include <stdint.h>
+#include <inttypes.h> // PR*
+
+#ifdef __linux__
+#  include <unistd.h>      // syscall(), read()
+#  include <sys/syscall.h> // SYS_perf_event_open
+#  include <linux/perf_event.h>
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#ifndef SCALE
+#  define SCALE 4
+#endif
+
+#ifndef SLACK
+#  define SLACK 2
+#endif
+
+#ifndef INSTRUCTIONS_PER_BYTE
+#  define INSTRUCTIONS_PER_BYTE 1000
+#endif
+
+#ifndef INSTRUCTIONS_BASE
+#  define INSTRUCTIONS_BASE 100000
+#endif
+
+// User space instructions retired counter or -1 if unavailable.
+//
+static int instructions = -2;
+
+static void
+open_instructions (void)
+{
+  instructions = -1;
+
+#ifdef __linux__
+  struct perf_event_attr a;
+  memset (&a, 0, sizeof (a));
+  a.size = sizeof (a);
+  a.type = PERF_TYPE_HARDWARE;
+  a.config = PERF_COUNT_HW_INSTRUCTIONS;
+  a.exclude_kernel = 1;
+  a.exclude_hv = 1;
+
+  long fd = syscall (SYS_perf_event_open, &a, 0, -1, -1, 0);
+
+  if (fd != -1)
+    instructions = (int)fd;
+  else
+    fprintf (stderr,
+             "warning: instructions counter unavailable, only checking "
+             "statistics\n");
+#endif
+}
+
+static uint64_t
+read_instructions (void)
+{
+  uint64_t v = 0;
+
+#ifdef __linux__
+  if (read (instructions, &v, sizeof (v)) != (ssize_t)sizeof (v))
+    abort ();
+#endif
+
+  return v;
+}
+
+struct mode
+{
+  enum pdjson_language language;
+  bool streaming;
+  bool skip;
+};
+
+struct cost
+{
+  uint64_t bytes; // Input bytes consumed.
+  uint64_t events;
+  uint64_t string_bytes;
+  uint64_t slow_calls;
+  uint64_t depth;
+  uint64_t string_peak;
+  uint64_t instructions;
+};
+
+static void
+parse (pdjson_stream *json,
+       const void *data, size_t size,
+       const struct mode *m,
+       struct cost *r)
+{
+  pdjson_reopen_buffer (json, data, size);
+  pdjson_set_streaming (json, m->streaming);
+  pdjson_set_language (json, m->language);
+
+  uint64_t n = instructions != -1 ? read_instructions () : 0;
+
+  // In the streaming mode the end of input is indicated by a value without
+  // any events.
+  //
+  for (;;)
+  {
+    enum pdjson_type t;
+    bool empty = true;
+
+    for (;; empty = false)
+    {
+      t = m->skip ? pdjson_skip (json) : pdjson_next (json);
+
+      if (t == PDJSON_DONE || t == PDJSON_ERROR)
+        break;
+    }
+
+    if (!m->streaming || t == PDJSON_ERROR || empty)
+      break;
+
+    pdjson_reset (json);
+  }
+
+  r->instructions = instructions != -1 ? read_instructions () - n : 0;
+
+  pdjson_stats s;
+  bool b = pdjson_get_stats (json, &s);
+  assert (b);
+
+  r->bytes = s.bytes;
+  r->events = 0;
+  for (size_t i = 0; i != sizeof (s.events) / sizeof (s.events[0]); ++i)
+    r->events += s.events[i];
+  r->string_bytes = s.string_bytes;
+  r->slow_calls = s.slow_gets + s.slow_peeks;
+  r->depth = s.max_depth;
+  r->string_peak = s.string_peak;
+}
+
+// Check that the cost per byte consumed of parsing the scaled input did not
+// grow more than SLACK times compared to the original input. The base is
+// added to the original cost to absorb the constant overhead. Because the
+// scaled input may be tokenized differently (for example, "" is an empty
+// string while " starts one), the original cost per byte is not taken to be
+// less than the maximum per byte cost of a linear parse.
+//
+static void
+check (const char *what,
+       uint64_t cost, uint64_t bytes,
+       uint64_t scaled_cost, uint64_t scaled_bytes,
+       uint64_t base, uint64_t per_byte,
+       const char *scaling,
+       size_t size,
+       const struct mode *m)
+{
+  static const char *const languages[] = {"JSON", "JSON5", "JSON5E"};
+
+  uint64_t b = bytes != 0 ? bytes : 1;
+  uint64_t sb = scaled_bytes != 0 ? scaled_bytes : 1;
+  uint64_t c = cost + base > per_byte * b ? cost + base : per_byte * b;
+
+  // Note that the values are bounded by the (scaled) input size or the
+  // instruction count and so the products cannot overflow.
+  //
+  if (scaled_cost * b > SLACK * sb * c)
+  {
+    fprintf (stderr,
+             "error: %s grows from %" PRIu64 " for %" PRIu64 " to %" PRIu64
+             " for %" PRIu64 " bytes consumed when %s %zu bytes %d times "
+             "in %s%s%s\n",
+             what,
+             cost,
+             bytes,
+             scaled_cost,
+             scaled_bytes,
+             scaling,
+             size,
+             SCALE,
+             languages[m->language],
+             m->streaming ? " in streaming mode" : "",
+             m->skip ? " with pdjson_skip()" : "");
+    abort ();
+  }
+}
+
+static void
+compare (const struct cost *c,
+         const struct cost *s,
+         const char *scaling,
+         size_t size,
+         const struct mode *m)
+{
+#define COMPARE(what, member, base, per_byte)                           \
+  check (what, c->member, c->bytes, s->member, s->bytes, base, per_byte, \
+         scaling, size, m)
+
+  // Every byte normally produces at most one event, except for the implied
+  // object ones, and adds at most one byte plus the terminating '\0' to the
+  // name/value buffer whose size is doubled when full. The slow path is
+  // only taken at the end of input.
+  //
+  COMPARE ("events",          events,       8,  2);
+  COMPARE ("buffer bytes",    string_bytes, 8,  2);
+  COMPARE ("slow path calls", slow_calls,   16, 1);
+  COMPARE ("depth",           depth,        1,  1);
+  COMPARE ("buffer size",     string_peak,  2 * LIBPDJSON5_VALUE_INIT, 4);
+
+  if (instructions != -1)
+    COMPARE ("instructions",
+             instructions,
+             INSTRUCTIONS_BASE,
+             INSTRUCTIONS_PER_BYTE);
+
+#undef COMPARE
+}
+
+int
+LLVMFuzzerTestOneInput (const uint8_t* data, size_t size)
+{
+  static const struct mode modes[] = {
+    {PDJSON_LANGUAGE_JSON,   false, false},
+    {PDJSON_LANGUAGE_JSON,   true,  false},
+    {PDJSON_LANGUAGE_JSON5,  false, false},
+    {PDJSON_LANGUAGE_JSON5,  true,  false},
+    {PDJSON_LANGUAGE_JSON5E, false, false},
+    {PDJSON_LANGUAGE_JSON5E, true,  false},
+    {PDJSON_LANGUAGE_JSON,   false, true},
+    {PDJSON_LANGUAGE_JSON,   true,  true},
+    {PDJSON_LANGUAGE_JSON5,  false, true},
+    {PDJSON_LANGUAGE_JSON5,  true,  true},
+    {PDJSON_LANGUAGE_JSON5E, false, true},
+    {PDJSON_LANGUAGE_JSON5E, true,  true}};
+
+  if (instructions == -2)
+    open_instructions ();
+
+  // Scaled inputs: the input repeated as a whole and each byte repeated
+  // except for the delimiters (quotes, escapes, comments, separators, and
+  // decimal points) so that the tokens get longer rather than split.
+  //
+  uint8_t *repeated = (uint8_t *)malloc (size * SCALE + 1);
+  uint8_t *stretched = (uint8_t *)malloc (size * SCALE + 1);
+
+  if (repeated == NULL || stretched == NULL)
+    abort ();
+
+  for (size_t i = 0; i != SCALE; ++i)
+    memcpy (repeated + i * size, data, size);
+
+  size_t stretched_size = 0;
+  for (size_t i = 0; i != size; ++i)
+  {
+    uint8_t c = data[i];
+    size_t n = c != '\0' && strchr ("\"'\\/*:,.", c) != NULL ? 1 : SCALE;
+
+    memset (stretched + stretched_size, c, n);
+    stretched_size += n;
+  }
+
+  pdjson_stream json[1];
+
+  pdjson_open_null (json);
+
+  for (size_t i = 0; i != sizeof (modes) / sizeof (modes[0]); ++i)
+  {
+    const struct mode *m = modes + i;
+    struct cost c, s;
+
+    parse (json, data, size, m, &c);
+
+    parse (json, repeated, size * SCALE, m, &s);
+    compare (&c, &s, "repeating", size, m);
+
+    parse (json, stretched, stretched_size, m, &s);
+    compare (&c, &s, "stretching", size, m);
+  }
+
+  pdjson_close (json);
+
+  free (repeated);
+  free (stretched);
+
+  return 0;
+}
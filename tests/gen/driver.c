@@ -0,0 +1,148 @@
+// Usage: driver [<options>]
+//
+// Parse the stdin values (in the streaming mode) into the order struct
+// generated from schema.json5e and print them.
+//
+// --json5          --  accept JSON5 input
+// --locale <name>  --  parse with LC_NUMERIC set to this locale, if available
+//
+
+#include <stdio.h>
+#include <locale.h> // setlocale()
+#include <string.h> // strcmp()
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h> // PR*
+
+#include <libpdjson5/pdjson5.h>
+
+#include "schema.h"
+
+#undef NDEBUG
+#include <assert.h>
+
+static void
+print_order (const struct order *o)
+{
+  printf ("id: %" PRIu64 "\n", o->id);
+
+  if (o->name != NULL)
+    printf ("name: '%s'\n", o->name);
+
+  if (o->note != NULL)
+    printf ("note: '%s'\n", o->note);
+
+  if (o->default_ != NULL)
+    printf ("default: '%s'\n", o->default_);
+
+  printf ("priority: %" PRId32 "\n", o->priority);
+  printf ("delta: %" PRId64 "\n", o->delta);
+  printf ("paid: %s\n", o->paid ? "true" : "false");
+  printf ("x, y: %g, %g\n", o->x, o->y);
+
+  if (o->ship_to.city != NULL)
+    printf ("ship-to: '%s' %" PRIu32 "\n", o->ship_to.city, o->ship_to.zip);
+
+  for (size_t i = 0; i != o->items.size; ++i)
+  {
+    const struct item *t = o->items.data + i;
+    printf ("item: '%s' %" PRIu32 " %g\n",
+            t->sku != NULL ? t->sku : "",
+            t->quantity,
+            t->price);
+  }
+
+  for (size_t i = 0; i != o->tags.size; ++i)
+    printf ("tag: '%s'\n", o->tags.data[i]);
+
+  for (size_t i = 0; i != o->flags.size; ++i)
+    printf ("flag: %s\n", o->flags.data[i] ? "true" : "false");
+
+  for (size_t i = 0; i != o->deltas.size; ++i)
+    printf ("delta: %" PRId32 "\n", o->deltas.data[i]);
+}
+
+int
+main (int argc, char *argv[])
+{
+  enum pdjson_language language = PDJSON_LANGUAGE_JSON;
+  const char *locale = NULL;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const char *a = argv[i];
+
+    if (strcmp (a, "--json5") == 0)
+      language = PDJSON_LANGUAGE_JSON5;
+    else if (strcmp (a, "--locale") == 0)
+    {
+      if (++i == argc)
+      {
+        fprintf (stderr, "error: missing --locale argument\n");
+        return 1;
+      }
+
+      locale = argv[i];
+    }
+    else
+    {
+      fprintf (stderr, "error: unexpected argument '%s'\n", a);
+      return 1;
+    }
+  }
+
+  pdjson_stream json[1];
+  pdjson_open_stream (json, stdin);
+  pdjson_set_streaming (json, true);
+  pdjson_set_language (json, language);
+
+  int r = 0;
+  for (bool first = true; pdjson_peek (json) != PDJSON_DONE; first = false)
+  {
+    // Parse in the specified locale but print in the C locale.
+    //
+    if (locale != NULL)
+      setlocale (LC_NUMERIC, locale);
+
+    struct order o;
+    const char *e = order_parse (json, &o);
+
+    if (locale != NULL)
+      setlocale (LC_NUMERIC, "C");
+
+    if (e == NULL && pdjson_next (json) != PDJSON_DONE)
+      e = pdjson_get_error (json);
+
+    if (e != NULL)
+    {
+      fprintf (stderr,
+               "<stdin>:%" PRIu64 ":%" PRIu64 ": error: %s\n",
+               pdjson_get_line (json),
+               pdjson_get_column (json),
+               e);
+      order_free (&o);
+      r = 1;
+      break;
+    }
+
+    if (!first)
+      printf ("\n");
+
+    print_order (&o);
+    order_free (&o);
+    pdjson_reset (json);
+  }
+
+  if (r == 0 && pdjson_get_error (json) != NULL)
+  {
+    fprintf (stderr,
+             "<stdin>:%" PRIu64 ":%" PRIu64 ": error: %s\n",
+             pdjson_get_line (json),
+             pdjson_get_column (json),
+             pdjson_get_error (json));
+    r = 1;
+  }
+
+  pdjson_close (json);
+  return r;
+}
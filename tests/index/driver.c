@@ -0,0 +1,232 @@
+// Usage: driver [<options>] [<pointer>...]
+//
+// Index stdin, save the index to a temporary file and load it back, then
+// find the indexed container for each JSON pointer and parse it from its
+// position.
+//
+// --depth <n>      --  index containers down to this depth (1 by default)
+// --dump           --  print all the index entries
+// --json5          --  accept JSON5 input
+// --json5e         --  accept JSON5E input
+// --names          --  print the size of the index names pool
+//
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h> // strtoull(), realloc(), free()
+#include <string.h> // str*()
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h> // PR*
+
+#include <libpdjson5/pdjson5.h>
+#include <libpdjson5/pdjson5-index.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+static void
+print_entry (const pdjson_index *x, const struct pdjson_index_entry *e)
+{
+  const char *n = pdjson_index_get_name (x, e);
+
+  printf ("%3" PRIu64 ",%3" PRIu64 ": %s %" PRIu64 " at %" PRIu64,
+          e->line,
+          e->column,
+          e->type == PDJSON_ARRAY ? "array" : "object",
+          e->count,
+          e->position);
+
+  if (n != NULL)
+    printf (" name '%s'", n);
+  else if (e->parent != UINT64_MAX)
+    printf (" index %" PRIu64, e->key);
+
+  printf ("\n");
+}
+
+int
+main (int argc, char *argv[])
+{
+  size_t depth = 1;
+  bool dump = false;
+  bool names = false;
+  enum pdjson_language language = PDJSON_LANGUAGE_JSON;
+
+  int i = 1;
+  for (; i < argc; ++i)
+  {
+    const char* a = argv[i];
+
+    if (strcmp (a, "--depth") == 0)
+    {
+      if (++i < argc)
+      {
+        errno = 0;
+        depth = (size_t)strtoull (argv[i], NULL, 10);
+        if (errno == 0)
+          continue;
+      }
+
+      fprintf (stderr, "error: missing or invalid --depth argument\n");
+      return 1;
+    }
+    else if (strcmp (a, "--dump") == 0)
+      dump = true;
+    else if (strcmp (a, "--names") == 0)
+      names = true;
+    else if (strcmp (a, "--json5") == 0)
+      language = PDJSON_LANGUAGE_JSON5;
+    else if (strcmp (a, "--json5e") == 0)
+      language = PDJSON_LANGUAGE_JSON5E;
+    else if (a[0] != '-' || a[1] == '\0')
+      break;
+    else
+    {
+      fprintf (stderr, "error: unexpected argument '%s'\n", a);
+      return 1;
+    }
+  }
+
+  // Read the input into the buffer.
+  //
+  char *buf = NULL;
+  size_t size = 0;
+  {
+    size_t n, capacity = 0;
+    do
+    {
+      if (size == capacity)
+      {
+        capacity = capacity == 0 ? 4096 : capacity * 2;
+        buf = (char *)realloc (buf, capacity);
+        assert (buf != NULL);
+      }
+
+      n = fread (buf + size, 1, capacity - size, stdin);
+      size += n;
+    }
+    while (n != 0);
+  }
+
+  // Build the index and save it to a temporary file.
+  //
+  FILE *f = tmpfile ();
+  assert (f != NULL);
+  {
+    pdjson_stream json[1];
+    pdjson_open_buffer (json, buf, size);
+    pdjson_set_language (json, language);
+
+    pdjson_index x;
+    bool r = pdjson_index_build (&x, json, depth);
+
+    if (!r)
+    {
+      const char *e = pdjson_index_get_error (&x);
+
+      fprintf (stderr,
+               "<stdin>:%" PRIu64 ":%" PRIu64 ": error: %s\n",
+               pdjson_get_line (json),
+               pdjson_get_column (json),
+               e != NULL ? e : pdjson_get_error (json));
+    }
+    else
+      r = pdjson_index_write (&x, f);
+
+    pdjson_index_free (&x);
+    pdjson_close (json);
+
+    if (!r)
+    {
+      fclose (f);
+      free (buf);
+      return 1;
+    }
+  }
+
+  // Load the index back.
+  //
+  rewind (f);
+
+  pdjson_index x;
+  bool r = pdjson_index_read (&x, f, NULL, NULL);
+  fclose (f);
+
+  if (!r)
+  {
+    fprintf (stderr, "error: %s\n", pdjson_index_get_error (&x));
+    pdjson_index_free (&x);
+    free (buf);
+    return 1;
+  }
+
+  if (dump)
+  {
+    for (size_t j = 0; j != x.entries_size; ++j)
+      print_entry (&x, x.entries + j);
+  }
+
+  if (names)
+    printf ("names %zu\n", x.names_size);
+
+  // Find and parse the containers.
+  //
+  int rc = 0;
+  for (; i < argc; ++i)
+  {
+    const char *p = argv[i];
+    const char *rest;
+    const struct pdjson_index_entry *e = pdjson_index_find (&x, p, &rest);
+
+    if (e == NULL)
+    {
+      printf ("%s: <not found>\n", p);
+      continue;
+    }
+
+    printf ("%s: rest '%s'\n", p, rest);
+    print_entry (&x, e);
+
+    // Parse the container verifying its location and count.
+    //
+    pdjson_stream json[1];
+    pdjson_index_open_buffer (json, buf, size, e);
+    pdjson_set_language (json, language);
+
+    enum pdjson_type t = pdjson_next (json);
+    assert (t == (enum pdjson_type)e->type);
+    assert (pdjson_get_line (json) == e->line);
+    assert (pdjson_get_column (json) == e->column);
+
+    uint64_t count = 0;
+    while ((t = pdjson_next (json)) != PDJSON_DONE && t != PDJSON_ERROR)
+    {
+      if (pdjson_get_depth (json) == 1 && t != PDJSON_NAME &&
+          t != PDJSON_OBJECT_END && t != PDJSON_ARRAY_END)
+        count++;
+      else if (pdjson_get_depth (json) == 2 &&
+               (t == PDJSON_OBJECT || t == PDJSON_ARRAY))
+        count++;
+    }
+
+    if (t == PDJSON_ERROR)
+    {
+      fprintf (stderr,
+               "<stdin>:%" PRIu64 ":%" PRIu64 ": error: %s\n",
+               pdjson_get_line (json),
+               pdjson_get_column (json),
+               pdjson_get_error (json));
+      rc = 1;
+    }
+    else
+      assert (count == e->count);
+
+    pdjson_close (json);
+  }
+
+  pdjson_index_free (&x);
+  free (buf);
+
+  return rc;
+}
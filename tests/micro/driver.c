@@ -0,0 +1,539 @@
+// Usage: driver [<options>] [<kernel>...]
+//
+// Benchmark the parser's internal kernels in isolation across input sizes,
+// printing for each kernel and size the best time over the repetitions and
+// the peak resident set size (each measurement is performed in a separate
+// process). The output is a whitespace-separated table suitable for
+// plotting (for example, size against ns/byte or rss with gnuplot) in
+// order to spot superlinear behavior and cache cliffs.
+//
+// --min-size <num>  --  smallest input size in bytes (64 by default)
+// --max-size <num>  --  largest input size in bytes (1MiB by default, use
+//                       1073741824 for the full 1GiB curve)
+// --step <num>      --  size multiplier between measurements (2 by default)
+// --time <num>      --  minimum time in milliseconds to repeat each
+//                       measurement for (10 by default)
+//
+// The kernels (all by default) are:
+//
+// space          --  next() skipping whitespace
+// comment        --  skip_comment() skipping a block comment
+// string         --  read_string() with ASCII characters
+// string-escape  --  read_string() with escape sequences
+// string-utf8    --  read_string() with UTF-8 multi-byte sequences
+// number         --  read_number() with a long number
+// identifier     --  read_identifier() with a long JSON5E identifier
+// nesting        --  push()/pop() to the depth of half the size
+// skip           --  pdjson_skip() over an array of objects
+// next           --  pdjson_next() loop over an array of objects
+// callbacks      --  pdjson_parse_callbacks() over an array of objects
+// batch          --  pdjson_next_batch() loop over an array of objects
+//
+// The next, callbacks, and batch kernels parse the same input and get the
+// same names/values, so comparing them shows the overhead of each
+// interface.
+//
+// Note that this driver includes the library source file in order to access
+// the static functions and so is not linked to the library. It is also
+// POSIX-only (fork(), getrusage(), clock_gettime()).
+//
+
+#ifndef _POSIX_C_SOURCE
+#  define _POSIX_C_SOURCE 200809L
+#elif _POSIX_C_SOURCE < 200809L
+#  error incompatible _POSIX_C_SOURCE level
+#endif
+
+// Don't limit the depth of nesting for the nesting kernel.
+//
+#define LIBPDJSON5_STACK_MAX 0
+
+#include <libpdjson5/pdjson5.c>
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>  // strtoull(), malloc()
+#include <string.h>  // str*(), mem*()
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h> // PR*
+
+#include <time.h>         // clock_gettime()
+#include <unistd.h>       // fork()
+#include <sys/wait.h>     // waitpid()
+#include <sys/resource.h> // getrusage()
+
+#undef NDEBUG
+#include <assert.h>
+
+// Fill the buffer by repeating the pattern as many times as fits into size
+// bytes and then padding the rest with the specified character.
+//
+static void
+fill (char *b, size_t size, const char *pattern, char pad)
+{
+  size_t n = strlen (pattern);
+  size_t i = 0;
+
+  for (; i + n <= size; i += n)
+    memcpy (b + i, pattern, n);
+
+  memset (b + i, pad, size - i);
+}
+
+// Kernel input generators. The size is at least 64 bytes.
+//
+static void
+generate_space (char *b, size_t size)
+{
+  fill (b, size - 1, "  \t  \n      ", ' ');
+  b[size - 1] = '0';
+}
+
+static void
+generate_comment (char *b, size_t size)
+{
+  fill (b, size - 2, " lorem ipsum dolor sit amet\n", ' ');
+  memcpy (b + size - 2, "*/", 2);
+}
+
+static void
+generate_string (char *b, size_t size)
+{
+  fill (b, size - 1, "lorem ipsum dolor sit amet ", ' ');
+  b[size - 1] = '"';
+}
+
+static void
+generate_string_escape (char *b, size_t size)
+{
+  fill (b, size - 1, "ab\\n\\\"cd\\\\\\u00e9\\t", 'a');
+  b[size - 1] = '"';
+}
+
+static void
+generate_string_utf8 (char *b, size_t size)
+{
+  fill (b,
+        size - 1,
+        "\xce\xb1\xce\xb2\xce\xb3 \xe4\xb8\x96\xe7\x95\x8c \xf0\x9f\x9a\x80 ",
+        'a');
+  b[size - 1] = '"';
+}
+
+static void
+generate_number (char *b, size_t size)
+{
+  fill (b, size - 7, "1234567890", '1');
+  memcpy (b + size - 7, ".25e+9,", 7);
+}
+
+static void
+generate_identifier (char *b, size_t size)
+{
+  fill (b, size - 1, "name_$9-x.", 'z');
+  b[size - 1] = ':';
+}
+
+static void
+generate_skip (char *b, size_t size)
+{
+  b[0] = '[';
+  fill (b + 1,
+        size - 3,
+        "{\"a\": [1, \"x\", true, null], \"b\": {\"c\": 2.5}}, ",
+        ' ');
+  memcpy (b + size - 2, "0]", 2);
+}
+
+// Kernels. Each is called on the stream opened on the generated input.
+//
+static void
+run_space (pdjson_stream *json, size_t size)
+{
+  (void)size;
+  int c = next (json, json->flags & LANG_MASK);
+  assert (c == '0');
+}
+
+static void
+run_comment (pdjson_stream *json, size_t size)
+{
+  (void)size;
+  int c = skip_comment (json, '*');
+  assert (c == '/');
+}
+
+static void
+run_string (pdjson_stream *json, size_t size)
+{
+  (void)size;
+  enum pdjson_type t = read_string (json, '"', json->flags & LANG_MASK);
+  assert (t == PDJSON_STRING);
+}
+
+static void
+run_number (pdjson_stream *json, size_t size)
+{
+  (void)size;
+  enum pdjson_type t = read_number (json,
+                                      source_get (json),
+                                      json->flags & LANG_MASK);
+  assert (t == PDJSON_NUMBER);
+}
+
+static void
+run_identifier (pdjson_stream *json, size_t size)
+{
+  (void)size;
+  enum pdjson_type t = read_identifier (json,
+                                          source_get (json),
+                                          json->flags & LANG_MASK);
+  assert (t == PDJSON_NAME);
+}
+
+static void
+run_nesting (pdjson_stream *json, size_t size)
+{
+  size_t n = size / 2;
+
+  for (size_t i = 0; i != n; ++i)
+  {
+    enum pdjson_type t = push (json,
+                               i % 2 == 0 ? PDJSON_ARRAY : PDJSON_OBJECT);
+    assert (t != PDJSON_ERROR);
+  }
+
+  for (size_t i = n; i != 0; --i)
+    pop (json, i % 2 == 0 ? PDJSON_OBJECT_END : PDJSON_ARRAY_END);
+
+  assert (json->stack_top == (size_t)-1);
+}
+
+static void
+run_skip (pdjson_stream *json, size_t size)
+{
+  (void)size;
+  enum pdjson_type t = pdjson_skip (json);
+  assert (t == PDJSON_ARRAY);
+}
+
+// Call pdjson_next() and pdjson_get_value() through pointers, the same as
+// from outside of the library, rather than letting the compiler inline
+// them into the loop.
+//
+static enum pdjson_type (*volatile next_f) (pdjson_stream *) = &pdjson_next;
+static const char *(*volatile get_value_f) (const pdjson_stream *, size_t *) =
+  &pdjson_get_value;
+
+static void
+run_next (pdjson_stream *json, size_t size)
+{
+  (void)size;
+  size_t n = 0;
+
+  for (enum pdjson_type t; (t = next_f (json)) != PDJSON_DONE; )
+  {
+    assert (t != PDJSON_ERROR);
+
+    if (t == PDJSON_NAME || t == PDJSON_STRING || t == PDJSON_NUMBER)
+    {
+      size_t z;
+      get_value_f (json, &z);
+      n += z;
+    }
+  }
+
+  assert (n != 0);
+}
+
+static enum pdjson_handler_result
+callback_value (const char *v, size_t z, void *context)
+{
+  (void)v;
+  *(size_t *)context += z;
+  return PDJSON_HANDLER_CONTINUE;
+}
+
+static void
+run_callbacks (pdjson_stream *json, size_t size)
+{
+  (void)size;
+  size_t n = 0;
+
+  pdjson_handler h;
+  memset (&h, 0, sizeof (h));
+  h.name = &callback_value;
+  h.string = &callback_value;
+  h.number = &callback_value;
+
+  enum pdjson_type t = pdjson_parse_callbacks (json, &h, &n);
+  assert (t == PDJSON_DONE);
+  assert (n != 0);
+}
+
+static void
+run_batch (pdjson_stream *json, size_t size)
+{
+  (void)size;
+  size_t n = 0;
+
+  pdjson_event es[64];
+  for (bool done = false; !done; )
+  {
+    size_t m = pdjson_next_batch (json, es, sizeof (es) / sizeof (es[0]));
+
+    for (size_t i = 0; i != m; ++i)
+    {
+      assert (es[i].type != PDJSON_ERROR);
+
+      n += es[i].size;
+      done = es[i].type == PDJSON_DONE;
+    }
+  }
+
+  assert (n != 0);
+}
+
+struct kernel
+{
+  const char *name;
+  enum pdjson_language language;
+  void (*generate) (char *, size_t); // NULL if no input.
+  void (*run) (pdjson_stream *, size_t);
+};
+
+static const struct kernel kernels[] = {
+  {"space",         PDJSON_LANGUAGE_JSON,   &generate_space,      &run_space},
+  {"comment",       PDJSON_LANGUAGE_JSON5,  &generate_comment,  &run_comment},
+  {"string",        PDJSON_LANGUAGE_JSON,   &generate_string,    &run_string},
+  {"string-escape", PDJSON_LANGUAGE_JSON,   &generate_string_escape,
+                                                                 &run_string},
+  {"string-utf8",   PDJSON_LANGUAGE_JSON,   &generate_string_utf8,
+                                                                 &run_string},
+  {"number",        PDJSON_LANGUAGE_JSON,   &generate_number,    &run_number},
+  {"identifier",    PDJSON_LANGUAGE_JSON5E, &generate_identifier,
+                                                             &run_identifier},
+  {"nesting",       PDJSON_LANGUAGE_JSON,   NULL,               &run_nesting},
+  {"skip",          PDJSON_LANGUAGE_JSON,   &generate_skip,        &run_skip},
+  {"next",          PDJSON_LANGUAGE_JSON,   &generate_skip,        &run_next},
+  {"callbacks",     PDJSON_LANGUAGE_JSON,   &generate_skip,   &run_callbacks},
+  {"batch",         PDJSON_LANGUAGE_JSON,   &generate_skip,       &run_batch}};
+
+static uint64_t
+now (void)
+{
+  struct timespec t;
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000 + (uint64_t)t.tv_nsec;
+}
+
+// Perform the measurement and print the result. Return false on failure.
+// Called in the child process.
+//
+static bool
+measure (const struct kernel *k, size_t size, uint64_t min_time)
+{
+  char *b = NULL;
+  if (k->generate != NULL)
+  {
+    if ((b = (char *)malloc (size)) == NULL)
+    {
+      fprintf (stderr, "error: unable to allocate %zu\n", size);
+      return false;
+    }
+
+    k->generate (b, size);
+  }
+
+  pdjson_stream json[1];
+  pdjson_open_buffer (json, b != NULL ? b : "", b != NULL ? size : 0);
+  pdjson_set_language (json, k->language);
+
+  uint64_t best = UINT64_MAX;
+  uint64_t reps = 0;
+
+  for (uint64_t total = 0; total < min_time || reps == 0; ++reps)
+  {
+    if (b != NULL)
+      pdjson_reopen_buffer (json, b, size);
+
+    uint64_t s = now ();
+    k->run (json, size);
+    uint64_t t = now () - s;
+
+    assert (!(json->flags & FLAG_ERROR));
+
+    if (t < best)
+      best = t;
+
+    total += t;
+  }
+
+  pdjson_close (json);
+  free (b);
+
+  struct rusage u;
+  if (getrusage (RUSAGE_SELF, &u) != 0)
+  {
+    fprintf (stderr, "error: unable to get resource usage\n");
+    return false;
+  }
+
+  // Note that ru_maxrss is in bytes on Mac OS and in KiB elsewhere.
+  //
+#ifdef __APPLE__
+  uint64_t rss = (uint64_t)u.ru_maxrss / 1024;
+#else
+  uint64_t rss = (uint64_t)u.ru_maxrss;
+#endif
+
+  printf ("%-14s %11zu %9" PRIu64 " %13" PRIu64 " %9.3f %10.1f %10" PRIu64
+          "\n",
+          k->name,
+          size,
+          reps,
+          best,
+          (double)best / size,
+          best != 0 ? size * 1e3 / best : 0.0,
+          rss);
+
+  return true;
+}
+
+static bool
+parse_size (int argc, char *argv[], int *i, uint64_t *r)
+{
+  if (++*i < argc)
+  {
+    errno = 0;
+    *r = strtoull (argv[*i], NULL, 10);
+    return errno == 0 && *r != 0;
+  }
+
+  return false;
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint64_t min_size = 64;
+  uint64_t max_size = 1024 * 1024;
+  uint64_t step = 2;
+  uint64_t min_time = 10;
+
+  int i = 1;
+  for (; i < argc; ++i)
+  {
+    const char* a = argv[i];
+
+    if (strcmp (a, "--min-size") == 0)
+    {
+      if (!parse_size (argc, argv, &i, &min_size) || min_size < 64)
+      {
+        fprintf (stderr, "error: missing or invalid --min-size argument\n");
+        return 1;
+      }
+    }
+    else if (strcmp (a, "--max-size") == 0)
+    {
+      if (!parse_size (argc, argv, &i, &max_size))
+      {
+        fprintf (stderr, "error: missing or invalid --max-size argument\n");
+        return 1;
+      }
+    }
+    else if (strcmp (a, "--step") == 0)
+    {
+      if (!parse_size (argc, argv, &i, &step) || step < 2)
+      {
+        fprintf (stderr, "error: missing or invalid --step argument\n");
+        return 1;
+      }
+    }
+    else if (strcmp (a, "--time") == 0)
+    {
+      if (!parse_size (argc, argv, &i, &min_time))
+      {
+        fprintf (stderr, "error: missing or invalid --time argument\n");
+        return 1;
+      }
+    }
+    else if (a[0] != '-')
+      break;
+    else
+    {
+      fprintf (stderr, "error: unexpected argument '%s'\n", a);
+      return 1;
+    }
+  }
+
+  // Collect the kernels to run.
+  //
+  const size_t kernels_size = sizeof (kernels) / sizeof (kernels[0]);
+  bool selected[sizeof (kernels) / sizeof (kernels[0])];
+
+  for (size_t j = 0; j != kernels_size; ++j)
+    selected[j] = (i == argc);
+
+  for (; i < argc; ++i)
+  {
+    size_t j = 0;
+    for (; j != kernels_size; ++j)
+    {
+      if (strcmp (argv[i], kernels[j].name) == 0)
+        break;
+    }
+
+    if (j == kernels_size)
+    {
+      fprintf (stderr, "error: unknown kernel '%s'\n", argv[i]);
+      return 1;
+    }
+
+    selected[j] = true;
+  }
+
+  printf ("# %-12s %11s %9s %13s %9s %10s %10s\n",
+          "kernel", "size", "reps", "ns", "ns/byte", "MB/s", "rss-KiB");
+
+  for (size_t j = 0; j != kernels_size; ++j)
+  {
+    if (!selected[j])
+      continue;
+
+    for (uint64_t size = min_size; size <= max_size; size *= step)
+    {
+      fflush (stdout);
+
+      pid_t pid = fork ();
+      if (pid == -1)
+      {
+        fprintf (stderr, "error: unable to fork\n");
+        return 1;
+      }
+
+      if (pid == 0)
+      {
+        bool r = measure (kernels + j, (size_t)size, min_time * 1000000);
+        fflush (stdout);
+        _exit (r ? 0 : 1);
+      }
+
+      int s;
+      if (waitpid (pid, &s, 0) == -1 || !WIFEXITED (s) || WEXITSTATUS (s) != 0)
+      {
+        fprintf (stderr,
+                 "error: %s kernel failed for size %" PRIu64 "\n",
+                 kernels[j].name,
+                 size);
+        return 1;
+      }
+
+      if (size > UINT64_MAX / step)
+        break;
+    }
+  }
+
+  return 0;
+}
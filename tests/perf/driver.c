@@ -2,15 +2,48 @@
 //
 // --size <num>       --  input size in KiB to parse
 // --iteration <num>  --  number of times to parse
+// --warmup <num>     --  number of untimed times to parse first (0 by
+//                        default, 1 with --report)
+// --corpus <name>    --  input corpus to parse (fragment by default, see
+//                        below)
+// --minify           --  remove insignificant whitespace from the corpus
 // --stdio            --  use stdio memory stream instead of memory buffer
 // --userio           --  use io callbacks instead of memory buffer
+// --read-ahead <num> --  read stdio/userio input ahead in blocks of num bytes
+// --batch <num>      --  parse in batches of num events
+// --validate         --  only validate the input
 // --json5            --  parse as JSON5 input
 // --json5e           --  parse as JSON5E input
+// --report           --  time each iteration and print the median and p99
+//                        throughput
+// --suite            --  report every corpus, pretty and minified, with
+//                        every input source
+// --counters         --  also report hardware performance counters (Linux
+//                        only, implies --report)
+// --dump             --  print the corpus instead of parsing it
 //
-// Note that --stdio is not supported on Windows.
+// The corpora are:
+//
+// fragment  --  object with a mix of all the value types repeated
+// nested    --  array of objects and arrays nested 32 levels deep
+// strings   --  array of objects with long strings containing escapes
+// numbers   --  GeoJSON-like polygons with coordinates
+// unicode   --  array of objects with non-ASCII strings and \u escapes
+// ndjson    --  newline-delimited objects parsed in the streaming mode
+// json5     --  JSON5 configuration with comments and unquoted names
+// json5e    --  JSON5E configuration with implied top-level object
+//
+// The corpora are pretty-printed and generated deterministically. Note that
+// --stdio is not supported on Windows.
+//
+// The hardware counters are only counted in user space and while parsing.
+// If some or all of them are unavailable (not supported by the CPU or
+// virtual machine, restricted by perf_event_paranoid, etc), then they are
+// reported as such and the rest of the report is unaffected.
 //
 
-// fmemopen() is in POSIX.1-2008. Not available on Windows.
+// fmemopen() and clock_gettime() are in POSIX.1-2008. Not available on
+// Windows.
 //
 #ifndef _POSIX_C_SOURCE
 #  define _POSIX_C_SOURCE 200809L
@@ -18,15 +51,36 @@
 #  error incompatible _POSIX_C_SOURCE level
 #endif
 
+// syscall() is not in POSIX.
+//
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#  define _DEFAULT_SOURCE
+#endif
+
 #include <stdio.h>
 #include <errno.h>
+#include <stdarg.h>
 #include <stddef.h> // size_t
-#include <stdlib.h> // strtoull(), malloc()
+#include <stdlib.h> // strtoull(), malloc(), qsort()
 #include <string.h> // str*()
 #include <stdint.h>
 #include <stdbool.h>
 #include <inttypes.h> // PR*
 
+#ifdef __linux__
+#  include <unistd.h>      // syscall(), read(), close()
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h> // SYS_perf_event_open
+#  include <linux/perf_event.h>
+#endif
+
+#ifndef _WIN32
+#  include <time.h> // clock_gettime()
+#else
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h> // QueryPerformance*()
+#endif
+
 #include <libpdjson5/pdjson5.h>
 
 #undef NDEBUG
@@ -47,11 +101,68 @@ static const char json_fragment[] =
 "        \"object\": {\"line\":73,\"column\":64,\"position\":123}\n"
 "    }";
 
+static const char *const words[] = {
+  "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing",
+  "elit", "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore",
+  "et", "dolore", "magna", "aliqua", "enim", "ad", "minim", "veniam",
+  "quis", "nostrud", "exercitation", "ullamco", "laboris", "nisi"};
+
+// Words with JSON escape sequences.
+//
+static const char *const escaped_words[] = {
+  "\\\"quoted\\\"", "C:\\\\Temp", "line\\nbreak", "tab\\tstop",
+  "\\/path", "bell\\u0007"};
+
+static const struct
+{
+  const char *lang;
+  const char *text;
+} texts[] = {
+  {"el",
+   "\xce\x97 \xce\xb3\xcf\x81\xce\xae\xce\xb3\xce\xbf\xcf\x81"
+   "\xce\xb7 \xce\xba\xce\xb1\xcf\x86\xce\xad \xce\xb1\xce\xbb"
+   "\xce\xb5\xcf\x80\xce\xbf\xcf\x8d \xcf\x80\xce\xb7\xce\xb4"
+   "\xce\xac\xce\xb5\xce\xb9 \xcf\x80\xce\xac\xce\xbd\xcf\x89 "
+   "\xce\xb1\xcf\x80\xcf\x8c \xcf\x84\xce\xbf\xce\xbd \xcf\x84"
+   "\xce\xb5\xce\xbc\xcf\x80\xce\xad\xce\xbb\xce\xb7 \xcf\x83"
+   "\xce\xba\xcf\x8d\xce\xbb\xce\xbf."},
+  {"ru",
+   "\xd0\xa1\xd1\x8a\xd0\xb5\xd1\x88\xd1\x8c \xd0\xb6\xd0\xb5 "
+   "\xd0\xb5\xd1\x89\xd1\x91 \xd1\x8d\xd1\x82\xd0\xb8\xd1\x85 "
+   "\xd0\xbc\xd1\x8f\xd0\xb3\xd0\xba\xd0\xb8\xd1\x85 \xd1\x84"
+   "\xd1\x80\xd0\xb0\xd0\xbd\xd1\x86\xd1\x83\xd0\xb7\xd1\x81\xd0\xba"
+   "\xd0\xb8\xd1\x85 \xd0\xb1\xd1\x83\xd0\xbb\xd0\xbe\xd0\xba, "
+   "\xd0\xb4\xd0\xb0 \xd0\xb2\xd1\x8b\xd0\xbf\xd0\xb5\xd0\xb9 "
+   "\xd1\x87\xd0\xb0\xd1\x8e."},
+  {"zh",
+   "\xe6\x88\x91\xe8\x83\xbd\xe5\x90\x9e\xe4\xb8\x8b\xe7\x8e\xbb"
+   "\xe7\x92\x83\xe8\x80\x8c\xe4\xb8\x8d\xe4\xbc\xa4\xe8\xba\xab"
+   "\xe4\xbd\x93\xe3\x80\x82"},
+  {"ja",
+   "\xe3\x81\x84\xe3\x82\x8d\xe3\x81\xaf\xe3\x81\xab\xe3\x81\xbb"
+   "\xe3\x81\xb8\xe3\x81\xa8 \xe3\x81\xa1\xe3\x82\x8a\xe3\x81\xac"
+   "\xe3\x82\x8b\xe3\x82\x92"},
+  {"ar",
+   "\xd9\x86\xd8\xb5 \xd8\xad\xd9\x83\xd9\x8a\xd9\x85 \xd9\x84"
+   "\xd9\x87 \xd8\xb3\xd8\xb1 \xd9\x82\xd8\xa7\xd8\xb7\xd8\xb9 "
+   "\xd9\x88\xd8\xb0\xd9\x88 \xd8\xb4\xd8\xa3\xd9\x86 \xd8\xb9"
+   "\xd8\xb8\xd9\x8a\xd9\x85"},
+  {"emoji",
+   "Ship it \xf0\x9f\x9a\x80, test it \xf0\x9f\xa7\xaa, fix it "
+   "\xf0\x9f\x94\xa7!"},
+};
+
+// The same text as JSON escape sequences, including a surrogate pair.
+//
+static const char unicode_escapes[] =
+  "\\u03b1\\u03b2\\u03b3 \\u043f\\u0440\\u0438 \\u4e16\\u754c \\ud83d\\ude80";
+
 struct buffer
 {
   char *data;
   size_t size;
   size_t pos;
+  size_t capacity;
 };
 
 static int
@@ -68,6 +179,19 @@ io_get (void *d)
   return b->pos != b->size ? b->data[b->pos++] : EOF;
 }
 
+static size_t
+io_read (void *p, size_t n, void *d)
+{
+  struct buffer *b = (struct buffer *)d;
+
+  if (n > b->size - b->pos)
+    n = b->size - b->pos;
+
+  memcpy (p, b->data + b->pos, n);
+  b->pos += n;
+  return n;
+}
+
 bool
 io_error (void * d)
 {
@@ -75,111 +199,711 @@ io_error (void * d)
   return false;
 }
 
-int
-main (int argc, char *argv[])
+// Corpus generation.
+//
+static void
+append (struct buffer *b, const char *s, size_t n)
 {
-  assert (sizeof (json_fragment) == 511); // Includes \0, so 510.
+  if (b->size + n > b->capacity)
+  {
+    size_t c = b->capacity == 0 ? 4096 : b->capacity * 2;
+    if (c < b->size + n)
+      c = b->size + n;
 
-  size_t size = 10;
-  uint64_t iter = 10;
-  bool stdio = false;
-  bool userio = false;
-  enum pdjson_language language = PDJSON_LANGUAGE_JSON;
+    char *d = (char *)realloc (b->data, c);
+    if (d == NULL)
+    {
+      fprintf (stderr, "error: unable to allocate %zu\n", c);
+      exit (1);
+    }
 
-  for (int i = 1; i < argc; ++i)
+    b->data = d;
+    b->capacity = c;
+  }
+
+  memcpy (b->data + b->size, s, n);
+  b->size += n;
+}
+
+static void
+appends (struct buffer *b, const char *s)
+{
+  append (b, s, strlen (s));
+}
+
+static void
+appendf (struct buffer *b, const char *f, ...)
+{
+  char s[256];
+
+  va_list a;
+  va_start (a, f);
+  int n = vsnprintf (s, sizeof (s), f, a);
+  va_end (a);
+
+  assert (n >= 0 && (size_t)n < sizeof (s));
+  append (b, s, (size_t)n);
+}
+
+static void
+indent (struct buffer *b, size_t n)
+{
+  for (; n != 0; --n)
+    append (b, "  ", 2);
+}
+
+// Deterministic pseudo-random number generator (PCG-style LCG).
+//
+static uint32_t
+rnd (uint64_t *s)
+{
+  *s = *s * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (uint32_t)(*s >> 33);
+}
+
+static uint32_t
+rnd_range (uint64_t *s, uint32_t min, uint32_t max)
+{
+  return min + rnd (s) % (max - min + 1);
+}
+
+static double
+rnd_double (uint64_t *s, double min, double max)
+{
+  return min + (max - min) * (rnd (s) / 2147483648.0);
+}
+
+// Append space-separated words, some of them with escapes if requested.
+//
+static void
+append_words (struct buffer *b, uint64_t *s, size_t n, bool escapes)
+{
+  for (size_t i = 0; i != n; ++i)
   {
-    const char* a = argv[i];
+    if (i != 0)
+      append (b, " ", 1);
 
-    if (strcmp (a, "--size") == 0)
+    if (escapes && rnd (s) % 16 == 0)
+      appends (b, escaped_words[rnd (s) % (sizeof (escaped_words) /
+                                           sizeof (escaped_words[0]))]);
+    else
+      appends (b, words[rnd (s) % (sizeof (words) / sizeof (words[0]))]);
+  }
+}
+
+static void
+generate_fragment (struct buffer *b, size_t size)
+{
+  appends (b, "{\n");
+
+  for (size_t i = 0; i != size / 512; ++i)
+  {
+    if (i != 0)
+      appends (b, ",\n");
+
+    append (b, json_fragment, sizeof (json_fragment) - 1);
+  }
+
+  appends (b, "\n}");
+}
+
+static void
+generate_nested (struct buffer *b, size_t size)
+{
+  const size_t depth = 32;
+
+  appends (b, "[\n");
+
+  for (bool first = true; b->size < size; first = false)
+  {
+    if (!first)
+      appends (b, ",\n");
+
+    indent (b, 1);
+
+    for (size_t d = 0; d != depth; ++d)
     {
-      if (++i < argc)
-      {
-        errno = 0;
-        size = (size_t)strtoull (argv[i], NULL, 10);
-        if (errno == 0 && size != 0)
-          continue;
-      }
+      size_t i = 1 + d * 2; // Object indentation.
 
-      fprintf (stderr, "error: missing or invalid --size argument\n");
-      return 1;
+      if (d != 0)
+        indent (b, i);
+
+      appends (b, "{\n");
+      indent (b, i + 1);
+      appendf (b, "\"depth\": %zu,\n", d);
+      indent (b, i + 1);
+      appends (b, "\"items\": [\n");
+      indent (b, i + 2);
+      appends (b, d % 2 == 0 ? "true,\n" : "\"item\",\n");
     }
-    else if (strcmp (a, "--iteration") == 0)
+
+    indent (b, 1 + depth * 2);
+    appends (b, "null\n");
+
+    for (size_t d = depth; d-- != 0; )
     {
-      if (++i < argc)
-      {
-        errno = 0;
-        iter = strtoull (argv[i], NULL, 10);
-        if (errno == 0 && iter != 0)
-          continue;
-      }
+      size_t i = 1 + d * 2;
 
-      fprintf (stderr, "error: missing or invalid --iteration argument\n");
-      return 1;
+      indent (b, i + 1);
+      appends (b, "]\n");
+      indent (b, i);
+      appends (b, d != 0 ? "}\n" : "}");
     }
-    else if (strcmp (a, "--stdio") == 0)
-      stdio = true;
-    else if (strcmp (a, "--userio") == 0)
-      userio = true;
-    else if (strcmp (a, "--json5") == 0)
-      language = PDJSON_LANGUAGE_JSON5;
-    else if (strcmp (a, "--json5e") == 0)
-      language = PDJSON_LANGUAGE_JSON5E;
-    else
+  }
+
+  appends (b, "\n]\n");
+}
+
+static void
+generate_strings (struct buffer *b, size_t size)
+{
+  uint64_t s = 1;
+
+  appends (b, "[\n");
+
+  for (bool first = true; b->size < size; first = false)
+  {
+    if (!first)
+      appends (b, ",\n");
+
+    appends (b, "  {\n");
+    appendf (b,
+             "    \"id\": \"%08" PRIx32 "%08" PRIx32 "%08" PRIx32 "\",\n",
+             rnd (&s), rnd (&s), rnd (&s));
+
+    appends (b, "    \"title\": \"");
+    append_words (b, &s, rnd_range (&s, 4, 8), false);
+    appends (b, "\",\n");
+
+    appends (b, "    \"body\": \"");
+    append_words (b, &s, rnd_range (&s, 20, 80), true);
+    appends (b, "\",\n");
+
+    appends (b, "    \"tags\": [");
+    for (size_t i = 0, n = rnd_range (&s, 1, 4); i != n; ++i)
     {
-      fprintf (stderr, "error: unexpected argument '%s'\n", a);
-      return 1;
+      appends (b, i != 0 ? ", \"" : "\"");
+      append_words (b, &s, 1, false);
+      appends (b, "\"");
     }
+    appends (b, "]\n");
+
+    appends (b, "  }");
   }
 
-  if (stdio && userio)
+  appends (b, "\n]\n");
+}
+
+static void
+generate_numbers (struct buffer *b, size_t size)
+{
+  uint64_t s = 1;
+
+  appends (b,
+           "{\n"
+           "  \"type\": \"FeatureCollection\",\n"
+           "  \"features\": [\n");
+
+  for (size_t id = 1; b->size < size; ++id)
   {
-    fprintf (stderr, "error: both --stdio and --userio specified\n");
-    return 1;
+    if (id != 1)
+      appends (b, ",\n");
+
+    appends (b,
+             "    {\n"
+             "      \"type\": \"Feature\",\n"
+             "      \"properties\": {\n");
+    appendf (b, "        \"id\": %zu,\n", id);
+    appendf (b, "        \"elevation\": %.2f\n", rnd_double (&s, -50, 4000));
+    appends (b,
+             "      },\n"
+             "      \"geometry\": {\n"
+             "        \"type\": \"Polygon\",\n"
+             "        \"coordinates\": [\n"
+             "          [\n");
+
+    double lon = rnd_double (&s, -180, 180);
+    double lat = rnd_double (&s, -85, 85);
+
+    for (size_t i = 0, n = rnd_range (&s, 8, 64); i != n; ++i)
+    {
+      appendf (b,
+               "            [%.6f, %.6f]%s\n",
+               lon + rnd_double (&s, -0.05, 0.05),
+               lat + rnd_double (&s, -0.05, 0.05),
+               i + 1 != n ? "," : "");
+    }
+
+    appends (b,
+             "          ]\n"
+             "        ]\n"
+             "      }\n"
+             "    }");
   }
 
-  struct buffer buf;
+  appends (b, "\n  ]\n}\n");
+}
 
-  buf.size = size * 1024 + 2 + 1;
-  buf.data = (char *)malloc (buf.size);
+static void
+generate_unicode (struct buffer *b, size_t size)
+{
+  appends (b, "[\n");
 
-  if (buf.data == NULL)
+  for (size_t i = 0; b->size < size; ++i)
   {
-    fprintf (stderr, "error: unable to allocate %zu\n", buf.size);
-    return 1;
+    if (i != 0)
+      appends (b, ",\n");
+
+    size_t t = i % (sizeof (texts) / sizeof (texts[0]));
+
+    appends (b, "  {\n");
+    appendf (b, "    \"lang\": \"%s\",\n", texts[t].lang);
+    appendf (b, "    \"text\": \"%s\",\n", texts[t].text);
+    appendf (b, "    \"escaped\": \"%s\"\n", unicode_escapes);
+    appends (b, "  }");
+  }
+
+  appends (b, "\n]\n");
+}
+
+static void
+generate_ndjson (struct buffer *b, size_t size)
+{
+  static const char *const levels[] = {"debug", "info", "warning", "error"};
+
+  uint64_t s = 1;
+
+  for (size_t id = 1; b->size < size; ++id)
+  {
+    appendf (b,
+             "{\"id\": %zu, \"time\": \"2025-10-14T16:%02" PRIu32 ":%02"
+             PRIu32 "Z\", \"level\": \"%s\", \"message\": \"",
+             id,
+             rnd (&s) % 60,
+             rnd (&s) % 60,
+             levels[rnd (&s) % 4]);
+    append_words (b, &s, rnd_range (&s, 4, 12), true);
+    appendf (b,
+             "\", \"latency\": %.3f, \"ok\": %s, \"tags\": [\"",
+             rnd_double (&s, 0, 500),
+             rnd (&s) % 8 != 0 ? "true" : "false");
+    append_words (b, &s, 1, false);
+    appends (b, "\", \"");
+    append_words (b, &s, 1, false);
+    appends (b, "\"]}\n");
+  }
+}
+
+static void
+generate_json5 (struct buffer *b, size_t size)
+{
+  uint64_t s = 1;
+
+  appends (b,
+           "// Service configuration.\n"
+           "//\n"
+           "{\n"
+           "  services: [\n");
+
+  for (size_t id = 1; b->size < size; ++id)
+  {
+    appends (b, "    {\n");
+    appendf (b, "      name: 'service-%zu',\n", id);
+    appends (b, "      /* Internal address. */\n");
+    appendf (b,
+             "      host: '10.0.%" PRIu32 ".%" PRIu32 "',\n",
+             rnd (&s) % 256,
+             rnd (&s) % 256);
+    appendf (b, "      port: 0x%" PRIX32 ",\n", rnd_range (&s, 1024, 65535));
+    appendf (b, "      timeout: +%" PRIu32 ".5,\n", rnd (&s) % 120);
+    appendf (b, "      ratio: .%02" PRIu32 ",\n", rnd (&s) % 100);
+    appends (b,
+             "      limit: Infinity,\n"
+             "      enabled: true,\n"
+             "      \"log-level\": 'info', // Or 'debug'.\n"
+             "      tags: ['");
+    append_words (b, &s, 1, false);
+    appends (b, "', '");
+    append_words (b, &s, 1, false);
+    appends (b, "',],\n");
+    appends (b, "    },\n");
+  }
+
+  appends (b, "  ],\n}\n");
+}
+
+static void
+generate_json5e (struct buffer *b, size_t size)
+{
+  uint64_t s = 1;
+
+  appends (b,
+           "# Service configuration.\n"
+           "#\n");
+
+  for (size_t id = 1; b->size < size; ++id)
+  {
+    appendf (b, "\nservice-%zu: {\n", id);
+    appends (b, "  # Internal address.\n");
+    appends (b, "  #\n");
+    appendf (b,
+             "  host: '10.0.%" PRIu32 ".%" PRIu32 "'\n",
+             rnd (&s) % 256,
+             rnd (&s) % 256);
+    appendf (b, "  port: 0x%" PRIX32 "\n", rnd_range (&s, 1024, 65535));
+    appendf (b, "  connection-timeout: +%" PRIu32 ".5\n", rnd (&s) % 120);
+    appendf (b, "  ratio: .%02" PRIu32 "\n", rnd (&s) % 100);
+    appends (b,
+             "  limit: Infinity\n"
+             "  enabled: true\n"
+             "  log-level: 'info' // Or 'debug'.\n"
+             "  tags: [\n"
+             "    '");
+    append_words (b, &s, 1, false);
+    appends (b, "'\n    '");
+    append_words (b, &s, 1, false);
+    appends (b, "'\n  ]\n");
+    appends (b, "}\n");
+  }
+}
+
+// Remove whitespace outside strings, except newlines if requested.
+//
+static void
+minify (struct buffer *b, bool newlines)
+{
+  size_t j = 0;
+  bool str = false;
+
+  for (size_t i = 0; i != b->size; ++i)
+  {
+    char c = b->data[i];
+
+    if (str)
+    {
+      if (c == '\\')
+      {
+        b->data[j++] = c;
+        c = b->data[++i];
+      }
+      else if (c == '"')
+        str = false;
+    }
+    else if (c == '"')
+      str = true;
+    else if (c == ' ' || c == '\t' || c == '\r' || (c == '\n' && !newlines))
+      continue;
+
+    b->data[j++] = c;
   }
 
-  // Assemble the input out of the fragments.
+  b->size = j;
+}
+
+struct corpus
+{
+  const char *name;
+  void (*generate) (struct buffer *, size_t);
+  enum pdjson_language language;
+  bool streaming;
+};
+
+static const struct corpus corpora[] = {
+  {"fragment", &generate_fragment, PDJSON_LANGUAGE_JSON,   false},
+  {"nested",   &generate_nested,   PDJSON_LANGUAGE_JSON,   false},
+  {"strings",  &generate_strings,  PDJSON_LANGUAGE_JSON,   false},
+  {"numbers",  &generate_numbers,  PDJSON_LANGUAGE_JSON,   false},
+  {"unicode",  &generate_unicode,  PDJSON_LANGUAGE_JSON,   false},
+  {"ndjson",   &generate_ndjson,   PDJSON_LANGUAGE_JSON,   true},
+  {"json5",    &generate_json5,    PDJSON_LANGUAGE_JSON5,  false},
+  {"json5e",   &generate_json5e,   PDJSON_LANGUAGE_JSON5E, false}};
+
+// Timing and reporting.
+//
+static uint64_t
+now (void)
+{
+#ifndef _WIN32
+  struct timespec t;
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000 + (uint64_t)t.tv_nsec;
+#else
+  static LARGE_INTEGER f;
+  LARGE_INTEGER c;
+
+  if (f.QuadPart == 0)
+    QueryPerformanceFrequency (&f);
+
+  QueryPerformanceCounter (&c);
+  return (uint64_t)((double)c.QuadPart * 1e9 / (double)f.QuadPart);
+#endif
+}
+
+static int
+compare_times (const void *x, const void *y)
+{
+  uint64_t a = *(const uint64_t *)x;
+  uint64_t b = *(const uint64_t *)y;
+  return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static void
+print_time (const char *what, uint64_t ns, size_t size, uint64_t events)
+{
+  double s = (ns != 0 ? ns : 1) / 1e9;
+
+  printf ("  %-6s %10.2f MB/s %10.2f Mevents/s %8.2f ns/event\n",
+          what,
+          size / s / 1e6,
+          events / s / 1e6,
+          events != 0 ? (double)ns / events : 0.0);
+}
+
+// Hardware performance counters.
+//
+#define COUNTERS 5
+
+static const char *const counter_names[COUNTERS] = {
+  "cycles", "instructions", "branch-misses", "L1d-misses", "LLC-misses"};
+
+struct counters
+{
+  int fd[COUNTERS]; // -1 if unavailable.
+  double value[COUNTERS];
+};
+
+// Open the counters returning false if none are available.
+//
+static bool
+counters_open (struct counters *c)
+{
+  bool r = false;
+  int e = 0;
+
+  for (size_t i = 0; i != COUNTERS; ++i)
+  {
+    c->fd[i] = -1;
+    c->value[i] = 0;
+
+#ifdef __linux__
+    static const struct
+    {
+      uint32_t type;
+      uint64_t config;
+    } events[COUNTERS] = {
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+      {PERF_TYPE_HW_CACHE, (PERF_COUNT_HW_CACHE_L1D |
+                            PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                            PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}};
+
+    struct perf_event_attr a;
+    memset (&a, 0, sizeof (a));
+    a.size = sizeof (a);
+    a.type = events[i].type;
+    a.config = events[i].config;
+    a.disabled = 1;
+    a.exclude_kernel = 1;
+    a.exclude_hv = 1;
+
+    // Scale the values if the counters get multiplexed.
+    //
+    a.read_format = (PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING);
+
+    long fd = syscall (SYS_perf_event_open, &a, 0, -1, -1, 0);
+
+    if (fd != -1)
+    {
+      c->fd[i] = (int)fd;
+      r = true;
+    }
+    else if (e == 0)
+      e = errno;
+#endif
+  }
+
+  // Only warn once.
   //
+  static bool warned = false;
+
+  if (!r && !warned)
   {
-    size_t p = 0;
+#ifdef __linux__
+    fprintf (stderr,
+             "warning: hardware counters unavailable: %s\n",
+             strerror (e));
+#else
+    fprintf (stderr, "warning: hardware counters only supported on Linux\n");
+#endif
+    warned = true;
+  }
 
-    strcpy (buf.data + p, "{\n");
-    p += 2;
+  return r;
+}
 
-    for (size_t i = 0; i != size * 2; ++i)
+static void
+counters_enable (struct counters *c, bool enable)
+{
+#ifdef __linux__
+  for (size_t i = 0; i != COUNTERS; ++i)
+  {
+    if (c->fd[i] != -1)
+      ioctl (c->fd[i],
+             enable ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE,
+             0);
+  }
+#else
+  (void)c;
+  (void)enable;
+#endif
+}
+
+// Read the counter values and close the counters. If a value cannot be
+// read, then the counter is considered unavailable.
+//
+static void
+counters_close (struct counters *c)
+{
+#ifdef __linux__
+  for (size_t i = 0; i != COUNTERS; ++i)
+  {
+    if (c->fd[i] == -1)
+      continue;
+
+    uint64_t v[3]; // Value, time enabled, time running.
+    if (read (c->fd[i], v, sizeof (v)) == (ssize_t)sizeof (v) && v[2] != 0)
+      c->value[i] = (double)v[0] * ((double)v[1] / (double)v[2]);
+    else
     {
-      if (i != 0)
+      close (c->fd[i]);
+      c->fd[i] = -1;
+      continue;
+    }
+
+    close (c->fd[i]);
+  }
+#else
+  (void)c;
+#endif
+}
+
+// Print the counter values per iteration as well as per byte.
+//
+static void
+print_counters (const struct counters *c, uint64_t iter, size_t size)
+{
+  printf ("  counters (per iteration):\n");
+
+  for (size_t i = 0; i != COUNTERS; ++i)
+  {
+    if (c->fd[i] == -1)
+    {
+      printf ("    %-13s %14s\n", counter_names[i], "n/a");
+      continue;
+    }
+
+    double v = c->value[i] / iter;
+    printf ("    %-13s %14.0f %10.4f/byte", counter_names[i], v, v / size);
+
+    // Instructions per cycle.
+    //
+    if (i == 1 && c->fd[0] != -1 && c->value[0] != 0)
+      printf (" %8.2f/cycle", c->value[1] / c->value[0]);
+
+    printf ("\n");
+  }
+}
+
+enum source
+{
+  source_buffer,
+  source_stdio,
+  source_userio
+};
+
+static const char *const source_names[] = {"buffer", "stdio", "userio"};
+
+static const char *const language_names[] = {"json", "json5", "json5e"};
+
+struct options
+{
+  uint64_t iter;
+  uint64_t warmup;
+  size_t read_ahead;
+  size_t batch;
+  bool validate;
+  bool report;
+  bool counters;
+};
+
+// Parse the entire input (all the values in the streaming mode), counting
+// the events if requested. Return PDJSON_DONE or PDJSON_ERROR.
+//
+static enum pdjson_type
+parse (pdjson_stream *json,
+       const struct options *o,
+       bool streaming,
+       pdjson_event *events,
+       uint64_t *count)
+{
+  enum pdjson_type t;
+
+  if (o->validate && count == NULL)
+    return pdjson_validate (json, NULL) ? PDJSON_DONE : PDJSON_ERROR;
+
+  // In the streaming mode the end of input is indicated by a value without
+  // any events.
+  //
+  for (;;)
+  {
+    uint64_t n = 0;
+
+    if (o->batch != 0 && count == NULL)
+    {
+      do
       {
-        strcpy (buf.data + p, ",\n");
-        p += 2;
+        size_t m = pdjson_next_batch (json, events, o->batch);
+        t = events[m - 1].type;
+        n += m;
       }
+      while (t != PDJSON_DONE && t != PDJSON_ERROR);
 
-      strcpy (buf.data + p, json_fragment);
-      p += sizeof (json_fragment) - 1;
+      n--; // PDJSON_DONE
     }
+    else
+    {
+      while ((t = pdjson_next (json)) != PDJSON_DONE && t != PDJSON_ERROR)
+        n++;
+    }
+
+    if (count != NULL)
+      *count += n;
 
-    strcpy (buf.data + p, "\n}");
-    p += 3;
+    if (!streaming || t == PDJSON_ERROR || n == 0)
+      break;
 
-    assert (p == buf.size);
-    buf.size--; // '\0'
+    pdjson_reset (json);
   }
 
+  return t;
+}
+
+static int
+run (const struct options *o,
+     const struct corpus *c,
+     bool minified,
+     enum source src,
+     enum pdjson_language language,
+     struct buffer *buf)
+{
   FILE *mstream = NULL;
-  if (stdio)
+  if (src == source_stdio)
   {
 #ifndef _WIN32
-    mstream = fmemopen (buf.data, buf.size, "r");
+    mstream = fmemopen (buf->data, buf->size, "r");
     if (mstream == NULL)
     {
       fprintf (stderr, "error: unable to open stdio memory stream\n");
@@ -191,15 +915,56 @@ main (int argc, char *argv[])
 #endif
   }
 
+  pdjson_event *events = NULL;
+  if (o->batch != 0)
+  {
+    events = (pdjson_event *)malloc (o->batch * sizeof (pdjson_event));
+
+    if (events == NULL)
+    {
+      fprintf (stderr, "error: unable to allocate %zu events\n", o->batch);
+      return 1;
+    }
+  }
+
+  uint64_t *times = NULL;
+  if (o->report)
+  {
+    times = (uint64_t *)malloc (o->iter * sizeof (uint64_t));
+
+    if (times == NULL)
+    {
+      fprintf (stderr, "error: unable to allocate %" PRIu64 " times\n",
+               o->iter);
+      return 1;
+    }
+  }
+
   pdjson_stream json[1];
 
   pdjson_open_null (json);
   pdjson_set_language (json, language);
+  pdjson_set_read_ahead (json, o->read_ahead);
+  pdjson_set_streaming (json, c->streaming);
+
+  struct counters cs;
+  bool counters = o->counters && counters_open (&cs);
+
+  // Count the events with a separate pass over the buffer.
+  //
+  uint64_t count = 0;
+  enum pdjson_type t = PDJSON_DONE;
+  if (o->report)
+  {
+    pdjson_reopen_buffer (json, buf->data, buf->size);
+    t = parse (json, o, c->streaming, events, &count);
+  }
 
-  enum pdjson_type t = PDJSON_ERROR;
-  for (uint64_t i = 0; i != iter; ++i)
+  for (uint64_t i = 0, n = o->warmup + o->iter;
+       i != n && t != PDJSON_ERROR;
+       ++i)
   {
-    if (stdio)
+    if (src == source_stdio)
     {
       if (fseek (mstream, 0, SEEK_SET) != 0)
       {
@@ -209,19 +974,38 @@ main (int argc, char *argv[])
 
       pdjson_reopen_stream (json, mstream);
     }
-    else if (userio)
+    else if (src == source_userio)
     {
-      pdjson_user_io io = {&io_peek, &io_get, &io_error};
-      buf.pos = 0;
-      pdjson_reopen_user (json, &io, &buf);
+      pdjson_user_io io = {&io_peek, &io_get, &io_error, &io_read};
+      buf->pos = 0;
+      pdjson_reopen_user (json, &io, buf);
     }
     else
-      pdjson_reopen_buffer (json, buf.data, buf.size);
+      pdjson_reopen_buffer (json, buf->data, buf->size);
+
+    bool timed = o->report && i >= o->warmup;
+
+    if (timed && counters)
+      counters_enable (&cs, true);
+
+    uint64_t s = o->report ? now () : 0;
+
+    t = parse (json, o, c->streaming, events, NULL);
+
+    if (timed)
+    {
+      times[i - o->warmup] = now () - s;
 
-    while ((t = pdjson_next (json)) != PDJSON_DONE && t != PDJSON_ERROR)
-      ;
+      if (counters)
+        counters_enable (&cs, false);
+    }
   }
 
+  if (counters)
+    counters_close (&cs);
+
+  free (events);
+
   int r = 0;
   if (t == PDJSON_ERROR)
   {
@@ -232,13 +1016,259 @@ main (int argc, char *argv[])
              pdjson_get_error (json));
     r = 1;
   }
+  else if (o->report)
+  {
+    uint64_t n = o->iter;
+    qsort (times, n, sizeof (uint64_t), &compare_times);
+
+    printf ("%s%s/%s/%s: %zu bytes, %" PRIu64 " events, %" PRIu64
+            " iterations\n",
+            c->name,
+            minified ? "-minified" : "",
+            language_names[language],
+            source_names[src],
+            buf->size,
+            count,
+            n);
+
+    print_time ("median", times[(n - 1) / 2], buf->size, count);
+    print_time ("p99", times[(n * 99 + 99) / 100 - 1], buf->size, count);
+
+    if (counters)
+      print_counters (&cs, n, buf->size);
+  }
+
+  free (times);
 
   pdjson_close (json);
 
   if (mstream != NULL)
     fclose (mstream);
 
+  return r;
+}
+
+// Generate the corpus and, unless dumping it, run the benchmark with the
+// specified sources.
+//
+static int
+run_corpus (const struct options *o,
+            const struct corpus *c,
+            size_t size,
+            bool minified,
+            const enum source *srcs,
+            size_t srcs_size,
+            enum pdjson_language language,
+            bool dump)
+{
+  struct buffer buf = {NULL, 0, 0, 0};
+  c->generate (&buf, size * 1024);
+
+  if (minified)
+    minify (&buf, c->streaming);
+
+  int r = 0;
+  if (dump)
+  {
+    if (fwrite (buf.data, 1, buf.size, stdout) != buf.size)
+      r = 1;
+  }
+  else
+  {
+    if (language < c->language)
+      language = c->language;
+
+    for (size_t i = 0; i != srcs_size && r == 0; ++i)
+      r = run (o, c, minified, srcs[i], language, &buf);
+  }
+
   free (buf.data);
+  return r;
+}
+
+int
+main (int argc, char *argv[])
+{
+  assert (sizeof (json_fragment) == 511); // Includes \0, so 510.
+
+  struct options o = {10, UINT64_MAX, 0, 0, false, false, false};
+  size_t size = 10;
+  const struct corpus *corpus = corpora;
+  bool minified = false;
+  bool stdio = false;
+  bool userio = false;
+  bool suite = false;
+  bool dump = false;
+  enum pdjson_language language = PDJSON_LANGUAGE_JSON;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const char* a = argv[i];
+
+    if (strcmp (a, "--size") == 0)
+    {
+      if (++i < argc)
+      {
+        errno = 0;
+        size = (size_t)strtoull (argv[i], NULL, 10);
+        if (errno == 0 && size != 0)
+          continue;
+      }
+
+      fprintf (stderr, "error: missing or invalid --size argument\n");
+      return 1;
+    }
+    else if (strcmp (a, "--iteration") == 0)
+    {
+      if (++i < argc)
+      {
+        errno = 0;
+        o.iter = strtoull (argv[i], NULL, 10);
+        if (errno == 0 && o.iter != 0)
+          continue;
+      }
+
+      fprintf (stderr, "error: missing or invalid --iteration argument\n");
+      return 1;
+    }
+    else if (strcmp (a, "--warmup") == 0)
+    {
+      if (++i < argc)
+      {
+        errno = 0;
+        o.warmup = strtoull (argv[i], NULL, 10);
+        if (errno == 0 && o.warmup != UINT64_MAX)
+          continue;
+      }
+
+      fprintf (stderr, "error: missing or invalid --warmup argument\n");
+      return 1;
+    }
+    else if (strcmp (a, "--corpus") == 0)
+    {
+      if (++i < argc)
+      {
+        corpus = NULL;
+        for (size_t j = 0; j != sizeof (corpora) / sizeof (corpora[0]); ++j)
+        {
+          if (strcmp (argv[i], corpora[j].name) == 0)
+            corpus = corpora + j;
+        }
+
+        if (corpus != NULL)
+          continue;
+      }
+
+      fprintf (stderr, "error: missing or invalid --corpus argument\n");
+      return 1;
+    }
+    else if (strcmp (a, "--read-ahead") == 0)
+    {
+      if (++i < argc)
+      {
+        errno = 0;
+        o.read_ahead = (size_t)strtoull (argv[i], NULL, 10);
+        if (errno == 0 && o.read_ahead != 0)
+          continue;
+      }
+
+      fprintf (stderr, "error: missing or invalid --read-ahead argument\n");
+      return 1;
+    }
+    else if (strcmp (a, "--batch") == 0)
+    {
+      if (++i < argc)
+      {
+        errno = 0;
+        o.batch = (size_t)strtoull (argv[i], NULL, 10);
+        if (errno == 0 && o.batch != 0)
+          continue;
+      }
+
+      fprintf (stderr, "error: missing or invalid --batch argument\n");
+      return 1;
+    }
+    else if (strcmp (a, "--minify") == 0)
+      minified = true;
+    else if (strcmp (a, "--validate") == 0)
+      o.validate = true;
+    else if (strcmp (a, "--stdio") == 0)
+      stdio = true;
+    else if (strcmp (a, "--userio") == 0)
+      userio = true;
+    else if (strcmp (a, "--json5") == 0)
+      language = PDJSON_LANGUAGE_JSON5;
+    else if (strcmp (a, "--json5e") == 0)
+      language = PDJSON_LANGUAGE_JSON5E;
+    else if (strcmp (a, "--report") == 0)
+      o.report = true;
+    else if (strcmp (a, "--suite") == 0)
+      suite = o.report = true;
+    else if (strcmp (a, "--counters") == 0)
+      o.counters = o.report = true;
+    else if (strcmp (a, "--dump") == 0)
+      dump = true;
+    else
+    {
+      fprintf (stderr, "error: unexpected argument '%s'\n", a);
+      return 1;
+    }
+  }
+
+  if (stdio && userio)
+  {
+    fprintf (stderr, "error: both --stdio and --userio specified\n");
+    return 1;
+  }
+
+  if (o.warmup == UINT64_MAX)
+    o.warmup = o.report ? 1 : 0;
+
+  if (!suite)
+  {
+    // JSON5 and JSON5E rely on whitespace (comments, newline separators).
+    //
+    if (minified && corpus->language != PDJSON_LANGUAGE_JSON)
+    {
+      fprintf (stderr, "error: %s corpus cannot be minified\n", corpus->name);
+      return 1;
+    }
+
+    enum source src = (stdio  ? source_stdio  :
+                       userio ? source_userio : source_buffer);
+
+    return run_corpus (&o, corpus, size, minified, &src, 1, language, dump);
+  }
+
+  static const enum source srcs[] = {
+    source_buffer,
+#ifndef _WIN32
+    source_stdio,
+#endif
+    source_userio};
+
+  int r = 0;
+  for (size_t i = 0;
+       i != sizeof (corpora) / sizeof (corpora[0]) && r == 0;
+       ++i)
+  {
+    const struct corpus *c = corpora + i;
+
+    for (int m = 0; m != (c->language == PDJSON_LANGUAGE_JSON ? 2 : 1); ++m)
+    {
+      r = run_corpus (&o,
+                      c,
+                      size,
+                      m != 0,
+                      srcs,
+                      sizeof (srcs) / sizeof (srcs[0]),
+                      language,
+                      dump);
+
+      if (r != 0)
+        break;
+    }
+  }
 
   return r;
 }
@@ -0,0 +1,306 @@
+// Usage: driver [<options>] [<query>...]
+//
+// Index the stdin values, save the index to a temporary file and load it
+// back, then for each query parse the blocks that may contain a match and
+// print the number of matching records in each. The query is k:<name>,
+// s:<string>, n:<number>, true, false, or null.
+//
+// --block <n>       --  number of records per block (2 by default)
+// --filter-size <n> --  filter size in bytes (16 by default)
+// --values <n>      --  index values no longer than this size
+// --dump            --  print all the index blocks
+// --json5           --  accept JSON5 input
+// --json5e          --  accept JSON5E input
+//
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h> // strtoull(), realloc(), free()
+#include <string.h> // str*(), mem*()
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h> // PR*
+
+#include <libpdjson5/pdjson5.h>
+#include <libpdjson5/pdjson5-record-index.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+static bool
+parse_size (int argc, char *argv[], int *i, size_t *r)
+{
+  if (++*i < argc)
+  {
+    errno = 0;
+    *r = (size_t)strtoull (argv[*i], NULL, 10);
+    return errno == 0;
+  }
+
+  return false;
+}
+
+static void
+print_block (const struct pdjson_record_block *b)
+{
+  printf ("records %" PRIu64 "-%" PRIu64 " at %" PRIu64 ",%" PRIu64 ",%"
+          PRIu64,
+          b->record,
+          b->record + b->count - 1,
+          b->start.position,
+          b->start.line,
+          b->start.column);
+}
+
+// Return true if the event matches the query.
+//
+static bool
+match (pdjson_stream *json,
+       enum pdjson_type t,
+       enum pdjson_type qt,
+       const char *qv,
+       size_t qn)
+{
+  if (t != qt)
+    return false;
+
+  size_t n;
+  const char *v;
+  switch (t)
+  {
+  case PDJSON_NAME:   v = pdjson_get_name (json, &n); break;
+  case PDJSON_STRING:
+  case PDJSON_NUMBER: v = pdjson_get_value (json, &n); break;
+  default:            return true;
+  }
+
+  return n - 1 == qn && memcmp (v, qv, qn) == 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  size_t block_records = 2;
+  size_t filter_size = 16;
+  size_t value_size = 0;
+  bool dump = false;
+  enum pdjson_language language = PDJSON_LANGUAGE_JSON;
+
+  int i = 1;
+  for (; i < argc; ++i)
+  {
+    const char* a = argv[i];
+
+    if (strcmp (a, "--block") == 0)
+    {
+      if (!parse_size (argc, argv, &i, &block_records))
+      {
+        fprintf (stderr, "error: missing or invalid --block argument\n");
+        return 1;
+      }
+    }
+    else if (strcmp (a, "--filter-size") == 0)
+    {
+      if (!parse_size (argc, argv, &i, &filter_size))
+      {
+        fprintf (stderr,
+                 "error: missing or invalid --filter-size argument\n");
+        return 1;
+      }
+    }
+    else if (strcmp (a, "--values") == 0)
+    {
+      if (!parse_size (argc, argv, &i, &value_size))
+      {
+        fprintf (stderr, "error: missing or invalid --values argument\n");
+        return 1;
+      }
+    }
+    else if (strcmp (a, "--dump") == 0)
+      dump = true;
+    else if (strcmp (a, "--json5") == 0)
+      language = PDJSON_LANGUAGE_JSON5;
+    else if (strcmp (a, "--json5e") == 0)
+      language = PDJSON_LANGUAGE_JSON5E;
+    else if (a[0] != '-')
+      break;
+    else
+    {
+      fprintf (stderr, "error: unexpected argument '%s'\n", a);
+      return 1;
+    }
+  }
+
+  // Read the input into the buffer.
+  //
+  char *buf = NULL;
+  size_t size = 0;
+  {
+    size_t n, capacity = 0;
+    do
+    {
+      if (size == capacity)
+      {
+        capacity = capacity == 0 ? 4096 : capacity * 2;
+        buf = (char *)realloc (buf, capacity);
+        assert (buf != NULL);
+      }
+
+      n = fread (buf + size, 1, capacity - size, stdin);
+      size += n;
+    }
+    while (n != 0);
+  }
+
+  // Build the index and save it to a temporary file.
+  //
+  FILE *f = tmpfile ();
+  assert (f != NULL);
+  {
+    pdjson_stream json[1];
+    pdjson_open_buffer (json, buf, size);
+    pdjson_set_streaming (json, true);
+    pdjson_set_language (json, language);
+
+    pdjson_record_index x;
+    bool r = pdjson_record_index_build (&x,
+                                        json,
+                                        block_records,
+                                        filter_size,
+                                        value_size);
+
+    if (!r)
+    {
+      const char *e = pdjson_record_index_get_error (&x);
+
+      fprintf (stderr,
+               "<stdin>:%" PRIu64 ":%" PRIu64 ": error: %s\n",
+               pdjson_get_line (json),
+               pdjson_get_column (json),
+               e != NULL ? e : pdjson_get_error (json));
+    }
+    else
+      r = pdjson_record_index_write (&x, f);
+
+    pdjson_record_index_free (&x);
+    pdjson_close (json);
+
+    if (!r)
+    {
+      fclose (f);
+      free (buf);
+      return 1;
+    }
+  }
+
+  // Load the index back.
+  //
+  rewind (f);
+
+  pdjson_record_index x;
+  bool r = pdjson_record_index_read (&x, f, NULL, NULL);
+  fclose (f);
+
+  if (!r)
+  {
+    fprintf (stderr, "error: %s\n", pdjson_record_index_get_error (&x));
+    pdjson_record_index_free (&x);
+    free (buf);
+    return 1;
+  }
+
+  if (dump)
+  {
+    for (size_t j = 0; j != x.blocks_size; ++j)
+    {
+      printf ("block %zu: ", j);
+      print_block (x.blocks + j);
+      printf ("\n");
+    }
+  }
+
+  // Run the queries.
+  //
+  int rc = 0;
+  for (; i < argc; ++i)
+  {
+    const char *q = argv[i];
+
+    enum pdjson_type qt;
+    const char *qv = "";
+    if      (strncmp (q, "k:", 2) == 0) {qt = PDJSON_NAME;   qv = q + 2;}
+    else if (strncmp (q, "s:", 2) == 0) {qt = PDJSON_STRING; qv = q + 2;}
+    else if (strncmp (q, "n:", 2) == 0) {qt = PDJSON_NUMBER; qv = q + 2;}
+    else if (strcmp (q, "true") == 0)   qt = PDJSON_TRUE;
+    else if (strcmp (q, "false") == 0)  qt = PDJSON_FALSE;
+    else if (strcmp (q, "null") == 0)   qt = PDJSON_NULL;
+    else
+    {
+      fprintf (stderr, "error: invalid query '%s'\n", q);
+      rc = 1;
+      break;
+    }
+
+    size_t qn = strlen (qv);
+    size_t skipped = 0;
+
+    for (size_t b = 0;; ++b)
+    {
+      size_t c = pdjson_record_index_find (&x, b, qt, qv, qn);
+      skipped += c - b;
+
+      if ((b = c) == x.blocks_size)
+        break;
+
+      // Parse the block records counting those that match.
+      //
+      const struct pdjson_record_block *blk = x.blocks + b;
+      size_t p = (size_t)blk->start.position;
+
+      pdjson_stream json[1];
+      pdjson_open_buffer (json, buf + p, size - p);
+      r = pdjson_resume (json, &blk->start);
+      assert (r);
+
+      uint64_t matches = 0;
+      enum pdjson_type t = PDJSON_DONE;
+      for (uint64_t k = 0; k != blk->count; ++k)
+      {
+        bool m = false;
+        while ((t = pdjson_next (json)) != PDJSON_DONE && t != PDJSON_ERROR)
+          m = m || match (json, t, qt, qv, qn);
+
+        if (t == PDJSON_ERROR)
+          break;
+
+        if (m)
+          matches++;
+
+        pdjson_reset (json);
+      }
+
+      printf ("%s: block %zu: ", q, b);
+      print_block (blk);
+      printf (": %" PRIu64 " match(es)\n", matches);
+
+      if (t == PDJSON_ERROR)
+      {
+        fprintf (stderr,
+                 "<stdin>:%" PRIu64 ":%" PRIu64 ": error: %s\n",
+                 pdjson_get_line (json),
+                 pdjson_get_column (json),
+                 pdjson_get_error (json));
+        rc = 1;
+      }
+
+      pdjson_close (json);
+    }
+
+    printf ("%s: %zu block(s) skipped\n", q, skipped);
+  }
+
+  pdjson_record_index_free (&x);
+  free (buf);
+
+  return rc;
+}
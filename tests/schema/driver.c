@@ -0,0 +1,141 @@
+// Usage: driver [<options>] <schema>
+//
+// Validate stdin against the schema specified as a command line argument.
+//
+// --streaming      --  enable streaming mode
+// --json5          --  accept JSON5 input (including schema)
+// --json5e         --  accept JSON5E input (including schema)
+//
+
+#include <stdio.h>
+#include <string.h> // str*()
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h> // PR*
+
+#include <libpdjson5/pdjson5.h>
+#include <libpdjson5/pdjson5-schema.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+int
+main (int argc, char *argv[])
+{
+  bool streaming = false;
+  const char *schema_text = NULL;
+  enum pdjson_language language = PDJSON_LANGUAGE_JSON;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const char* a = argv[i];
+
+    if (strcmp (a, "--streaming") == 0)
+      streaming = true;
+    else if (strcmp (a, "--json5") == 0)
+      language = PDJSON_LANGUAGE_JSON5;
+    else if (strcmp (a, "--json5e") == 0)
+      language = PDJSON_LANGUAGE_JSON5E;
+    else if (a[0] != '-' && schema_text == NULL)
+      schema_text = a;
+    else
+    {
+      fprintf (stderr, "error: unexpected argument '%s'\n", a);
+      return 1;
+    }
+  }
+
+  if (schema_text == NULL)
+  {
+    fprintf (stderr, "error: missing schema\n");
+    return 1;
+  }
+
+  // Compile the schema.
+  //
+  pdjson_schema schema;
+  {
+    pdjson_stream json[1];
+    pdjson_open_string (json, schema_text);
+    pdjson_set_language (json, language);
+
+    bool r = pdjson_schema_compile (&schema, json);
+
+    if (r && pdjson_next (json) != PDJSON_DONE)
+    {
+      fprintf (stderr, "<schema>: error: %s\n", pdjson_get_error (json));
+      r = false;
+    }
+    else if (!r)
+    {
+      const char *e = pdjson_schema_get_error (&schema);
+
+      fprintf (stderr,
+               "<schema>:%" PRIu64 ":%" PRIu64 ": error: %s\n",
+               pdjson_get_line (json),
+               pdjson_get_column (json),
+               e != NULL ? e : pdjson_get_error (json));
+    }
+
+    pdjson_close (json);
+
+    if (!r)
+    {
+      pdjson_schema_free (&schema);
+      return 1;
+    }
+  }
+
+  // Validate.
+  //
+  pdjson_stream json[1];
+  pdjson_open_stream (json, stdin);
+  pdjson_set_streaming (json, streaming);
+  pdjson_set_language (json, language);
+
+  pdjson_validator validator;
+  pdjson_validator_open (&validator, &schema);
+
+  enum pdjson_type t;
+  for (bool first = true;;)
+  {
+    t = pdjson_validator_next (&validator, json);
+
+    if (t == PDJSON_ERROR)
+      break;
+
+    if (t == PDJSON_DONE)
+    {
+      // Second PDJSON_DONE in the streaming mode is the end.
+      //
+      if (!streaming || first)
+        break;
+
+      pdjson_reset (json);
+      first = true;
+    }
+    else
+      first = false;
+  }
+
+  int r = 0;
+  if (t == PDJSON_ERROR)
+  {
+    const char *e = pdjson_validator_get_error (&validator);
+
+    fprintf (stderr,
+             "<stdin>:%" PRIu64 ":%" PRIu64 ": error: %s\n",
+             pdjson_get_line (json),
+             pdjson_get_column (json),
+             e != NULL ? e : pdjson_get_error (json));
+    r = 1;
+  }
+  else
+    printf ("<valid>\n");
+
+  pdjson_validator_close (&validator);
+  pdjson_close (json);
+  pdjson_schema_free (&schema);
+
+  return r;
+}
@@ -0,0 +1,259 @@
+// Usage: driver [<options>]
+//
+// Parse stdin and print the parsing statistics.
+//
+// --streaming  --  enable streaming mode
+// --peek       --  peek at each event before reading it
+// --skip       --  skip each top-level value with pdjson_skip()
+// --read-ahead <num>
+//              --  read input with user io in read-ahead blocks of num bytes
+// --location <num>
+//              --  set the starting position to num
+// --json5      --  accept JSON5 input
+// --json5e     --  accept JSON5E input
+//
+// Note that this driver includes the library source file in order to enable
+// the statistics. It also reduces the initial name/value buffer size and the
+// nesting stack increment so that their growth is easy to trigger.
+//
+
+#define LIBPDJSON5_STATS
+#define LIBPDJSON5_VALUE_INIT 16
+#define LIBPDJSON5_STACK_INC 2
+
+#include <libpdjson5/pdjson5.c>
+
+#include <stdio.h>
+#include <stdlib.h> // realloc(), free(), strtoull()
+#include <string.h> // strcmp(), memcpy()
+#include <stdbool.h>
+#include <errno.h>
+#include <inttypes.h> // PR*
+
+#undef NDEBUG
+#include <assert.h>
+
+// User io over the input buffer (see --read-ahead).
+//
+struct input
+{
+  const char *data;
+  size_t size;
+  size_t pos;
+};
+
+static int
+input_peek (void *d)
+{
+  struct input *in = (struct input *)d;
+  return in->pos != in->size ? (unsigned char)in->data[in->pos] : EOF;
+}
+
+static int
+input_get (void *d)
+{
+  struct input *in = (struct input *)d;
+  return in->pos != in->size ? (unsigned char)in->data[in->pos++] : EOF;
+}
+
+static size_t
+input_read (void *b, size_t n, void *d)
+{
+  struct input *in = (struct input *)d;
+
+  if (n > in->size - in->pos)
+    n = in->size - in->pos;
+
+  memcpy (b, in->data + in->pos, n);
+  in->pos += n;
+  return n;
+}
+
+static const char *const event_names[] = {
+  NULL,
+  "error",
+  "done",
+  "object",
+  "object_end",
+  "array",
+  "array_end",
+  "name",
+  "string",
+  "number",
+  "true",
+  "false",
+  "null"};
+
+int
+main (int argc, char *argv[])
+{
+  bool streaming = false;
+  bool peek = false;
+  bool skip = false;
+  size_t read_ahead = 0;
+  uint64_t location = 0;
+  enum pdjson_language language = PDJSON_LANGUAGE_JSON;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const char* a = argv[i];
+
+    if (strcmp (a, "--streaming") == 0)
+      streaming = true;
+    else if (strcmp (a, "--peek") == 0)
+      peek = true;
+    else if (strcmp (a, "--skip") == 0)
+      skip = true;
+    else if (strcmp (a, "--read-ahead") == 0)
+    {
+      if (++i < argc)
+      {
+        errno = 0;
+        read_ahead = (size_t)strtoull (argv[i], NULL, 10);
+        if (errno == 0 && read_ahead != 0)
+          continue;
+      }
+
+      fprintf (stderr, "error: missing or invalid --read-ahead argument\n");
+      return 1;
+    }
+    else if (strcmp (a, "--location") == 0)
+    {
+      if (++i < argc)
+      {
+        errno = 0;
+        location = strtoull (argv[i], NULL, 10);
+        if (errno == 0)
+          continue;
+      }
+
+      fprintf (stderr, "error: missing or invalid --location argument\n");
+      return 1;
+    }
+    else if (strcmp (a, "--json5") == 0)
+      language = PDJSON_LANGUAGE_JSON5;
+    else if (strcmp (a, "--json5e") == 0)
+      language = PDJSON_LANGUAGE_JSON5E;
+    else
+    {
+      fprintf (stderr, "error: unexpected argument '%s'\n", a);
+      return 1;
+    }
+  }
+
+  // Read the input into the buffer so that the slow path counts don't
+  // depend on the stdio buffering.
+  //
+  char *buf = NULL;
+  size_t size = 0;
+  {
+    size_t n, capacity = 0;
+    do
+    {
+      if (size == capacity)
+      {
+        capacity = capacity == 0 ? 4096 : capacity * 2;
+        buf = (char *)realloc (buf, capacity);
+        assert (buf != NULL);
+      }
+
+      n = fread (buf + size, 1, capacity - size, stdin);
+      size += n;
+    }
+    while (n != 0);
+  }
+
+  pdjson_stream json[1];
+  struct input in = {buf, size, 0};
+
+  if (read_ahead != 0)
+  {
+    pdjson_user_io io = {&input_peek, &input_get, NULL, &input_read};
+    pdjson_open_user (json, &io, &in);
+    pdjson_set_read_ahead (json, read_ahead);
+  }
+  else
+    pdjson_open_buffer (json, buf, size);
+
+  if (location != 0)
+    pdjson_set_location (json, location, 1, 1);
+
+  pdjson_set_streaming (json, streaming);
+  pdjson_set_language (json, language);
+
+  // In the streaming mode the end of input is indicated by a value without
+  // any events.
+  //
+  int r = 0;
+  for (bool first = true;; first = true)
+  {
+    enum pdjson_type t;
+    if (skip)
+    {
+      if (peek)
+        pdjson_peek (json);
+
+      if ((t = pdjson_skip (json)) != PDJSON_DONE && t != PDJSON_ERROR)
+      {
+        first = false;
+        t = pdjson_next (json);
+      }
+    }
+    else
+    {
+      for (;; first = false)
+      {
+        if (peek)
+          pdjson_peek (json);
+
+        if ((t = pdjson_next (json)) == PDJSON_DONE || t == PDJSON_ERROR)
+          break;
+      }
+    }
+
+    if (t == PDJSON_ERROR)
+    {
+      fprintf (stderr,
+               "<stdin>:%" PRIu64 ":%" PRIu64 ": error: %s\n",
+               pdjson_get_line (json),
+               pdjson_get_column (json),
+               pdjson_get_error (json));
+      r = 1;
+      break;
+    }
+
+    if (!streaming || first)
+      break;
+
+    pdjson_reset (json);
+  }
+
+  pdjson_stats s;
+  bool e = pdjson_get_stats (json, &s);
+  assert (e);
+
+  printf ("bytes: %" PRIu64 "\n", s.bytes);
+
+  printf ("events:");
+  for (size_t i = PDJSON_ERROR; i <= PDJSON_NULL; ++i)
+  {
+    if (s.events[i] != 0)
+      printf (" %s %" PRIu64, event_names[i], s.events[i]);
+  }
+  printf ("\n");
+
+  printf ("max_depth: %zu\n", s.max_depth);
+  printf ("string_bytes: %" PRIu64 "\n", s.string_bytes);
+  printf ("string_grows: %" PRIu64 "\n", s.string_grows);
+  printf ("string_peak: %zu\n", s.string_peak);
+  printf ("stack_grows: %" PRIu64 "\n", s.stack_grows);
+  printf ("slow_gets: %" PRIu64 "\n", s.slow_gets);
+  printf ("slow_peeks: %" PRIu64 "\n", s.slow_peeks);
+  printf ("comment_bytes: %" PRIu64 "\n", s.comment_bytes);
+  printf ("escapes: %" PRIu64 "\n", s.escapes);
+
+  pdjson_close (json);
+  free (buf);
+
+  return r;
+}